@@ -0,0 +1,86 @@
+//===-- GenerationalCache.h -------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_GENERATIONALCACHE_H
+#define KLEE_GENERATIONALCACHE_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+
+namespace klee {
+
+/// GenerationalCache - Bounded cache keeping two generations of at most
+/// \p capacity entries each. Entries found in the previous generation are
+/// promoted to the current one; once the current generation is full, the
+/// previous one is dropped and the current one takes its place. Entries used
+/// since the last rotation thus survive without any per-entry bookkeeping.
+/// A capacity of 0 means no limit.
+///
+/// \p Map holds one generation. lookup() and insert() need a map-like
+/// find(), erase() and insert_or_assign(); containers with other kinds of
+/// lookups, such as MapOfSets, are searched through getCurrent() and
+/// getPrevious() instead.
+template <typename Key, typename Value,
+          typename Map = std::unordered_map<Key, Value>>
+class GenerationalCache {
+  Map current;
+  Map previous;
+  std::size_t capacity;
+
+public:
+  explicit GenerationalCache(std::size_t capacity = 0) : capacity(capacity) {}
+
+  /// Return the value cached for \p key, or nullptr if there is none.
+  Value *lookup(const Key &key) {
+    auto it = current.find(key);
+    if (it != current.end())
+      return &it->second;
+    it = previous.find(key);
+    if (it == previous.end())
+      return nullptr;
+    Value value = std::move(it->second);
+    previous.erase(it);
+    return &insert(key, std::move(value));
+  }
+
+  /// Cache \p value for \p key in the current generation.
+  Value &insert(const Key &key, Value value) {
+    makeRoom();
+    return current.insert_or_assign(key, std::move(value)).first->second;
+  }
+
+  /// Start a new generation if the current one is full. Returns true if a
+  /// generation was dropped.
+  bool makeRoom() {
+    if (!capacity || current.size() < capacity)
+      return false;
+    rotate();
+    return true;
+  }
+
+  /// Drop the previous generation and start a new one.
+  void rotate() {
+    previous = std::move(current);
+    current.clear();
+  }
+
+  Map &getCurrent() { return current; }
+  Map &getPrevious() { return previous; }
+  std::size_t size() const { return current.size() + previous.size(); }
+
+  void clear() {
+    current.clear();
+    previous.clear();
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_GENERATIONALCACHE_H */
@@ -11,6 +11,7 @@
 #define KLEE_IMMUTABLEMAP_H
 
 #include <functional>
+#include <utility>
 
 #include "ImmutableTree.h"
 
@@ -37,12 +38,17 @@ private:
 public:
   ImmutableMap() {}
   ImmutableMap(const ImmutableMap &b) : elts(b.elts) {}
+  ImmutableMap(ImmutableMap &&b) : elts(std::move(b.elts)) {}
   ~ImmutableMap() {}
 
   ImmutableMap &operator=(const ImmutableMap &b) {
     elts = b.elts;
     return *this;
   }
+  ImmutableMap &operator=(ImmutableMap &&b) {
+    elts = std::move(b.elts);
+    return *this;
+  }
 
   bool operator==(const ImmutableMap &b) const {
     if (size() != b.size()) {
@@ -11,6 +11,7 @@
 #define KLEE_IMMUTABLESET_H
 
 #include <functional>
+#include <utility>
 
 #include "ImmutableTree.h"
 
@@ -36,12 +37,17 @@ private:
 public:
   ImmutableSet() {}
   ImmutableSet(const ImmutableSet &b) : elts(b.elts) {}
+  ImmutableSet(ImmutableSet &&b) : elts(std::move(b.elts)) {}
   ~ImmutableSet() {}
 
   ImmutableSet &operator=(const ImmutableSet &b) {
     elts = b.elts;
     return *this;
   }
+  ImmutableSet &operator=(ImmutableSet &&b) {
+    elts = std::move(b.elts);
+    return *this;
+  }
 
   bool empty() const { return elts.empty(); }
   size_t count(const key_type &key) const { return elts.count(key); }
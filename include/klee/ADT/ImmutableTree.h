@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <utility>
 
 namespace klee {
 template <class K, class V, class KOV, class CMP> class ImmutableTree {
@@ -28,9 +29,11 @@ public:
 public:
   ImmutableTree();
   ImmutableTree(const ImmutableTree &s);
+  ImmutableTree(ImmutableTree &&s);
   ~ImmutableTree();
 
   ImmutableTree &operator=(const ImmutableTree &s);
+  ImmutableTree &operator=(ImmutableTree &&s);
 
   bool empty() const;
 
@@ -423,6 +426,12 @@ template <class K, class V, class KOV, class CMP>
 ImmutableTree<K, V, KOV, CMP>::ImmutableTree(const ImmutableTree &s)
     : node(s.node->incref()) {}
 
+template <class K, class V, class KOV, class CMP>
+ImmutableTree<K, V, KOV, CMP>::ImmutableTree(ImmutableTree &&s)
+    : node(s.node) {
+  s.node = Node::terminator.incref();
+}
+
 template <class K, class V, class KOV, class CMP>
 ImmutableTree<K, V, KOV, CMP>::~ImmutableTree() {
   node->decref();
@@ -437,6 +446,14 @@ ImmutableTree<K, V, KOV, CMP>::operator=(const ImmutableTree &s) {
   return *this;
 }
 
+template <class K, class V, class KOV, class CMP>
+ImmutableTree<K, V, KOV, CMP> &
+ImmutableTree<K, V, KOV, CMP>::operator=(ImmutableTree &&s) {
+  // the old tree is released by the destructor of s
+  std::swap(node, s.node);
+  return *this;
+}
+
 template <class K, class V, class KOV, class CMP>
 bool ImmutableTree<K, V, KOV, CMP>::empty() const {
   return node->isTerminator();
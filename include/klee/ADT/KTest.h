@@ -47,6 +47,13 @@ struct KTest {
   unsigned numObjects;
   KTestObject *objects;
   unsigned uninitCoeff;
+
+  /* contents of the file if it was loaded by kTest_fromFileMapped, the
+     object bytes point into it. must be zero in KTests built by hand, as
+     kTest_free uses them to decide how to release the object bytes */
+  void *buffer;
+  uint64_t bufferSize;
+  int bufferIsMapped;
 };
 
 /* returns the current .ktest file format version */
@@ -58,6 +65,13 @@ int kTest_isKTestFile(const char *path);
 /* returns NULL on (unspecified) error */
 KTest *kTest_fromFile(const char *path);
 
+/* like kTest_fromFile, but loads the file as a whole instead of copying
+   each object: object bytes point into the file contents and must not be
+   modified. Large files are mapped read-only; small files, files beyond a
+   limit on live mappings and files that cannot be mapped are read into a
+   single buffer. returns NULL on (unspecified) error */
+KTest *kTest_fromFileMapped(const char *path);
+
 /* returns 1 on success, 0 on (unspecified) error */
 int kTest_toFile(const KTest *, const char *path);
 
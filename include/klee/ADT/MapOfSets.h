@@ -11,6 +11,8 @@
 #define KLEE_MAPOFSETS_H
 
 #include <cassert>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <set>
 #include <vector>
@@ -25,8 +27,12 @@
 namespace klee {
 
 /** This implements the UBTree data structure (see Hoffmann and
-    Koehler, "A New Method to Index and Query Sets", IJCAI 1999) */
-template <class K, class V> class MapOfSets {
+    Koehler, "A New Method to Index and Query Sets", IJCAI 1999).
+
+    Every node also keeps a signature of the elements of the sets stored
+    below it, one bit per element hash, so that superset searches skip
+    subtrees which cannot contain the remaining elements. */
+template <class K, class V, class Hash = std::hash<K>> class MapOfSets {
 public:
   class iterator;
 
@@ -35,6 +41,9 @@ public:
 
   void clear();
 
+  /// Returns the number of sets in the map.
+  unsigned size() const { return numSets; }
+
   void insert(const std::set<K> &set, const V &value);
 
   V *lookup(const std::set<K> &set);
@@ -56,6 +65,13 @@ private:
   class Node;
 
   Node root;
+  unsigned numSets = 0;
+
+  static uint64_t signature(const K &element) {
+    return uint64_t(1) << (Hash()(element) % 64);
+  }
+  /// Returns the signatures of all suffixes of \p set, longest first.
+  static std::vector<uint64_t> suffixSignatures(const std::set<K> &set);
 
   template <class Iterator, class Vector>
   void findSubsets(Node *n, const std::set<K> &accum, Iterator begin,
@@ -65,7 +81,8 @@ private:
                      Iterator end, Vector &resultsOut);
   template <class Predicate>
   V *findSuperset(Node *n, typename std::set<K>::iterator begin,
-                  typename std::set<K>::iterator end, const Predicate &p);
+                  typename std::set<K>::iterator end, const uint64_t *needed,
+                  const Predicate &p);
   template <class Predicate>
   V *findSubset(Node *n, typename std::set<K>::iterator begin,
                 typename std::set<K>::iterator end, const Predicate &p);
@@ -73,9 +90,9 @@ private:
 
 /***/
 
-template <class K, class V> class MapOfSets<K, V>::Node {
-  friend class MapOfSets<K, V>;
-  friend class MapOfSets<K, V>::iterator;
+template <class K, class V, class Hash> class MapOfSets<K, V, Hash>::Node {
+  friend class MapOfSets<K, V, Hash>;
+  friend class MapOfSets<K, V, Hash>::iterator;
 
 public:
   typedef std::map<K, Node> children_ty;
@@ -84,15 +101,17 @@ public:
 
 private:
   bool isEndOfSet;
+  /// signatures of all elements of the sets below this node
+  uint64_t signature;
   std::map<K, Node> children;
 
 public:
-  Node() : value(), isEndOfSet(false) {}
+  Node() : value(), isEndOfSet(false), signature(0) {}
 };
 
-template <class K, class V> class MapOfSets<K, V>::iterator {
+template <class K, class V, class Hash> class MapOfSets<K, V, Hash>::iterator {
   typedef std::vector<typename std::map<K, Node>::iterator> stack_ty;
-  friend class MapOfSets<K, V>;
+  friend class MapOfSets<K, V, Hash>;
 
 private:
   Node *root;
@@ -167,19 +186,36 @@ public:
 
 /***/
 
-template <class K, class V> MapOfSets<K, V>::MapOfSets() {}
+template <class K, class V, class Hash>
+MapOfSets<K, V, Hash>::MapOfSets() {}
+
+template <class K, class V, class Hash>
+std::vector<uint64_t>
+MapOfSets<K, V, Hash>::suffixSignatures(const std::set<K> &set) {
+  std::vector<uint64_t> result(set.size() + 1, 0);
+  unsigned i = set.size();
+  for (auto it = set.rbegin(), ie = set.rend(); it != ie; ++it, --i)
+    result[i - 1] = result[i] | signature(*it);
+  return result;
+}
 
-template <class K, class V>
-void MapOfSets<K, V>::insert(const std::set<K> &set, const V &value) {
+template <class K, class V, class Hash>
+void MapOfSets<K, V, Hash>::insert(const std::set<K> &set, const V &value) {
+  std::vector<uint64_t> suffixes = suffixSignatures(set);
   Node *n = &root;
+  unsigned i = 0;
   for (auto const &element : set) {
+    n->signature |= suffixes[i++];
     n = &n->children.insert(std::make_pair(element, Node())).first->second;
   }
+  if (!n->isEndOfSet)
+    ++numSets;
   n->isEndOfSet = true;
   n->value = value;
 }
 
-template <class K, class V> V *MapOfSets<K, V>::lookup(const std::set<K> &set) {
+template <class K, class V, class Hash>
+V *MapOfSets<K, V, Hash>::lookup(const std::set<K> &set) {
   Node *n = &root;
   for (typename std::set<K>::const_iterator it = set.begin(), ie = set.end();
        it != ie; ++it) {
@@ -197,21 +233,21 @@ template <class K, class V> V *MapOfSets<K, V>::lookup(const std::set<K> &set) {
   }
 }
 
-template <class K, class V>
-typename MapOfSets<K, V>::iterator MapOfSets<K, V>::begin() {
+template <class K, class V, class Hash>
+typename MapOfSets<K, V, Hash>::iterator MapOfSets<K, V, Hash>::begin() {
   return iterator(&root);
 }
 
-template <class K, class V>
-typename MapOfSets<K, V>::iterator MapOfSets<K, V>::end() {
+template <class K, class V, class Hash>
+typename MapOfSets<K, V, Hash>::iterator MapOfSets<K, V, Hash>::end() {
   return iterator();
 }
 
-template <class K, class V>
+template <class K, class V, class Hash>
 template <class Iterator, class Vector>
-void MapOfSets<K, V>::findSubsets(Node *n, const std::set<K> &accum,
-                                  Iterator begin, Iterator end,
-                                  Vector &resultsOut) {
+void MapOfSets<K, V, Hash>::findSubsets(Node *n, const std::set<K> &accum,
+                                        Iterator begin, Iterator end,
+                                        Vector &resultsOut) {
   if (n->isEndOfSet) {
     resultsOut.push_back(std::make_pair(accum, n->value));
   }
@@ -228,17 +264,17 @@ void MapOfSets<K, V>::findSubsets(Node *n, const std::set<K> &accum,
   }
 }
 
-template <class K, class V>
-void MapOfSets<K, V>::subsets(
+template <class K, class V, class Hash>
+void MapOfSets<K, V, Hash>::subsets(
     const std::set<K> &set, std::vector<std::pair<std::set<K>, V>> &resultOut) {
   findSubsets(&root, std::set<K>(), set.begin(), set.end(), resultOut);
 }
 
-template <class K, class V>
+template <class K, class V, class Hash>
 template <class Iterator, class Vector>
-void MapOfSets<K, V>::findSupersets(Node *n, const std::set<K> &accum,
-                                    Iterator begin, Iterator end,
-                                    Vector &resultsOut) {
+void MapOfSets<K, V, Hash>::findSupersets(Node *n, const std::set<K> &accum,
+                                          Iterator begin, Iterator end,
+                                          Vector &resultsOut) {
   if (begin == end) {
     if (n->isEndOfSet)
       resultsOut.push_back(std::make_pair(accum, n->value));
@@ -269,17 +305,18 @@ void MapOfSets<K, V>::findSupersets(Node *n, const std::set<K> &accum,
   }
 }
 
-template <class K, class V>
-void MapOfSets<K, V>::supersets(
+template <class K, class V, class Hash>
+void MapOfSets<K, V, Hash>::supersets(
     const std::set<K> &set, std::vector<std::pair<std::set<K>, V>> &resultOut) {
   findSupersets(&root, std::set<K>(), set.begin(), set.end(), resultOut);
 }
 
-template <class K, class V>
+template <class K, class V, class Hash>
 template <class Predicate>
-V *MapOfSets<K, V>::findSubset(Node *n, typename std::set<K>::iterator begin,
-                               typename std::set<K>::iterator end,
-                               const Predicate &p) {
+V *MapOfSets<K, V, Hash>::findSubset(Node *n,
+                                     typename std::set<K>::iterator begin,
+                                     typename std::set<K>::iterator end,
+                                     const Predicate &p) {
   if (n->isEndOfSet && p(n->value)) {
     return &n->value;
   } else if (begin == end) {
@@ -312,32 +349,38 @@ V *MapOfSets<K, V>::findSubset(Node *n, typename std::set<K>::iterator begin,
   }
 }
 
-template <class K, class V>
+template <class K, class V, class Hash>
 template <class Predicate>
-V *MapOfSets<K, V>::findSuperset(Node *n, typename std::set<K>::iterator begin,
-                                 typename std::set<K>::iterator end,
-                                 const Predicate &p) {
+V *MapOfSets<K, V, Hash>::findSuperset(Node *n,
+                                       typename std::set<K>::iterator begin,
+                                       typename std::set<K>::iterator end,
+                                       const uint64_t *needed,
+                                       const Predicate &p) {
+  // Some remaining element does not occur below n
+  if (*needed & ~n->signature)
+    return 0;
   if (begin == end) {
     if (n->isEndOfSet && p(n->value))
       return &n->value;
     for (typename Node::children_ty::iterator it = n->children.begin(),
                                               ie = n->children.end();
          it != ie; ++it) {
-      V *res = findSuperset(&it->second, begin, end, p);
+      V *res = findSuperset(&it->second, begin, end, needed, p);
       if (res)
         return res;
     }
   } else {
+    // Sets are stored in order, so only children smaller than the next
+    // element can have it below them.
     typename Node::children_ty::iterator kmid = n->children.lower_bound(*begin);
-    for (typename Node::children_ty::iterator it = n->children.begin(),
-                                              ie = n->children.end();
-         it != ie; ++it) {
-      V *res = findSuperset(&it->second, begin, end, p);
+    for (typename Node::children_ty::iterator it = n->children.begin();
+         it != kmid; ++it) {
+      V *res = findSuperset(&it->second, begin, end, needed, p);
       if (res)
         return res;
     }
     if (kmid != n->children.end() && *begin == kmid->first) {
-      V *res = findSuperset(&kmid->second, ++begin, end, p);
+      V *res = findSuperset(&kmid->second, ++begin, end, needed + 1, p);
       if (res)
         return res;
     }
@@ -345,22 +388,28 @@ V *MapOfSets<K, V>::findSuperset(Node *n, typename std::set<K>::iterator begin,
   return 0;
 }
 
-template <class K, class V>
+template <class K, class V, class Hash>
 template <class Predicate>
-V *MapOfSets<K, V>::findSuperset(const std::set<K> &set, const Predicate &p) {
-  return findSuperset(&root, set.begin(), set.end(), p);
+V *MapOfSets<K, V, Hash>::findSuperset(const std::set<K> &set,
+                                       const Predicate &p) {
+  std::vector<uint64_t> suffixes = suffixSignatures(set);
+  return findSuperset(&root, set.begin(), set.end(), suffixes.data(), p);
 }
 
-template <class K, class V>
+template <class K, class V, class Hash>
 template <class Predicate>
-V *MapOfSets<K, V>::findSubset(const std::set<K> &set, const Predicate &p) {
+V *MapOfSets<K, V, Hash>::findSubset(const std::set<K> &set,
+                                     const Predicate &p) {
   return findSubset(&root, set.begin(), set.end(), p);
 }
 
-template <class K, class V> void MapOfSets<K, V>::clear() {
+template <class K, class V, class Hash>
+void MapOfSets<K, V, Hash>::clear() {
   root.isEndOfSet = false;
+  root.signature = 0;
   root.value = V();
   root.children.clear();
+  numSets = 0;
 }
 
 } // namespace klee
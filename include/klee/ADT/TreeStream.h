@@ -10,6 +10,7 @@
 #ifndef KLEE_TREESTREAM_H
 #define KLEE_TREESTREAM_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -18,21 +19,34 @@ namespace klee {
 typedef unsigned TreeStreamID;
 class TreeOStream;
 
+/// TreeStreamWriter logs the data of a tree of streams, where every stream
+/// continues the data its parent had when it was opened. The log is a
+/// sequence of blocks, compressed if zlib is available, each holding records
+/// which are tagged with the delta of their stream id to the previous record.
+/// Runs of '0'/'1' branch characters are packed into bits.
 class TreeStreamWriter {
-  static const unsigned bufferSize = 4 * 4096;
+  static const unsigned blockSize = 4 * 4096;
 
   friend class TreeOStream;
 
 private:
-  char buffer[bufferSize];
-  unsigned lastID, bufferCount;
+  /// Data written to lastID which has not been encoded yet
+  std::vector<char> pending;
+  unsigned lastID;
+  /// Encoded records which have not been written yet
+  std::vector<unsigned char> block;
+  unsigned blockLastID;
 
   std::string path;
   std::ofstream *output;
   unsigned ids;
+  /// Parent of every stream, indexed by id
+  std::vector<TreeStreamID> parents;
 
   void write(TreeOStream &os, const char *s, unsigned size);
-  void flushBuffer();
+  void encodePending();
+  void encodeRecord(TreeStreamID id, uint64_t header);
+  void flushBlock();
 
 public:
   TreeStreamWriter(const std::string &_path);
@@ -117,6 +117,11 @@ public:
     bool AnnotateOnlyExternal;
     bool WithFPRuntime;
     bool WithPOSIXRuntime;
+    /// Directory of the prepared module cache, empty if it is disabled.
+    std::string ModuleCacheDir;
+    /// Command line options which may influence module preparation, as
+    /// part of the module cache key.
+    std::string ModuleCacheOptions;
 
     ModuleOptions(const std::string &_LibraryDir,
                   const std::string &_EntryPoint, const std::string &_OptSuffix,
@@ -209,9 +214,10 @@ public:
   // a user specified path. use null to reset.
   virtual void setReplayPath(const std::vector<bool> *path) = 0;
 
-  // supply a set of symbolic bindings that will be used as "seeds"
-  // for the search. use null to reset.
-  virtual void useSeeds(const std::vector<struct KTest *> *seeds) = 0;
+  // supply a list of .ktest files whose symbolic bindings will be used as
+  // "seeds" for the search. the files are only read when a seed is first
+  // used. use null to reset.
+  virtual void useSeeds(const std::vector<std::string> *seeds) = 0;
 
   virtual void runFunctionAsMain(llvm::Function *f, int argc, char **argv,
                                  char **envp) = 0;
@@ -14,6 +14,8 @@
 #include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprVisitor.h"
 
+#include <vector>
+
 namespace klee {
 
 class AlphaBuilder final : public ExprVisitor {
@@ -25,6 +27,7 @@ public:
 private:
   unsigned index = 0;
   bool reverse = false;
+  std::vector<const Array *> mappedArrays;
 
   const Array *visitArray(const Array *arr);
   UpdateList visitUpdateList(UpdateList u);
@@ -37,6 +40,17 @@ public:
   ref<Expr> build(ref<Expr> v);
   const Array *buildArray(const Array *arr) { return visitArray(arr); }
   ref<Expr> reverseBuild(ref<Expr> v);
+
+  /// Arrays mapped so far, in the order they were first met
+  const std::vector<const Array *> &getMappedArrays() const {
+    return mappedArrays;
+  }
+  unsigned getIndex() const { return index; }
+
+  /// Map arr to alpha as if it was met by this builder, so that building can
+  /// resume from an earlier state of another builder. \p newIndex is the
+  /// index of that builder after the mapping.
+  void mapArray(const Array *arr, const Array *alpha, unsigned newIndex);
 };
 
 } // namespace klee
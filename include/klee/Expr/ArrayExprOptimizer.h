@@ -12,6 +12,7 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -28,11 +29,14 @@ using mapIndexOptimizedExpr_ty = std::map<ref<Expr>, std::vector<ref<Expr>>>;
 
 class ExprOptimizer {
 private:
-  ExprHashMap<ref<Expr>> cacheExprOptimized;
-  ExprHashSet cacheExprUnapplicable;
-  ExprHashMap<ref<Expr>> cacheReadExprOptimized;
+  struct Caches;
+  /// Bounded caches of optimized expressions and reads, shared by all
+  /// copies of this optimizer
+  std::shared_ptr<Caches> caches;
 
 public:
+  ExprOptimizer();
+
   /// Returns the optimised version of e.
   /// @param e expression to optimise
   /// @param valueOnly XXX document
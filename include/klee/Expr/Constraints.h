@@ -12,6 +12,7 @@
 
 #include "klee/ADT/Ref.h"
 
+#include "klee/ADT/PersistentHashMap.h"
 #include "klee/ADT/PersistentMap.h"
 #include "klee/Expr/Assignment.h"
 #include "klee/Expr/Expr.h"
@@ -19,8 +20,12 @@
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/IndependentSet.h"
 #include "klee/Expr/Path.h"
+#include "klee/Expr/RangeIndex.h"
 #include "klee/Expr/Symcrete.h"
 
+#include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 namespace klee {
@@ -29,10 +34,42 @@ enum class RewriteEqualitiesPolicy { None, Simple, Full };
 
 class MemoryObject;
 struct KInstruction;
+struct SimplificationMemo;
+
+/// Rewrites applied by Simplificator::simplifyExpr for a set of constraints:
+/// each constraint is replaced by true, the operand of a negated constraint
+/// by false and the larger side of an equality by its smaller side. The
+/// index is persistent, so copies made on forks share it, and it is updated
+/// per constraint instead of being rebuilt for every simplification.
+class RewriteIndex {
+public:
+  using rewrites_ty = PersistentHashMap<ref<Expr>, ref<Expr>, util::ExprHash,
+                                        util::ExprCmp>;
+
+  void add(const ref<Expr> &constraint);
+  void remove(const ref<Expr> &constraint);
+
+  /// Maps an expression to its replacement.
+  const rewrites_ty &equalities() const { return _equalities; }
+  /// Maps an expression to the constraint its replacement comes from.
+  const rewrites_ty &parents() const { return _parents; }
+
+private:
+  /// (constraint, replacement) pairs for one expression, in the order the
+  /// constraints were added. The first pair is the one in effect.
+  using owners_ty = std::vector<std::pair<ref<Expr>, ref<Expr>>>;
+
+  rewrites_ty _equalities;
+  rewrites_ty _parents;
+  PersistentHashMap<ref<Expr>, owners_ty, util::ExprHash, util::ExprCmp>
+      _owners;
+};
 
 /// Resembles a set of constraints that can be passed around
 ///
 class ConstraintSet {
+  friend class Simplificator;
+
 private:
   /// Epoch counter used to control ownership of objects.
   mutable unsigned cowKey;
@@ -42,6 +79,17 @@ private:
   mutable std::shared_ptr<Assignment> _concretization;
   std::shared_ptr<IndependentConstraintSetUnion> _independentElements;
   unsigned copyOnWriteOwner;
+  /// Built on the first simplification and maintained from then on.
+  mutable RewriteIndex _rewrites;
+  mutable bool hasRewrites = false;
+  /// Built on the first range query and maintained from then on. Copies
+  /// share it, also when it is built after the copy, until one of them
+  /// changes its constraints.
+  std::shared_ptr<std::optional<RangeIndex>> _ranges =
+      std::make_shared<std::optional<RangeIndex>>();
+  /// Expressions already simplified against this set. Copies share the memo
+  /// until one of them changes its constraints.
+  mutable std::shared_ptr<SimplificationMemo> _simplified;
 
   void checkCopyOnWriteOwner();
 
@@ -58,7 +106,9 @@ public:
       : cowKey(++b.cowKey), _constraints(b._constraints),
         _symcretes(b._symcretes), _concretization(b._concretization),
         _independentElements(b._independentElements),
-        copyOnWriteOwner(b.copyOnWriteOwner) {}
+        copyOnWriteOwner(b.copyOnWriteOwner), _rewrites(b._rewrites),
+        hasRewrites(b.hasRewrites), _ranges(b._ranges),
+        _simplified(b._simplified) {}
   ConstraintSet &operator=(const ConstraintSet &b) {
     cowKey = ++b.cowKey;
     _constraints = b._constraints;
@@ -66,6 +116,10 @@ public:
     _concretization = b._concretization;
     _independentElements = b._independentElements;
     copyOnWriteOwner = b.copyOnWriteOwner;
+    _rewrites = b._rewrites;
+    hasRewrites = b.hasRewrites;
+    _ranges = b._ranges;
+    _simplified = b._simplified;
     return *this;
   }
 
@@ -102,6 +156,8 @@ public:
   const symcretes_ty &symcretes() const;
   const Assignment &concretization() const;
   const IndependentConstraintSetUnion &independentElements() const;
+  const RewriteIndex &rewrites() const;
+  const RangeIndex &ranges() const;
 
   void getAllIndependentConstraintsSets(
       ref<Expr> queryExpr,
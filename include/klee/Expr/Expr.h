@@ -23,6 +23,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <memory>
 #include <set>
 #include <sstream>
 #include <unordered_set>
@@ -595,6 +596,8 @@ public:
   static bool classof(const NotOptimizedExpr *) { return true; }
 };
 
+struct UpdateSnapshot;
+
 /// Class representing a byte update of an array.
 class UpdateNode {
   friend class UpdateList;
@@ -603,6 +606,17 @@ class UpdateNode {
   unsigned hashValue;
   unsigned heightValue;
 
+  /// number of consecutive updates with a concrete index, starting with this
+  /// one (0 if the index of this update is symbolic)
+  unsigned concreteRun;
+
+  /// index of the concrete updates of the run below (and including) this
+  /// update, built for every few updates of a run so that reads from a
+  /// concrete index do not have to walk the whole run
+  std::shared_ptr<const UpdateSnapshot> snapshot;
+
+  void buildSnapshot();
+
 public:
   const ref<UpdateNode> next;
   ref<Expr> index, value;
@@ -620,6 +634,12 @@ public:
 
   unsigned getSize() const { return size; }
 
+  /// Return the most recent update in this sequence, starting with this one,
+  /// that may write to the concrete \p index: either an update of exactly
+  /// that index or one with a symbolic index. Returns nullptr if there is
+  /// none.
+  UpdateNode *findWrite(uint64_t index);
+
   int compare(const UpdateNode &b) const;
   bool equals(const UpdateNode &b) const;
   unsigned hash() const { return hashValue; }
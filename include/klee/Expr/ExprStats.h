@@ -0,0 +1,25 @@
+//===-- ExprStats.h ---------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_EXPRSTATS_H
+#define KLEE_EXPRSTATS_H
+
+#include "klee/Statistics/Statistic.h"
+
+namespace klee {
+namespace stats {
+
+extern Statistic arrayOptimizationTime;
+extern Statistic simplificationCacheHits;
+extern Statistic simplificationCacheMisses;
+
+} // namespace stats
+} // namespace klee
+
+#endif /* KLEE_EXPRSTATS_H */
@@ -0,0 +1,66 @@
+//===-- RangeIndex.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_RANGEINDEX_H
+#define KLEE_RANGEINDEX_H
+
+#include "klee/ADT/PersistentHashMap.h"
+#include "klee/ADT/Ref.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace klee {
+
+/// Unsigned intervals and known bits implied by a set of constraints.
+/// Comparisons of an expression with a constant, such as `(Ult x 10)`, bound
+/// the compared expression, and equalities of masked values, such as
+/// `(Eq 0 (And x 4))`, fix some of its bits. The values of other expressions
+/// are derived from the values of their operands. Known low bits also decide
+/// congruences modulo powers of two. Only expressions of at most 64 bits are
+/// tracked.
+///
+/// The index is persistent, so copies made on forks share it, and it is
+/// updated per constraint. It is sound but incomplete: a query it cannot
+/// decide still has to go to the solver.
+class RangeIndex {
+public:
+  /// Values in [min, max], both inclusive, that have the bits in `zeros`
+  /// cleared and the bits in `ones` set.
+  struct Range {
+    uint64_t min;
+    uint64_t max;
+    uint64_t zeros = 0;
+    uint64_t ones = 0;
+  };
+
+  using ranges_ty =
+      PersistentHashMap<ref<Expr>, Range, util::ExprHash, util::ExprCmp>;
+
+  void add(const ref<Expr> &constraint);
+
+  /// Returns the bounds of \p e, or nothing if it is wider than 64 bits.
+  std::optional<Range> getRange(const ref<Expr> &e) const;
+  /// Returns the value of the boolean \p e if the bounds decide it.
+  std::optional<bool> evaluate(const ref<Expr> &e) const;
+
+private:
+  /// Records that the boolean \p e has value \p value.
+  void addFact(const ref<Expr> &e, bool value);
+  /// Narrows the bounds of \p e to \p range.
+  void restrict(const ref<Expr> &e, Range range);
+
+  ranges_ty _ranges;
+};
+
+} // namespace klee
+
+#endif /* KLEE_RANGEINDEX_H */
@@ -12,7 +12,10 @@
 
 #include "klee/Module/KModule.h"
 
+#include "llvm/ADT/BitVector.h"
+
 #include <unordered_map>
+#include <vector>
 
 namespace klee {
 
@@ -34,6 +37,13 @@ class CodeGraphInfo {
   using functionBranchesSet =
       std::unordered_map<KFunction *, KBlockMap<std::set<unsigned>>>;
 
+  /// Strongly connected components of the control flow graph of a function
+  /// and, for each component, the components reachable from it
+  struct BlockReachability {
+    std::unordered_map<KBlock *, unsigned> component;
+    std::vector<llvm::BitVector> reachable;
+  };
+
 private:
   blockToDistanceMap blockDistance;
   blockToDistanceMap blockBackwardDistance;
@@ -50,25 +60,41 @@ private:
   functionBranchesSet functionConditionalBranches;
   functionBranchesSet functionBlocks;
 
+  std::unordered_map<KFunction *, BlockReachability> functionReachability;
+
 private:
   void calculateDistance(KBlock *bb);
   void calculateBackwardDistance(KBlock *bb);
 
-  void calculateDistance(KFunction *f);
-  void calculateBackwardDistance(KFunction *f);
+  static void calculateDistance(KFunction *kf, FunctionDistanceMap &dist,
+                                SortedFunctionDistances &sort);
+  static void calculateBackwardDistance(KFunction *kf,
+                                        FunctionDistanceMap &bdist,
+                                        SortedFunctionDistances &bsort);
 
   void calculateFunctionBranches(KFunction *kf);
   void calculateFunctionConditionalBranches(KFunction *kf);
   void calculateFunctionBlocks(KFunction *kf);
+  static void calculateReachability(KFunction *kf,
+                                    BlockReachability &reachability);
 
 public:
   const BlockDistanceMap &getDistance(KBlock *b);
   const BlockDistanceMap &getBackwardDistance(KBlock *kb);
   bool hasCycle(KBlock *kb);
+  /// Returns true if some block of \p to can be reached from some block of
+  /// \p from. All blocks must belong to the same function.
+  bool isReachable(const KBlockSet &from, const KBlockSet &to);
 
   const FunctionDistanceMap &getDistance(KFunction *kf);
   const FunctionDistanceMap &getBackwardDistance(KFunction *kf);
 
+  /// Computes the function distances and the block reachability of \p kfs
+  /// on up to \p numThreads threads (0 means one per hardware thread).
+  /// Afterwards getDistance, getBackwardDistance and isReachable only read
+  /// for these functions and may be called concurrently.
+  void precompute(const KFunctionSet &kfs, unsigned numThreads);
+
   void getNearestPredicateSatisfying(KBlock *from, KBlockPredicate predicate,
                                      KBlockSet &result);
 
@@ -13,6 +13,7 @@
 #include "klee/Core/Interpreter.h"
 #include "klee/Module/KCallable.h"
 #include "klee/Module/KValue.h"
+#include "klee/Module/SourceLocationIndex.h"
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/CFG.h"
@@ -315,6 +316,10 @@ public:
 
   FLCtoOpcode origInstructions;
 
+  // Blocks and instructions by source position, built by manifest in
+  // error-guided mode
+  SourceLocationIndex locationIndex;
+
   std::vector<llvm::Constant *> constants;
   std::unordered_map<const llvm::Constant *, std::unique_ptr<KConstant>>
       constantMap;
@@ -334,6 +339,8 @@ public:
 
   // Mark function with functionName as part of the KLEE runtime
   void addInternalFunction(const char *functionName);
+  // Mark the runtime functions of the enabled checks as internal
+  void addInternalFunctions(const Interpreter::ModuleOptions &opts);
   // Replace std functions with KLEE intrinsics
   void replaceFunction(const std::unique_ptr<llvm::Module> &m,
                        const char *original, const char *replacement);
@@ -345,6 +352,11 @@ public:
   void optimiseAndPrepare(const Interpreter::ModuleOptions &opts,
                           llvm::ArrayRef<const char *>);
 
+  /// Adopt a module which has already been linked, instrumented and
+  /// prepared with the same options, e.g. one loaded from the module cache.
+  void setPreparedModule(std::unique_ptr<llvm::Module> preparedModule,
+                         const Interpreter::ModuleOptions &opts);
+
   /// Manifest the generated module (e.g. assembly.ll, output.bc) and
   /// prepares KModule
   ///
@@ -395,6 +407,9 @@ public:
   inline unsigned getMaxGlobalIndex() const { return maxGlobalIndex; }
   unsigned getGlobalIndex(const llvm::Function *func) const;
   unsigned getGlobalIndex(const llvm::Instruction *inst) const;
+  /// Return the instruction with the given global index, or null if the
+  /// index belongs to a function.
+  KInstruction *getInstruction(unsigned globalIndex) const;
 };
 } // namespace klee
 
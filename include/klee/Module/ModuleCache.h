@@ -0,0 +1,73 @@
+//===-- ModuleCache.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_MODULECACHE_H
+#define KLEE_MODULECACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/SHA1.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace llvm {
+class LLVMContext;
+class Module;
+} // namespace llvm
+
+namespace klee {
+
+/// ModuleCacheKey - Content hash identifying a prepared module. Everything
+/// that influences linking, instrumentation and preparation of the module
+/// has to be added to the key.
+class ModuleCacheKey {
+  llvm::SHA1 hasher;
+
+public:
+  /// Start a key with the identity of the running KLEE build.
+  ModuleCacheKey();
+
+  void add(llvm::StringRef data);
+  void add(std::uint64_t value);
+  /// Add the bitcode of \p module.
+  void add(const llvm::Module &module);
+  /// Add the contents of the file at \p path, or a marker if it cannot be
+  /// read.
+  void addFile(const std::string &path);
+
+  /// Finish the key and return it as a hex string.
+  std::string str();
+};
+
+/// ModuleCache - Directory of prepared modules, stored as bitcode files named
+/// after their key.
+class ModuleCache {
+  std::string directory;
+
+  std::string getPath(const std::string &key) const;
+
+public:
+  explicit ModuleCache(std::string directory)
+      : directory(std::move(directory)) {}
+
+  /// Load the module stored under \p key into \p ctx, or return nullptr if
+  /// there is none. Unreadable entries are removed with a warning and also
+  /// yield nullptr.
+  std::unique_ptr<llvm::Module> lookup(const std::string &key,
+                                       llvm::LLVMContext &ctx) const;
+
+  /// Store \p module under \p key. The file is written under a temporary
+  /// name and renamed, so concurrent KLEE runs never see partial entries.
+  void store(const std::string &key, const llvm::Module &module) const;
+};
+
+} // namespace klee
+
+#endif /* KLEE_MODULECACHE_H */
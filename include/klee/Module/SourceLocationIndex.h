@@ -0,0 +1,82 @@
+//===-- SourceLocationIndex.h -----------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOURCELOCATIONINDEX_H
+#define KLEE_SOURCELOCATIONINDEX_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+struct KBlock;
+struct KFunction;
+struct KInstruction;
+
+/// Index of the blocks and instructions of a module by source position, used
+/// to resolve the locations of static analysis reports. Blocks and
+/// instructions are filed under the source file of their function. Lookups
+/// take logarithmic time in the number of blocks or instructions of the file,
+/// plus the number of results.
+class SourceLocationIndex {
+public:
+  struct InstructionPosition {
+    size_t line;
+    size_t column;
+    KInstruction *inst;
+  };
+
+  /// Indexes all blocks and instructions of \p functions.
+  void build(const std::vector<std::unique_ptr<KFunction>> &functions);
+
+  bool empty() const { return files.empty(); }
+
+  /// Appends to \p result the blocks of \p file whose lines, from the line
+  /// of their first instruction to the line of their last one, overlap
+  /// [startLine, endLine].
+  void findBlocks(const std::string &file, size_t startLine, size_t endLine,
+                  std::vector<KBlock *> &result) const;
+
+  /// Appends to \p result the instructions of \p file, other than debug
+  /// intrinsics, at lines [startLine, endLine] and columns
+  /// [startColumn, endColumn].
+  void findInstructions(const std::string &file, size_t startLine,
+                        size_t endLine, size_t startColumn, size_t endColumn,
+                        std::vector<InstructionPosition> &result) const;
+
+private:
+  struct BlockLines {
+    size_t first;
+    size_t last;
+    KBlock *block;
+  };
+
+  struct File {
+    /// blocks sorted by the line of their first instruction
+    std::vector<BlockLines> blocks;
+    /// segment tree over `blocks` holding the greatest last line of the
+    /// blocks below each node
+    std::vector<size_t> maxLast;
+    /// instructions sorted by line and column
+    std::vector<InstructionPosition> instructions;
+  };
+
+  std::unordered_map<std::string, File> files;
+
+  static void buildMaxLast(File &file, size_t node, size_t begin, size_t end);
+  static void collectBlocks(const File &file, size_t node, size_t begin,
+                            size_t end, size_t count, size_t startLine,
+                            std::vector<KBlock *> &result);
+};
+
+} // namespace klee
+
+#endif /* KLEE_SOURCELOCATIONINDEX_H */
@@ -16,6 +16,8 @@
 
 #include "klee/Solver/Solver.h"
 
+#include <functional>
+#include <memory>
 #include <string>
 
 namespace klee {
@@ -24,10 +26,19 @@ const char SOLVER_QUERIES_SMT2_FILE_NAME[] = "solver-queries.smt2";
 const char ALL_QUERIES_KQUERY_FILE_NAME[] = "all-queries.kquery";
 const char SOLVER_QUERIES_KQUERY_FILE_NAME[] = "solver-queries.kquery";
 
+/// SolverLayerHook - Called by constructSolverChain with the core solver
+/// and with every layer stacked on top of it, together with the layer name.
+/// The returned solver is used in place of the layer, which allows tools to
+/// instrument individual layers of the chain.
+typedef std::function<std::unique_ptr<Solver>(std::unique_ptr<Solver>,
+                                              const char *)>
+    SolverLayerHook;
+
 std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
-    std::string baseSolverQueryKQueryLogPath);
+    std::string baseSolverQueryKQueryLogPath,
+    const SolverLayerHook &layerHook = nullptr);
 } // namespace klee
 
 #endif /* KLEE_COMMON_H */
@@ -238,6 +238,13 @@ std::unique_ptr<Solver> createCexCachingSolver(std::unique_ptr<Solver> s);
 /// \param s - The underlying solver to use.
 std::unique_ptr<Solver> createFastCexSolver(std::unique_ptr<Solver> s);
 
+/// createRangeSolver - Create a solver which answers queries that the
+/// intervals and known bits implied by the constraints decide, and passes
+/// the others to the underlying solver.
+///
+/// \param s - The underlying solver to use.
+std::unique_ptr<Solver> createRangeSolver(std::unique_ptr<Solver> s);
+
 /// createIndependentSolver - Create a solver which will eliminate any
 /// unnecessary constraints before propogating the query to the underlying
 /// solver.
@@ -23,6 +23,8 @@ namespace klee {
 
 extern llvm::cl::opt<bool> UseFastCexSolver;
 
+extern llvm::cl::opt<bool> UseRangeSolver;
+
 extern llvm::cl::opt<bool> UseCexCache;
 
 extern llvm::cl::opt<bool> UseBranchCache;
@@ -45,6 +47,8 @@ extern llvm::cl::opt<bool> UseForkedCoreSolver;
 
 extern llvm::cl::opt<bool> CoreSolverOptimizeDivides;
 
+extern llvm::cl::opt<unsigned> SolverTranslationCacheSize;
+
 extern llvm::cl::opt<bool> UseAssignmentValidatingSolver;
 
 extern llvm::cl::opt<unsigned> MaxSolversApproxTreeInc;
@@ -16,6 +16,9 @@ namespace klee {
 namespace stats {
 
 extern Statistic cexCacheTime;
+extern Statistic cexCacheLookupTime;
+extern Statistic cexCacheProbes;
+extern Statistic cexCacheEvictions;
 extern Statistic solverQueries;
 extern Statistic queries;
 extern Statistic queriesInvalid;
@@ -30,6 +33,9 @@ extern Statistic validQueriesSize;
 extern Statistic validityCoresSize;
 extern Statistic queryValidityCores;
 extern Statistic queryTime;
+extern Statistic translationCacheHits;
+extern Statistic translationCacheMisses;
+extern Statistic translationTime;
 
 #ifdef KLEE_ARRAY_DEBUG
 extern Statistic arrayHashTime;
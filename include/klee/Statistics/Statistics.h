@@ -12,39 +12,93 @@
 
 #include "Statistic.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string.h>
 #include <string>
 #include <vector>
 
 namespace klee {
 class Statistic;
+/// StatisticRecord holds the values of a group of statistics, e.g. those of
+/// one call path. Only statistics which have been incremented take space.
 class StatisticRecord {
   friend class StatisticManager;
 
 private:
-  uint64_t *data;
+  /// Values of the touched statistics, sorted by statistic id
+  mutable std::vector<std::pair<std::uint32_t, uint64_t>> data;
+
+  uint64_t &getOrCreateValue(std::uint32_t id) const;
 
 public:
-  StatisticRecord();
-  StatisticRecord(const StatisticRecord &s);
-  ~StatisticRecord() { delete[] data; }
+  StatisticRecord() = default;
 
-  void zero();
+  void zero() { data.clear(); }
 
   uint64_t getValue(const Statistic &s) const;
   void incrementValue(const Statistic &s, uint64_t addend) const;
-  StatisticRecord &operator=(const StatisticRecord &s);
   StatisticRecord &operator+=(const StatisticRecord &sr);
 };
 
+/// StatisticManager keeps the values of all statistics. Any thread may
+/// increment statistics without locks:
+///
+/// - Every thread adds to the primary values in a shard of its own, which no
+///   other thread writes to. getValue sums the shards when asked, so readers
+///   such as StatsTracker snapshots aggregate lazily.
+/// - Indexed values are relaxed atomics shared by all threads.
+/// - The index and the call path context are set per thread. Values are only
+///   attributed to an index by threads which have set one, i.e. the
+///   interpreter.
 class StatisticManager {
+public:
+  /// Number of shards; when all are taken, further threads share the last one
+  static constexpr unsigned MaxShards = 64;
+
 private:
+  struct Shard {
+    StatisticManager *owner;
+    std::unique_ptr<std::atomic<uint64_t>[]> values;
+    bool shared = false;
+    bool hasIndex = false;
+    unsigned index = 0;
+    StatisticRecord *context = nullptr;
+  };
+
+  /// The shard of the current thread, returned to its manager on exit
+  struct LocalShard {
+    Shard *shard = nullptr;
+    ~LocalShard();
+  };
+
   bool enabled;
   std::vector<Statistic *> stats;
-  uint64_t *globalStats;
-  uint64_t *indexedStats;
-  StatisticRecord *contextStats;
-  unsigned index;
+  std::unique_ptr<std::atomic<uint64_t>[]> indexedStats;
+
+  std::mutex shardsMutex;
+  std::vector<std::unique_ptr<Shard>> ownedShards;
+  /// Shards of exited threads, to be adopted by new threads
+  std::vector<Shard *> freeShards;
+  std::atomic<Shard *> shards[MaxShards];
+  std::atomic<unsigned> numShards;
+
+  static thread_local LocalShard localShard;
+
+  Shard &getLocalShard() {
+    Shard *shard = localShard.shard;
+    if (!shard || shard->owner != this) {
+      // hand the shard of another manager back, so that it can be reused
+      if (shard)
+        shard->owner->releaseShard(shard);
+      shard = localShard.shard = acquireShard();
+    }
+    return *shard;
+  }
+  Shard *acquireShard();
+  void releaseShard(Shard *shard);
 
 public:
   StatisticManager();
@@ -55,9 +109,17 @@ public:
   StatisticRecord *getContext();
   void setContext(StatisticRecord *sr); /* null to reset */
 
-  void setIndex(unsigned i) { index = i; }
-  unsigned getIndex() { return index; }
+  void setIndex(unsigned i) {
+    Shard &shard = getLocalShard();
+    // Threads sharing a shard cannot attribute values to indices
+    if (!shard.shared) {
+      shard.index = i;
+      shard.hasIndex = true;
+    }
+  }
+  unsigned getIndex() { return getLocalShard().index; }
   unsigned getNumStatistics() { return stats.size(); }
+  unsigned getNumShards() const { return numShards.load(); }
   Statistic &getStatistic(unsigned i) { return *stats[i]; }
 
   void registerStatistic(Statistic &s);
@@ -76,74 +138,87 @@ extern StatisticManager *theStatisticManager;
 inline void StatisticManager::incrementStatistic(Statistic &s,
                                                  uint64_t addend) {
   if (enabled) {
-    globalStats[s.id] += addend;
-    if (indexedStats) {
-      indexedStats[index * stats.size() + s.id] += addend;
-      if (contextStats)
-        contextStats->data[s.id] += addend;
+    Shard &shard = getLocalShard();
+    auto &value = shard.values[s.id];
+    if (shard.shared) {
+      value.fetch_add(addend, std::memory_order_relaxed);
+    } else {
+      // Only this thread writes to its shard
+      value.store(value.load(std::memory_order_relaxed) + addend,
+                  std::memory_order_relaxed);
+    }
+    if (indexedStats && shard.hasIndex) {
+      incrementIndexedValue(s, shard.index, addend);
+      if (shard.context)
+        shard.context->incrementValue(s, addend);
     }
   }
 }
 
-inline StatisticRecord *StatisticManager::getContext() { return contextStats; }
-inline void StatisticManager::setContext(StatisticRecord *sr) {
-  contextStats = sr;
-}
-
-inline void StatisticRecord::zero() {
-  ::memset(data, 0, sizeof(*data) * theStatisticManager->getNumStatistics());
-}
-
-inline StatisticRecord::StatisticRecord()
-    : data(new uint64_t[theStatisticManager->getNumStatistics()]) {
-  zero();
+inline StatisticRecord *StatisticManager::getContext() {
+  return getLocalShard().context;
 }
-
-inline StatisticRecord::StatisticRecord(const StatisticRecord &s)
-    : data(new uint64_t[theStatisticManager->getNumStatistics()]) {
-  ::memcpy(data, s.data,
-           sizeof(*data) * theStatisticManager->getNumStatistics());
+inline void StatisticManager::setContext(StatisticRecord *sr) {
+  Shard &shard = getLocalShard();
+  if (!shard.shared)
+    shard.context = sr;
 }
 
-inline StatisticRecord &StatisticRecord::operator=(const StatisticRecord &s) {
-  ::memcpy(data, s.data,
-           sizeof(*data) * theStatisticManager->getNumStatistics());
-  return *this;
+inline uint64_t &StatisticRecord::getOrCreateValue(std::uint32_t id) const {
+  auto it = std::lower_bound(
+      data.begin(), data.end(), id,
+      [](const std::pair<std::uint32_t, uint64_t> &entry, std::uint32_t id) {
+        return entry.first < id;
+      });
+  if (it == data.end() || it->first != id)
+    it = data.insert(it, {id, 0});
+  return it->second;
 }
 
 inline void StatisticRecord::incrementValue(const Statistic &s,
                                             uint64_t addend) const {
-  data[s.id] += addend;
+  getOrCreateValue(s.id) += addend;
 }
 inline uint64_t StatisticRecord::getValue(const Statistic &s) const {
-  return data[s.id];
+  for (auto &entry : data)
+    if (entry.first >= s.id)
+      return entry.first == s.id ? entry.second : 0;
+  return 0;
 }
 
 inline StatisticRecord &StatisticRecord::operator+=(const StatisticRecord &sr) {
-  unsigned nStats = theStatisticManager->getNumStatistics();
-  for (unsigned i = 0; i < nStats; i++)
-    data[i] += sr.data[i];
+  for (auto &entry : sr.data)
+    getOrCreateValue(entry.first) += entry.second;
   return *this;
 }
 
 inline uint64_t StatisticManager::getValue(const Statistic &s) const {
-  return globalStats[s.id];
+  uint64_t value = 0;
+  for (unsigned i = 0, e = numShards.load(std::memory_order_acquire); i < e;
+       ++i) {
+    value += shards[i].load(std::memory_order_relaxed)->values[s.id].load(
+        std::memory_order_relaxed);
+  }
+  return value;
 }
 
 inline void StatisticManager::incrementIndexedValue(const Statistic &s,
                                                     unsigned index,
                                                     uint64_t addend) const {
-  indexedStats[index * stats.size() + s.id] += addend;
+  indexedStats[index * stats.size() + s.id].fetch_add(
+      addend, std::memory_order_relaxed);
 }
 
 inline uint64_t StatisticManager::getIndexedValue(const Statistic &s,
                                                   unsigned index) const {
-  return indexedStats[index * stats.size() + s.id];
+  return indexedStats[index * stats.size() + s.id].load(
+      std::memory_order_relaxed);
 }
 
 inline void StatisticManager::setIndexedValue(const Statistic &s,
                                               unsigned index, uint64_t value) {
-  indexedStats[index * stats.size() + s.id] = value;
+  indexedStats[index * stats.size() + s.id].store(value,
+                                                  std::memory_order_relaxed);
 }
 } // namespace klee
 
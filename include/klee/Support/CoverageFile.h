@@ -0,0 +1,144 @@
+//===-- CoverageFile.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_COVERAGEFILE_H
+#define KLEE_COVERAGEFILE_H
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+
+/// Binary coverage file (run.cov). Every bitmap and counter is keyed by the
+/// KModule global index, so files produced from the same prepared module
+/// (identified by the module hash) can be merged with plain word-wise
+/// OR/addition. Integers are stored in host byte order:
+///
+///   CoverageFileHeader
+///   uint64_t bitmaps[NumCoverageBitmaps][numWords]
+///   uint64_t counts[numIndices]             (executed instructions)
+///   CoverageFunction functions[numFunctions]
+///   CoverageLine lines[numIndices]
+///   char strings[stringTableSize]           (0-terminated strings)
+struct CoverageFileHeader {
+  static constexpr char Magic[8] = {'K', 'L', 'E', 'E', 'C', 'O', 'V', '\0'};
+  static constexpr std::uint32_t Version = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t numFunctions;
+  std::uint64_t moduleHash;
+  std::uint64_t numIndices;
+  std::uint64_t stringTableSize;
+};
+
+enum class CoverageBitmap : unsigned {
+  Coverable = 0,
+  Covered,
+  BranchTrue,
+  BranchFalse
+};
+constexpr unsigned NumCoverageBitmaps = 4;
+
+struct CoverageFunction {
+  std::uint32_t name;
+  std::uint32_t file;
+  std::uint32_t firstIndex;
+  std::uint32_t numIndices;
+};
+
+struct CoverageLine {
+  std::uint32_t file;
+  std::uint32_t line;
+};
+
+/// Read-only view of a coverage file. The file is memory mapped and all
+/// accessors point into the mapping.
+class CoverageFileView {
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  const CoverageFileHeader *header = nullptr;
+
+  explicit CoverageFileView(std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+  const char *sectionStart(unsigned section) const;
+  /// Check that all string offsets and index ranges are within the file.
+  bool validate(std::string &error) const;
+
+public:
+  /// Map \p path, returning nullptr and setting \p error if the file cannot
+  /// be read or is not a valid coverage file. Once opened, all offsets and
+  /// ranges stored in the file are known to be in bounds.
+  static std::unique_ptr<CoverageFileView> open(const std::string &path,
+                                                std::string &error);
+
+  std::uint64_t getModuleHash() const { return header->moduleHash; }
+  std::uint64_t getNumIndices() const { return header->numIndices; }
+  std::uint64_t getNumWords() const { return (header->numIndices + 63) / 64; }
+  std::uint32_t getNumFunctions() const { return header->numFunctions; }
+
+  const std::uint64_t *getBitmap(CoverageBitmap kind) const;
+  const std::uint64_t *getCounts() const;
+  const CoverageFunction *getFunctions() const;
+  const CoverageLine *getLines() const;
+  const char *getString(std::uint32_t offset) const;
+};
+
+/// Owning, mutable coverage data, used both for producing a file in KLEE and
+/// for accumulating merged results.
+class CoverageData {
+  std::vector<char> strings;
+  std::unordered_map<std::string, std::uint32_t> stringOffsets;
+
+public:
+  std::uint64_t moduleHash = 0;
+  std::uint64_t numIndices = 0;
+  std::vector<std::uint64_t> bitmaps[NumCoverageBitmaps];
+  std::vector<std::uint64_t> counts;
+  std::vector<CoverageFunction> functions;
+  std::vector<CoverageLine> lines;
+
+  CoverageData() = default;
+  CoverageData(std::uint64_t moduleHash, std::uint64_t numIndices);
+  /// Copy the layout (hash, functions, lines, strings) of \p view, with
+  /// all counters zeroed.
+  explicit CoverageData(const CoverageFileView &view);
+
+  std::uint64_t getNumWords() const { return (numIndices + 63) / 64; }
+
+  void set(CoverageBitmap kind, std::uint64_t index) {
+    bitmaps[static_cast<unsigned>(kind)][index / 64] |= std::uint64_t(1)
+                                                         << (index % 64);
+  }
+  bool test(CoverageBitmap kind, std::uint64_t index) const {
+    return (bitmaps[static_cast<unsigned>(kind)][index / 64] >> (index % 64)) &
+           1;
+  }
+
+  /// Intern \p s in the string table and return its offset.
+  std::uint32_t addString(const std::string &s);
+  const char *getString(std::uint32_t offset) const {
+    return strings.data() + offset;
+  }
+
+  /// OR the bitmaps and add the counters of \p view into this data. Returns
+  /// false if \p view belongs to a different module.
+  bool merge(const CoverageFileView &view);
+
+  void write(llvm::raw_ostream &os) const;
+};
+
+} // namespace klee
+
+#endif /* KLEE_COVERAGEFILE_H */
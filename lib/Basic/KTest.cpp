@@ -9,11 +9,17 @@
 
 #include "klee/ADT/KTest.h"
 
+#include <atomic>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #define KTEST_VERSION 4
 #define KTEST_MAGIC_SIZE 5
 #define KTEST_MAGIC "KTEST"
@@ -86,6 +92,50 @@ static int write_string(FILE *f, const char *value) {
   return 1;
 }
 
+/* reads from the contents of a mapped file */
+typedef struct Buffer {
+  const unsigned char *pos;
+  const unsigned char *end;
+} Buffer;
+
+static int buffer_read_bytes(Buffer *b, unsigned len,
+                             const unsigned char **value_out) {
+  if ((size_t)(b->end - b->pos) < len)
+    return 0;
+  *value_out = b->pos;
+  b->pos += len;
+  return 1;
+}
+
+static int buffer_read_uint32(Buffer *b, unsigned *value_out) {
+  const unsigned char *data;
+  if (!buffer_read_bytes(b, 4, &data))
+    return 0;
+  *value_out = (((((data[0] << 8) + data[1]) << 8) + data[2]) << 8) + data[3];
+  return 1;
+}
+
+static int buffer_read_uint64(Buffer *b, uint64_t *value_out) {
+  unsigned hi, lo;
+  if (!buffer_read_uint32(b, &hi) || !buffer_read_uint32(b, &lo))
+    return 0;
+  *value_out = ((uint64_t)hi << 32) | lo;
+  return 1;
+}
+
+static int buffer_read_string(Buffer *b, char **value_out) {
+  unsigned len;
+  const unsigned char *data;
+  if (!buffer_read_uint32(b, &len) || !buffer_read_bytes(b, len, &data))
+    return 0;
+  *value_out = (char *)malloc(len + 1);
+  if (!*value_out)
+    return 0;
+  memcpy(*value_out, data, len);
+  (*value_out)[len] = 0;
+  return 1;
+}
+
 /***/
 
 unsigned kTest_getCurrentVersion() { return KTEST_VERSION; }
@@ -217,6 +267,149 @@ error:
   return 0;
 }
 
+/* every mapping costs at least a page and counts against the per-process
+   mapping limit (vm.max_map_count), so small files are read instead, and
+   once KTEST_MAX_MAPPINGS files are mapped further files are read too */
+#define KTEST_MAP_THRESHOLD (64 * 1024)
+#define KTEST_MAX_MAPPINGS 1024
+
+static std::atomic<unsigned> numMappings(0);
+
+static int reserve_mapping(void) {
+  unsigned n = numMappings.load();
+  while (n < KTEST_MAX_MAPPINGS)
+    if (numMappings.compare_exchange_weak(n, n + 1))
+      return 1;
+  return 0;
+}
+
+/* maps large files, reads small ones or those that cannot be mapped */
+static int kTest_loadBuffer(const char *path, KTest *res) {
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  res->bufferSize = st.st_size;
+  if (res->bufferSize >= KTEST_MAP_THRESHOLD && reserve_mapping()) {
+    res->buffer = mmap(0, res->bufferSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (res->buffer != MAP_FAILED) {
+      res->bufferIsMapped = 1;
+      close(fd);
+      return 1;
+    }
+    --numMappings;
+  }
+
+  uint64_t done = 0;
+  res->buffer = malloc(res->bufferSize);
+  while (res->buffer && done < res->bufferSize) {
+    ssize_t n = read(fd, (char *)res->buffer + done, res->bufferSize - done);
+    if (n <= 0) {
+      free(res->buffer);
+      res->buffer = 0;
+    } else {
+      done += n;
+    }
+  }
+  close(fd);
+
+  return res->buffer != 0;
+}
+
+KTest *kTest_fromFileMapped(const char *path) {
+  KTest *res = (KTest *)calloc(1, sizeof(*res));
+  Buffer b;
+  const unsigned char *data;
+  unsigned i, j, version;
+
+  if (!res)
+    return 0;
+  if (!kTest_loadBuffer(path, res))
+    goto error;
+
+  b.pos = (const unsigned char *)res->buffer;
+  b.end = b.pos + res->bufferSize;
+  if (!buffer_read_bytes(&b, KTEST_MAGIC_SIZE, &data))
+    goto error;
+  if (memcmp(data, KTEST_MAGIC, KTEST_MAGIC_SIZE) &&
+      memcmp(data, BOUT_MAGIC, KTEST_MAGIC_SIZE))
+    goto error;
+
+  if (!buffer_read_uint32(&b, &version))
+    goto error;
+
+  if (version > kTest_getCurrentVersion())
+    goto error;
+
+  res->version = version;
+
+  if (!buffer_read_uint32(&b, &res->numArgs))
+    goto error;
+  res->args = (char **)calloc(res->numArgs, sizeof(*res->args));
+  if (!res->args)
+    goto error;
+
+  for (i = 0; i < res->numArgs; i++)
+    if (!buffer_read_string(&b, &res->args[i]))
+      goto error;
+
+  if (version >= 2) {
+    if (!buffer_read_uint32(&b, &res->symArgvs))
+      goto error;
+    if (!buffer_read_uint32(&b, &res->symArgvLen))
+      goto error;
+  }
+
+  if (!buffer_read_uint32(&b, &res->numObjects))
+    goto error;
+  res->objects = (KTestObject *)calloc(res->numObjects, sizeof(*res->objects));
+  if (!res->objects)
+    goto error;
+  for (i = 0; i < res->numObjects; i++) {
+    KTestObject *o = &res->objects[i];
+    if (!buffer_read_string(&b, &o->name))
+      goto error;
+    if (!buffer_read_uint64(&b, &o->address))
+      goto error;
+    if (!buffer_read_uint32(&b, &o->numBytes))
+      goto error;
+    if (!buffer_read_bytes(&b, o->numBytes, &data))
+      goto error;
+    o->bytes = (unsigned char *)data;
+    if (version >= 4) {
+      if (!buffer_read_uint32(&b, &o->numPointers))
+        goto error;
+      o->pointers = (Pointer *)calloc(o->numPointers, sizeof(*o->pointers));
+      if (!o->pointers)
+        goto error;
+      for (j = 0; j < o->numPointers; j++) {
+        Pointer *p = &o->pointers[j];
+        if (!buffer_read_uint64(&b, &p->offset))
+          goto error;
+        if (!buffer_read_uint64(&b, &p->index))
+          goto error;
+        if (!buffer_read_uint64(&b, &p->indexOffset))
+          goto error;
+      }
+    }
+  }
+
+  return res;
+error:
+  if (!res->args)
+    res->numArgs = 0;
+  if (!res->objects)
+    res->numObjects = 0;
+  kTest_free(res);
+
+  return 0;
+}
+
 int kTest_toFile(const KTest *bo, const char *path) {
   FILE *f = fopen(path, "wb");
   unsigned i, j;
@@ -289,9 +482,15 @@ void kTest_free(KTest *bo) {
   free(bo->args);
   for (i = 0; i < bo->numObjects; i++) {
     free(bo->objects[i].name);
-    free(bo->objects[i].bytes);
+    if (!bo->buffer)
+      free(bo->objects[i].bytes);
     free(bo->objects[i].pointers);
   }
   free(bo->objects);
+  if (bo->bufferIsMapped) {
+    munmap(bo->buffer, bo->bufferSize);
+    --numMappings;
+  } else
+    free(bo->buffer);
   free(bo);
 }
@@ -9,31 +9,75 @@
 
 #include "klee/Statistics/Statistics.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <vector>
 
 using namespace klee;
 
-StatisticManager::StatisticManager()
-    : enabled(true), globalStats(0), indexedStats(0), contextStats(0),
-      index(0) {}
+thread_local StatisticManager::LocalShard StatisticManager::localShard;
 
-StatisticManager::~StatisticManager() {
-  delete[] globalStats;
-  delete[] indexedStats;
-}
+StatisticManager::StatisticManager() : enabled(true), numShards(0) {}
+
+StatisticManager::~StatisticManager() = default;
 
 void StatisticManager::useIndexedStats(unsigned totalIndices) {
-  delete[] indexedStats;
-  indexedStats = new uint64_t[totalIndices * stats.size()];
-  memset(indexedStats, 0, sizeof(*indexedStats) * totalIndices * stats.size());
+  indexedStats.reset(new std::atomic<uint64_t>[totalIndices * stats.size()]);
+  for (unsigned i = 0, e = totalIndices * stats.size(); i < e; ++i)
+    indexedStats[i].store(0, std::memory_order_relaxed);
 }
 
 void StatisticManager::registerStatistic(Statistic &s) {
-  delete[] globalStats;
+  // Existing shards have no room for the new statistic
+  if (numShards.load() != 0) {
+    fprintf(stderr,
+            "KLEE: ERROR: statistic %s registered after statistics were "
+            "used\n",
+            s.getName().c_str());
+    abort();
+  }
   s.id = stats.size();
   stats.push_back(&s);
-  globalStats = new uint64_t[stats.size()];
-  memset(globalStats, 0, sizeof(*globalStats) * stats.size());
+}
+
+StatisticManager::Shard *StatisticManager::acquireShard() {
+  std::lock_guard<std::mutex> lock(shardsMutex);
+  if (!freeShards.empty()) {
+    Shard *shard = freeShards.back();
+    freeShards.pop_back();
+    return shard;
+  }
+
+  unsigned n = numShards.load(std::memory_order_relaxed);
+  if (n == MaxShards)
+    return shards[n - 1].load(std::memory_order_relaxed);
+
+  auto shard = std::make_unique<Shard>();
+  shard->owner = this;
+  // The last shard is shared by all threads which come after it
+  shard->shared = n == MaxShards - 1;
+  shard->values.reset(new std::atomic<uint64_t>[stats.size()]);
+  for (unsigned i = 0; i < stats.size(); ++i)
+    shard->values[i].store(0, std::memory_order_relaxed);
+  shards[n].store(shard.get(), std::memory_order_relaxed);
+  numShards.store(n + 1, std::memory_order_release);
+  ownedShards.push_back(std::move(shard));
+  return ownedShards.back().get();
+}
+
+void StatisticManager::releaseShard(Shard *shard) {
+  std::lock_guard<std::mutex> lock(shardsMutex);
+  if (shard->shared)
+    return;
+  shard->hasIndex = false;
+  shard->index = 0;
+  shard->context = nullptr;
+  freeShards.push_back(shard);
+}
+
+StatisticManager::LocalShard::~LocalShard() {
+  if (shard)
+    shard->owner->releaseShard(shard);
 }
 
 int StatisticManager::getStatisticID(const std::string &name) const {
@@ -24,7 +24,8 @@ using namespace klee;
 CallPathNode::CallPathNode(CallPathNode *_parent,
                            const llvm::Instruction *_callSite,
                            const llvm::Function *_function)
-    : parent(_parent), callSite(_callSite), function(_function), count(0) {}
+    : parent(_parent), callSite(_callSite), function(_function), count(0),
+      depth(_parent ? _parent->depth + 1 : 0), id(0) {}
 
 void CallPathNode::print() {
   llvm::errs() << "  (Function: " << this->function->getName() << ", "
@@ -39,22 +40,26 @@ void CallPathNode::print() {
 
 ///
 
-CallPathManager::CallPathManager() : root(nullptr, nullptr, nullptr) {}
+CallPathManager::CallPathManager(unsigned maxDepth)
+    : root(nullptr, nullptr, nullptr), maxDepth(maxDepth) {}
 
 void CallPathManager::getSummaryStatistics(CallSiteSummaryTable &results) {
   results.clear();
 
-  for (auto &path : paths)
-    path->summaryStatistics = path->statistics;
+  std::vector<StatisticRecord> summaries;
+  summaries.reserve(paths.size());
+  for (auto path : paths)
+    summaries.push_back(path->statistics);
 
   // compute summary bottom up, while building result table
-  for (auto it = paths.rbegin(), ie = paths.rend(); it != ie; ++it) {
-    const auto &cp = (*it);
-    cp->parent->summaryStatistics += cp->summaryStatistics;
+  for (unsigned i = paths.size(); i-- > 0;) {
+    const CallPathNode *cp = paths[i];
+    if (cp->parent != &root)
+      summaries[cp->parent->id] += summaries[i];
 
     CallSiteInfo &csi = results[cp->callSite][cp->function];
     csi.count += cp->count;
-    csi.statistics += cp->summaryStatistics;
+    csi.statistics += summaries[i];
   }
 }
 
@@ -65,25 +70,26 @@ CallPathNode *CallPathManager::computeCallPath(CallPathNode *parent,
     if (cs == p->callSite && f == p->function)
       return p;
 
-  auto cp = std::unique_ptr<CallPathNode>(new CallPathNode(parent, cs, f));
-  auto newCP = cp.get();
-  paths.emplace_back(std::move(cp));
+  auto newCP = new (allocator.Allocate()) CallPathNode(parent, cs, f);
+  newCP->id = paths.size();
+  paths.push_back(newCP);
   return newCP;
 }
 
 CallPathNode *CallPathManager::getCallPath(CallPathNode *parent,
                                            const llvm::Instruction *cs,
                                            const llvm::Function *f) {
-  std::pair<const llvm::Instruction *, const llvm::Function *> key(cs, f);
   if (!parent)
     parent = &root;
+  // calls below the last level become siblings on that level
+  if (maxDepth && parent->depth >= maxDepth)
+    parent = parent->parent;
 
-  auto it = parent->children.find(key);
-  if (it == parent->children.end()) {
-    auto cp = computeCallPath(parent, cs, f);
-    parent->children.insert(std::make_pair(key, cp));
-    return cp;
-  } else {
+  auto it = nodes.find(Key(parent, cs, f));
+  if (it != nodes.end())
     return it->second;
-  }
+
+  auto cp = computeCallPath(parent, cs, f);
+  nodes.try_emplace(Key(parent, cs, f), cp);
+  return cp;
 }
@@ -12,8 +12,11 @@
 
 #include "klee/Statistics/Statistics.h"
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Allocator.h"
+
 #include <map>
-#include <memory>
+#include <tuple>
 #include <vector>
 
 namespace llvm {
@@ -40,19 +43,17 @@ class CallPathNode {
   friend class CallPathManager;
 
 public:
-  typedef std::map<std::pair<const llvm::Instruction *, const llvm::Function *>,
-                   CallPathNode *>
-      children_ty;
-
   // form list of (callSite,function) path
   CallPathNode *parent;
   const llvm::Instruction *callSite;
   const llvm::Function *function;
-  children_ty children;
 
   StatisticRecord statistics;
-  StatisticRecord summaryStatistics;
   unsigned count;
+  /// Number of nodes on the path, not counting the root
+  unsigned depth;
+  /// Position in CallPathManager::paths
+  unsigned id;
 
 public:
   CallPathNode(CallPathNode *parent, const llvm::Instruction *callSite,
@@ -61,9 +62,22 @@ public:
   void print();
 };
 
+/// CallPathManager interns call paths: every (parent, callSite, function)
+/// triple maps to exactly one node, so recurring paths share their node and
+/// their statistics. With a depth limit, calls made below the last level are
+/// kept as siblings on that level: their counts and own costs stay exact,
+/// but they are not part of the inclusive costs of their callers.
 class CallPathManager {
+  typedef std::tuple<CallPathNode *, const llvm::Instruction *,
+                     const llvm::Function *>
+      Key;
+
   CallPathNode root;
-  std::vector<std::unique_ptr<CallPathNode>> paths;
+  llvm::SpecificBumpPtrAllocator<CallPathNode> allocator;
+  llvm::DenseMap<Key, CallPathNode *> nodes;
+  /// Nodes in order of creation, so parents come before their children
+  std::vector<CallPathNode *> paths;
+  unsigned maxDepth;
 
 private:
   CallPathNode *computeCallPath(CallPathNode *parent,
@@ -71,7 +85,8 @@ private:
                                 const llvm::Function *f);
 
 public:
-  CallPathManager();
+  /// \param maxDepth the longest call path to track, 0 for no limit
+  explicit CallPathManager(unsigned maxDepth = 0);
   ~CallPathManager() = default;
 
   void getSummaryStatistics(CallSiteSummaryTable &result);
@@ -29,6 +29,11 @@ extern Statistic falseBranches;
 extern Statistic forkTime;
 extern Statistic solverTime;
 
+/// The number of bounds checks of memory accesses, and how many of them were
+/// decided from the ranges of the path constraints without the solver.
+extern Statistic boundsChecks;
+extern Statistic rangeBoundsChecks;
+
 /// The number of external calls.
 extern Statistic externalCalls;
 
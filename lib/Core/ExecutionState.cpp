@@ -157,7 +157,8 @@ ExecutionState::ExecutionState(const ExecutionState &state)
       level(state.level), addressSpace(state.addressSpace),
       constraints(state.constraints), eventsRecorder(state.eventsRecorder),
       targetForest(state.targetForest), pathOS(state.pathOS),
-      symPathOS(state.symPathOS), coveredLines(state.coveredLines),
+      symPathOS(state.symPathOS),
+      coveredInstructions(state.coveredInstructions),
       symbolics(state.symbolics), resolvedPointers(state.resolvedPointers),
       cexPreferences(state.cexPreferences), arrayNames(state.arrayNames),
       steppedInstructions(state.steppedInstructions),
@@ -181,7 +182,7 @@ ExecutionState *ExecutionState::branch() {
 
   auto *falseState = new ExecutionState(*this);
   falseState->setID();
-  falseState->coveredLines.clear();
+  falseState->coveredInstructions.clear();
   falseState->prevTargets_ = falseState->targets_;
   falseState->prevHistory_ = falseState->history_;
 
@@ -37,6 +37,7 @@
 #include "EventRecorder.h"
 
 #include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/SparseBitVector.h"
 #include "llvm/IR/Function.h"
 
 #include <cstddef>
@@ -352,8 +353,8 @@ public:
   /// taken to reach/create this state
   TreeOStream symPathOS;
 
-  /// @brief Set containing which lines in which files are covered by this state
-  std::map<std::string, std::set<unsigned>> coveredLines;
+  /// @brief Global indices of the instructions this state covered first
+  llvm::SparseBitVector<> coveredInstructions;
 
   /// @brief Pointer to the process tree of the current state
   /// Copies of ExecutionState should not copy ptreeNode
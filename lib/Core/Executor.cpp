@@ -58,6 +58,7 @@
 #include "klee/Module/KCallable.h"
 #include "klee/Module/KInstruction.h"
 #include "klee/Module/KModule.h"
+#include "klee/Module/ModuleCache.h"
 #include "klee/Module/SarifReport.h"
 #include "klee/Solver/Common.h"
 #include "klee/Solver/Solver.h"
@@ -285,6 +286,12 @@ cl::opt<bool>
                                 "from other constraints (default=true)"),
                        cl::cat(SolvingCat));
 
+cl::opt<bool> RangeBoundsChecks(
+    "range-bounds-checks", cl::init(true),
+    cl::desc("Decide memory bounds checks from the ranges implied by the path "
+             "constraints before querying the solver (default=true)"),
+    cl::cat(SolvingCat));
+
 cl::opt<bool>
     EqualitySubstitution("equality-substitution", cl::init(true),
                          cl::desc("Simplify equality expressions before "
@@ -390,6 +397,13 @@ cl::opt<std::string>
                       "search (default=0s (off))"),
              cl::cat(SeedingCat));
 
+cl::opt<unsigned> ReplayPathVerifyInterval(
+    "replay-path-verify-interval", cl::init(1),
+    cl::desc("With --replay-path, check only every Nth recorded branch with "
+             "the solver and take the others without any query. 0 trusts "
+             "all recorded branches (default=1)"),
+    cl::cat(SeedingCat));
+
 /*** Debugging options ***/
 
 /// The different query logging solvers that can switched on/off
@@ -585,18 +599,13 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
   }
 }
 
-llvm::Module *Executor::setModule(
+void Executor::prepareModule(
     std::vector<std::unique_ptr<llvm::Module>> &userModules,
     std::vector<std::unique_ptr<llvm::Module>> &libsModules,
-    const ModuleOptions &opts, std::set<std::string> &&mainModuleFunctions,
-    std::set<std::string> &&mainModuleGlobals, FLCtoOpcode &&origInstructions,
+    const ModuleOptions &opts, std::set<std::string> &mainModuleFunctions,
+    std::set<std::string> &mainModuleGlobals,
     const std::set<std::string> &ignoredExternals,
-    std::vector<std::pair<std::string, std::string>> redefinitions) {
-  assert(!kmodule && !userModules.empty() &&
-         "can only register one module"); // XXX gross
-
-  kmodule = std::make_unique<KModule>();
-
+    std::vector<std::pair<std::string, std::string>> &redefinitions) {
   // 1.) Link the modules together && 2.) Apply different instrumentation
   kmodule->link(userModules, 1);
   kmodule->instrument(opts);
@@ -677,6 +686,80 @@ llvm::Module *Executor::setModule(
 
   kmodule->optimiseAndPrepare(opts, preservedFunctions);
   kmodule->checkModule();
+}
+
+std::string Executor::getModuleCacheKey(
+    const std::vector<std::unique_ptr<llvm::Module>> &userModules,
+    const std::vector<std::unique_ptr<llvm::Module>> &libsModules,
+    const ModuleOptions &opts) const {
+  ModuleCacheKey key;
+  for (auto &module : userModules)
+    key.add(*module);
+  key.add(userModules.size());
+  for (auto &module : libsModules)
+    key.add(*module);
+  key.add(libsModules.size());
+
+  SmallString<128> intrinsicLibPath(opts.LibraryDir);
+  llvm::sys::path::append(intrinsicLibPath, "libkleeRuntimeIntrinsic" +
+                                                opts.OptSuffix + ".bca");
+  key.addFile(intrinsicLibPath.str().str());
+
+  key.add(opts.EntryPoint);
+  key.add(opts.OptSuffix);
+  key.add(opts.MainCurrentName);
+  key.add(opts.MainNameAfterMock);
+  key.add(opts.Optimize);
+  key.add(opts.Simplify);
+  key.add(opts.CheckDivZero);
+  key.add(opts.CheckOvershift);
+  key.add(opts.WithFPRuntime);
+  key.add(opts.WithPOSIXRuntime);
+  key.add(opts.ModuleCacheOptions);
+  key.add(FunctionCallReproduce);
+  return key.str();
+}
+
+llvm::Module *Executor::setModule(
+    std::vector<std::unique_ptr<llvm::Module>> &userModules,
+    std::vector<std::unique_ptr<llvm::Module>> &libsModules,
+    const ModuleOptions &opts, std::set<std::string> &&mainModuleFunctions,
+    std::set<std::string> &&mainModuleGlobals, FLCtoOpcode &&origInstructions,
+    const std::set<std::string> &ignoredExternals,
+    std::vector<std::pair<std::string, std::string>> redefinitions) {
+  assert(!kmodule && !userModules.empty() &&
+         "can only register one module"); // XXX gross
+
+  kmodule = std::make_unique<KModule>();
+
+  // The mocks are written to the output directory while they are built, so
+  // only modules prepared without them are cached.
+  bool buildsMocks =
+      interpreterOpts.Mock == MockPolicy::All ||
+      interpreterOpts.MockMutableGlobals == MockMutableGlobalsPolicy::All ||
+      !opts.AnnotationsFile.empty();
+  std::string cacheKey;
+  std::unique_ptr<llvm::Module> cachedModule;
+  if (!opts.ModuleCacheDir.empty() && !buildsMocks) {
+    cacheKey = getModuleCacheKey(userModules, libsModules, opts);
+    cachedModule = ModuleCache(opts.ModuleCacheDir)
+                       .lookup(cacheKey, userModules.front()->getContext());
+  }
+
+  if (cachedModule) {
+    klee_message("Using prepared module %s from the module cache",
+                 cacheKey.c_str());
+    // the linked module is named after the first user module
+    cachedModule->setModuleIdentifier(
+        userModules.front()->getModuleIdentifier());
+    kmodule->setPreparedModule(std::move(cachedModule), opts);
+    specialFunctionHandler = new SpecialFunctionHandler(*this);
+  } else {
+    prepareModule(userModules, libsModules, opts, mainModuleFunctions,
+                  mainModuleGlobals, ignoredExternals, redefinitions);
+    if (!cacheKey.empty())
+      ModuleCache(opts.ModuleCacheDir).store(cacheKey, *kmodule->module);
+  }
 
   // 4.) Manifest the module
   std::swap(kmodule->mainModuleFunctions, mainModuleFunctions);
@@ -1354,6 +1437,11 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       seedMap->find(&current);
   bool isSeeding = it != seedMap->end();
 
+  if (!isSeeding && replayPath && !isInternal &&
+      (!ReplayPathVerifyInterval ||
+       replayPosition % ReplayPathVerifyInterval != 0))
+    return forkOnRecordedBranch(current, condition);
+
   if (!isSeeding)
     condition = maxStaticPctChecks(current, condition);
 
@@ -1415,10 +1503,13 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
              "ran out of branches in replay path mode");
       bool branch = (*replayPath)[replayPosition++];
 
-      if (res == PValidity::MustBeTrue) {
-        assert(branch && "hit invalid branch in replay path mode");
-      } else if (res == PValidity::MustBeFalse) {
-        assert(!branch && "hit invalid branch in replay path mode");
+      if (res == PValidity::MustBeTrue || res == PValidity::MustBeFalse) {
+        if (branch != (res == PValidity::MustBeTrue)) {
+          current.pc = current.prevPC;
+          terminateStateOnUserError(current,
+                                    "hit invalid branch in replay path mode");
+          return StatePair(nullptr, nullptr);
+        }
       } else {
         // add constraints
         if (branch) {
@@ -1551,7 +1642,8 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       }
       if (swapInfo) {
         std::swap(trueState->coveredNew, falseState->coveredNew);
-        std::swap(trueState->coveredLines, falseState->coveredLines);
+        std::swap(trueState->coveredInstructions,
+                  falseState->coveredInstructions);
       }
     }
 
@@ -1590,6 +1682,28 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
   }
 }
 
+Executor::StatePair Executor::forkOnRecordedBranch(ExecutionState &current,
+                                                   ref<Expr> condition) {
+  assert(replayPosition < replayPath->size() &&
+         "ran out of branches in replay path mode");
+  bool branch = (*replayPath)[replayPosition++];
+
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(condition)) {
+    if (CE->isTrue() != branch) {
+      current.pc = current.prevPC;
+      terminateStateOnUserError(current,
+                                "hit invalid branch in replay path mode");
+      return StatePair(nullptr, nullptr);
+    }
+  } else {
+    addConstraint(current, branch ? condition : Expr::createIsZero(condition));
+  }
+
+  if (pathWriter)
+    current.pathOS << (branch ? "1" : "0");
+  return branch ? StatePair(&current, nullptr) : StatePair(nullptr, &current);
+}
+
 Executor::StatePair Executor::forkInternal(ExecutionState &current,
                                            ref<Expr> condition,
                                            BranchType reason) {
@@ -4567,10 +4681,8 @@ const KFunction *Executor::getKFunction(const llvm::Function *f) const {
 void Executor::seed(ExecutionState &initialState) {
   std::vector<SeedInfo> &v = seedMap->at(&initialState);
 
-  for (std::vector<KTest *>::const_iterator it = usingSeeds->begin(),
-                                            ie = usingSeeds->end();
-       it != ie; ++it)
-    v.push_back(SeedInfo(*it));
+  for (const auto &path : *usingSeeds)
+    v.push_back(SeedInfo(std::make_shared<SeedInput>(path)));
 
   int lastNumSeeds = usingSeeds->size() + 10;
   time::Point lastTime, startTime = lastTime = time::getWallTime();
@@ -6075,12 +6187,21 @@ bool Executor::checkResolvedMemoryObjects(
             .simplified;
 
     PartialValidity result;
-    solver->setTimeout(coreSolverTimeout);
-    bool success = solver->evaluate(state.constraints.cs(), inBounds, result,
-                                    state.queryMetaData);
-    solver->setTimeout(time::Span());
-    if (!success) {
-      return false;
+    std::optional<bool> known;
+    ++stats::boundsChecks;
+    if (RangeBoundsChecks)
+      known = state.constraints.cs().ranges().evaluate(inBounds);
+    if (known) {
+      ++stats::rangeBoundsChecks;
+      result = *known ? PValidity::MustBeTrue : PValidity::MustBeFalse;
+    } else {
+      solver->setTimeout(coreSolverTimeout);
+      bool success = solver->evaluate(state.constraints.cs(), inBounds, result,
+                                      state.queryMetaData);
+      solver->setTimeout(time::Span());
+      if (!success) {
+        return false;
+      }
     }
 
     mayBeOutOfBound = PValidity::MustBeFalse == result ||
@@ -6138,13 +6259,20 @@ bool Executor::checkResolvedMemoryObjects(
                                                        addressNotInBounds)
                                .simplified;
 
-      bool mayBeInBounds;
-      solver->setTimeout(coreSolverTimeout);
-      bool success = solver->mayBeTrue(state.constraints.cs(), inBounds,
-                                       mayBeInBounds, state.queryMetaData);
-      solver->setTimeout(time::Span());
-      if (!success) {
-        return false;
+      ++stats::boundsChecks;
+      bool mayBeInBounds =
+          !RangeBoundsChecks ||
+          state.constraints.cs().ranges().evaluate(inBounds) != false;
+      if (!mayBeInBounds) {
+        ++stats::rangeBoundsChecks;
+      } else {
+        solver->setTimeout(coreSolverTimeout);
+        bool success = solver->mayBeTrue(state.constraints.cs(), inBounds,
+                                         mayBeInBounds, state.queryMetaData);
+        solver->setTimeout(time::Span());
+        if (!success) {
+          return false;
+        }
       }
       if (!mayBeInBounds) {
         continue;
@@ -6335,19 +6463,26 @@ void Executor::executeMemoryOperation(
     inBounds = Simplificator::simplifyExpr(state->constraints.cs(), inBounds)
                    .simplified;
 
-    ref<SolverResponse> response;
-    solver->setTimeout(coreSolverTimeout);
-    bool success = solver->getResponse(state->constraints.cs(), inBounds,
-                                       response, state->queryMetaData);
-    solver->setTimeout(time::Span());
-    if (!success) {
-      state->pc = state->prevPC;
-      terminateStateOnSolverError(*state, "Query timed out (bounds check).");
-      return;
+    ++stats::boundsChecks;
+    std::optional<bool> known;
+    if (RangeBoundsChecks)
+      known = state->constraints.cs().ranges().evaluate(inBounds);
+    bool mustBeInBounds = known.value_or(false);
+    if (known) {
+      ++stats::rangeBoundsChecks;
+    } else {
+      ref<SolverResponse> response;
+      solver->setTimeout(coreSolverTimeout);
+      bool success = solver->getResponse(state->constraints.cs(), inBounds,
+                                         response, state->queryMetaData);
+      solver->setTimeout(time::Span());
+      if (!success) {
+        state->pc = state->prevPC;
+        terminateStateOnSolverError(*state, "Query timed out (bounds check).");
+        return;
+      }
+      mustBeInBounds = !isa<InvalidResponse>(response);
     }
-    solver->setTimeout(time::Span());
-
-    bool mustBeInBounds = !isa<InvalidResponse>(response);
     if (mustBeInBounds) {
       ref<Expr> result;
       op = state->addressSpace.findOrLazyInitializeObject(idFastResult.get());
@@ -7619,7 +7754,11 @@ bool Executor::getSymbolicSolution(const ExecutionState &state, KTest &res) {
 
 void Executor::getCoveredLines(const ExecutionState &state,
                                std::map<std::string, std::set<unsigned>> &res) {
-  res = state.coveredLines;
+  res.clear();
+  for (unsigned index : state.coveredInstructions) {
+    const KInstruction *ki = kmodule->getInstruction(index);
+    res[ki->getSourceFilepath()].insert(ki->getLine());
+  }
 }
 
 void Executor::getBlockPath(const ExecutionState &state,
@@ -198,9 +198,9 @@ private:
   /// object.
   unsigned replayPosition;
 
-  /// When non-null a list of "seed" inputs which will be used to
-  /// drive execution.
-  const std::vector<struct KTest *> *usingSeeds;
+  /// When non-null a list of "seed" files which will be used to
+  /// drive execution. Each file is loaded when it is first needed.
+  const std::vector<std::string> *usingSeeds;
 
   /// Disables forking, instead a random path is chosen. Enabled as
   /// needed to control memory usage. \see fork()
@@ -282,6 +282,20 @@ private:
                                         F objectProvider);
 #endif
 
+  /// Link, instrument and optimise the modules into kmodule.
+  void prepareModule(
+      std::vector<std::unique_ptr<llvm::Module>> &userModules,
+      std::vector<std::unique_ptr<llvm::Module>> &libsModules,
+      const ModuleOptions &opts, std::set<std::string> &mainModuleFunctions,
+      std::set<std::string> &mainModuleGlobals,
+      const std::set<std::string> &ignoredExternals,
+      std::vector<std::pair<std::string, std::string>> &redefinitions);
+  /// Key of the prepared module in the module cache.
+  std::string getModuleCacheKey(
+      const std::vector<std::unique_ptr<llvm::Module>> &userModules,
+      const std::vector<std::unique_ptr<llvm::Module>> &libsModules,
+      const ModuleOptions &opts) const;
+
   void initializeGlobalAlias(const llvm::Constant *c, ExecutionState &state);
   void initializeGlobalObject(ExecutionState &state, ObjectState *os,
                               const llvm::Constant *c, unsigned offset);
@@ -446,6 +460,9 @@ private:
   /// if ifTrueBlock == ifFalseBlock, then fork is internal
   StatePair fork(ExecutionState &current, ref<Expr> condition,
                  KBlock *ifTrueBlock, KBlock *ifFalseBlock, BranchType reason);
+  /// Take the next branch of the replayed path without asking the solver
+  /// whether it is feasible.
+  StatePair forkOnRecordedBranch(ExecutionState &current, ref<Expr> condition);
   StatePair forkInternal(ExecutionState &current, ref<Expr> condition,
                          BranchType reason);
 
@@ -768,7 +785,7 @@ public:
 
   void setFunctionsByModule(FunctionsByModule &&functionsByModule) override;
 
-  void useSeeds(const std::vector<struct KTest *> *seeds) override {
+  void useSeeds(const std::vector<std::string> *seeds) override {
     usingSeeds = seeds;
   }
 
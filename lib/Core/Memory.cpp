@@ -515,8 +515,6 @@ ObjectStage::ObjectStage(const Array *array, ref<Expr> defaultValue, bool safe,
     : updates(array, nullptr), size(array->size), safeRead(safe), width(width) {
   knownSymbolics.reset(constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
       array->getSize(), defaultValue, MaxFixedSizeStructureSize));
-  unflushedMask.reset(
-      constructStorage(array->getSize(), false, MaxFixedSizeStructureSize));
 }
 
 ObjectStage::ObjectStage(ref<Expr> size, ref<Expr> defaultValue, bool safe,
@@ -524,12 +522,11 @@ ObjectStage::ObjectStage(ref<Expr> size, ref<Expr> defaultValue, bool safe,
     : updates(nullptr, nullptr), size(size), safeRead(safe), width(width) {
   knownSymbolics.reset(constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
       size, defaultValue, MaxFixedSizeStructureSize));
-  unflushedMask.reset(constructStorage(size, false, MaxFixedSizeStructureSize));
 }
 
 ObjectStage::ObjectStage(const ObjectStage &os)
     : knownSymbolics(os.knownSymbolics->clone()),
-      unflushedMask(os.unflushedMask->clone()), updates(os.updates),
+      unflushed(os.unflushed), updates(os.updates),
       size(os.size), safeRead(os.safeRead), width(os.width) {}
 
 /***/
@@ -555,7 +552,7 @@ const UpdateList &ObjectStage::getUpdates() const {
                         Expr::Int32, width);
       updates = UpdateList(array, symbolicUpdates.head);
       knownSymbolics->reset(nullptr);
-      unflushedMask->reset();
+      unflushed.clear();
     }
   }
 
@@ -581,17 +578,79 @@ void ObjectStage::initializeToZero() {
       Expr::Int32, width);
   updates = UpdateList(array, nullptr);
   knownSymbolics->reset();
-  unflushedMask->reset();
+  unflushed.clear();
+}
+
+void ObjectStage::markUnflushed(unsigned offset) {
+  auto next = unflushed.upper_bound(offset);
+  if (next != unflushed.begin()) {
+    auto prev = std::prev(next);
+    if (offset < prev->second) {
+      return;
+    }
+    if (offset == prev->second) {
+      prev->second = offset + 1;
+      if (next != unflushed.end() && next->first == prev->second) {
+        prev->second = next->second;
+        unflushed.erase(next);
+      }
+      return;
+    }
+  }
+  if (next != unflushed.end() && next->first == offset + 1) {
+    unflushed.emplace_hint(next, offset, next->second);
+    unflushed.erase(next);
+  } else {
+    unflushed.emplace_hint(next, offset, offset + 1);
+  }
+}
+
+bool ObjectStage::isUnflushed(unsigned offset) const {
+  auto next = unflushed.upper_bound(offset);
+  return next != unflushed.begin() && offset < std::prev(next)->second;
 }
 
 void ObjectStage::flushForRead() const {
-  for (const auto &unflushed : unflushedMask->storage()) {
-    auto offset = unflushed.first;
-    auto value = knownSymbolics->load(offset);
-    assert(value);
-    updates.extend(ConstantExpr::create(offset, Expr::Int32), value);
+  if (unflushed.empty()) {
+    return;
   }
-  unflushedMask->reset(false);
+
+  // Before the root array is materialized, the concrete bytes can go
+  // straight into it, so that only the symbolic ones become updates. Later
+  // flushes extend the update list instead of creating new root arrays,
+  // which would have to be translated by the solver from scratch.
+  if (!updates.root && !updates.head && isa<ConstantExpr>(size)) {
+    std::unique_ptr<SparseStorage<ref<ConstantExpr>>> values(constructStorage(
+        size, ConstantExpr::create(0, width), MaxFixedSizeStructureSize));
+    UpdateList symbolicUpdates(nullptr, nullptr);
+    for (const auto &[begin, end] : unflushed) {
+      for (unsigned offset = begin; offset < end; ++offset) {
+        auto value = knownSymbolics->load(offset);
+        assert(value);
+        if (auto CE = dyn_cast<ConstantExpr>(value)) {
+          values->store(offset, CE);
+        } else {
+          symbolicUpdates.extend(ConstantExpr::create(offset, Expr::Int32),
+                                 value);
+        }
+      }
+    }
+    auto array =
+        Array::create(size, SourceBuilder::constant(values.release()),
+                      Expr::Int32, width);
+    updates = UpdateList(array, symbolicUpdates.head);
+    unflushed.clear();
+    return;
+  }
+
+  for (const auto &[begin, end] : unflushed) {
+    for (unsigned offset = begin; offset < end; ++offset) {
+      auto value = knownSymbolics->load(offset);
+      assert(value);
+      updates.extend(ConstantExpr::create(offset, Expr::Int32), value);
+    }
+  }
+  unflushed.clear();
 }
 
 void ObjectStage::flushForWrite() {
@@ -606,7 +665,7 @@ ref<Expr> ObjectStage::readWidth(unsigned offset) const {
   if (auto byte = knownSymbolics->load(offset)) {
     return byte;
   } else {
-    assert(!unflushedMask->load(offset) &&
+    assert(!isUnflushed(offset) &&
            "unflushed byte without cache value");
     return ReadExpr::create(
         getUpdates(), ConstantExpr::create(offset, Expr::Int32), safeRead);
@@ -631,7 +690,7 @@ void ObjectStage::writeWidth(unsigned offset, uint64_t value) {
     }
   }
   knownSymbolics->store(offset, ConstantExpr::create(value, width));
-  unflushedMask->store(offset, true);
+  markUnflushed(offset);
 }
 
 void ObjectStage::writeWidth(unsigned offset, ref<Expr> value) {
@@ -644,7 +703,7 @@ void ObjectStage::writeWidth(unsigned offset, ref<Expr> value) {
       return;
     }
     knownSymbolics->store(offset, value);
-    unflushedMask->store(offset, true);
+    markUnflushed(offset);
   }
 }
 
@@ -674,13 +733,27 @@ void ObjectStage::write(const ObjectStage &os) {
     } else {
       bound = osConstSize->getZExtValue();
     }
+    // Bytes below the bound come from os. If os flushed its bytes into
+    // another root array, its known bytes have to be flushed again on top
+    // of ours.
+    bool sameRoot = updates.root == os.updates.root;
+    std::map<unsigned, unsigned> copied;
+    for (const auto &[begin, end] : unflushed) {
+      if (end > bound) {
+        copied.emplace(std::max<size_t>(begin, bound), end);
+      }
+    }
+    unflushed = std::move(copied);
     for (size_t i = 0; i < bound; ++i) {
-      knownSymbolics->store(i, os.knownSymbolics->load(i));
-      unflushedMask->store(i, os.unflushedMask->load(i));
+      auto value = os.knownSymbolics->load(i);
+      knownSymbolics->store(i, value);
+      if (sameRoot ? os.isUnflushed(i) : bool(value)) {
+        markUnflushed(i);
+      }
     }
   } else {
     knownSymbolics.reset(os.knownSymbolics->clone());
-    unflushedMask.reset(os.unflushedMask->clone());
+    unflushed = os.unflushed;
   }
   updates = UpdateList(updates.root, os.updates.head);
 }
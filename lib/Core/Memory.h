@@ -21,6 +21,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
@@ -213,14 +214,13 @@ public:
 class ObjectStage {
 private:
   using storage_ty = SparseStorage<ref<Expr>, OptionalRefEq<Expr>>;
-  using bool_storage_ty = SparseStorage<bool>;
   /// knownSymbolics[byte] holds the expression for byte,
   /// if byte is known
   mutable std::unique_ptr<storage_ty> knownSymbolics;
 
-  /// unflushedMask[byte] is set if byte is unflushed
+  /// disjoint ranges [begin, end) of unflushed bytes, keyed by begin
   /// mutable because may need flushed during read of const
-  mutable std::unique_ptr<bool_storage_ty> unflushedMask;
+  mutable std::map<unsigned, unsigned> unflushed;
 
   // mutable because we may need flush during read of const
   mutable UpdateList updates;
@@ -251,7 +251,7 @@ public:
   void print() const;
 
   size_t getSparseStorageEntries() {
-    return knownSymbolics->storage().size() + unflushedMask->storage().size();
+    return knownSymbolics->storage().size() + unflushed.size();
   }
   void initializeToZero();
 
@@ -260,6 +260,9 @@ private:
 
   void makeConcrete();
 
+  void markUnflushed(unsigned offset);
+  bool isUnflushed(unsigned offset) const;
+
   void flushForRead() const;
   void flushForWrite();
 };
@@ -35,7 +35,7 @@ void PForest::remove(PTreeNode *node) {
 
 void PForest::dump(llvm::raw_ostream &os) {
   for (auto &ntree : trees)
-    ntree.second->dump(os);
+    ntree.second->dump(os, registeredIds);
 }
 
 PForest::~PForest() {
@@ -12,7 +12,6 @@
 #define KLEE_PFOREST_H
 
 #include "PTree.h"
-#include "klee/Support/ErrorHandling.h"
 
 #include <map>
 
@@ -22,8 +21,10 @@ class PTreeNode;
 class PTree;
 
 class PForest {
-  // Number of registered ID
-  int registeredIds = 0;
+  // Number of registered random path searchers
+  unsigned registeredIds = 0;
+  // Number of registered weighted random path searchers
+  unsigned registeredWeights = 0;
   std::map<uint32_t, PTree *> trees;
   // The global tree counter
   std::uint32_t nextID = 1;
@@ -37,14 +38,8 @@ public:
   void remove(PTreeNode *node);
   const std::map<uint32_t, PTree *> &getPTrees() { return trees; }
   void dump(llvm::raw_ostream &os);
-  std::uint8_t getNextId() {
-    std::uint8_t id = 1 << registeredIds++;
-    if (registeredIds > PtrBitCount) {
-      klee_error("PForest cannot support more than %d RandomPathSearchers",
-                 PtrBitCount);
-    }
-    return id;
-  }
+  unsigned getNextId() { return registeredIds++; }
+  unsigned getNextWeightSlot() { return registeredWeights++; }
 };
 } // namespace klee
 
@@ -15,7 +15,7 @@
 #include "klee/Expr/ExprPPrinter.h"
 #include "klee/Support/OptionCategories.h"
 
-#include <bitset>
+#include <algorithm>
 #include <vector>
 
 using namespace klee;
@@ -26,75 +26,106 @@ namespace {
 cl::opt<bool>
     CompressProcessTree("compress-process-tree",
                         cl::desc("Remove intermediate nodes in the process "
-                                 "tree whenever possible (default=false)"),
-                        cl::init(false), cl::cat(MiscCat));
+                                 "tree whenever possible (default=true)"),
+                        cl::init(true), cl::cat(MiscCat));
 
 } // namespace
 
 PTree::PTree(ExecutionState *initialState, uint32_t treeID) {
   id = treeID;
-  root = PTreeNodePtr(new PTreeNode(nullptr, initialState, id));
-  initialState->ptreeNode = root.getPointer();
+  root = createNode(nullptr, initialState);
+}
+
+PTree::~PTree() {
+  // Nodes of states which are still alive are released with the allocator,
+  // but their searcher sets may own memory
+  std::vector<PTreeNode *> stack;
+  if (root)
+    stack.push_back(root);
+  while (!stack.empty()) {
+    PTreeNode *n = stack.back();
+    stack.pop_back();
+    if (n->left)
+      stack.push_back(n->left);
+    if (n->right)
+      stack.push_back(n->right);
+    destroyNode(n);
+  }
+}
+
+PTreeNode *PTree::createNode(PTreeNode *parent, ExecutionState *state) {
+  return new (allocator.Allocate()) PTreeNode(parent, state, id);
+}
+
+void PTree::destroyNode(PTreeNode *node) {
+  node->~PTreeNode();
+  allocator.Deallocate(node);
 }
 
 void PTree::attach(PTreeNode *node, ExecutionState *leftState,
                    ExecutionState *rightState) {
-  assert(node && !node->left.getPointer() && !node->right.getPointer());
+  assert(node && !node->left && !node->right);
   assert(node == rightState->ptreeNode &&
          "Attach assumes the right state is the current state");
   node->state = nullptr;
-  node->left = PTreeNodePtr(new PTreeNode(node, leftState, id));
-  // The current node inherits the tag
-  uint8_t currentNodeTag = root.getInt();
-  if (node->parent)
-    currentNodeTag = node->parent->left.getPointer() == node
-                         ? node->parent->left.getInt()
-                         : node->parent->right.getInt();
-  node->right =
-      PTreeNodePtr(new PTreeNode(node, rightState, id), currentNodeTag);
+  node->left = createNode(node, leftState);
+  node->right = createNode(node, rightState);
+  // The current state stays in the same searchers with the same weights
+  node->right->searchers = node->searchers;
+  node->right->weights = node->weights;
 }
 
 void PTree::remove(PTreeNode *n) {
-  assert(!n->left.getPointer() && !n->right.getPointer());
+  assert(!n->left && !n->right);
   do {
     PTreeNode *p = n->parent;
     if (p) {
-      if (n == p->left.getPointer()) {
-        p->left = PTreeNodePtr(nullptr);
+      if (n == p->left) {
+        p->left = nullptr;
       } else {
-        assert(n == p->right.getPointer());
-        p->right = PTreeNodePtr(nullptr);
+        assert(n == p->right);
+        p->right = nullptr;
       }
+    } else {
+      root = nullptr;
     }
-    delete n;
+    destroyNode(n);
     n = p;
-  } while (n && !n->left.getPointer() && !n->right.getPointer());
+  } while (n && !n->left && !n->right);
 
   if (n && CompressProcessTree) {
     // We're now at a node that has exactly one child; we've just deleted the
     // other one. Eliminate the node and connect its child to the parent
-    // directly (if it's not the root).
-    PTreeNodePtr child = n->left.getPointer() ? n->left : n->right;
+    // directly (if it's not the root). Since every other internal node has
+    // two children, no unary chains remain.
+    PTreeNode *child = n->left ? n->left : n->right;
     PTreeNode *parent = n->parent;
 
-    child.getPointer()->parent = parent;
+    child->parent = parent;
     if (!parent) {
       // We're at the root.
       root = child;
     } else {
-      if (n == parent->left.getPointer()) {
+      if (n == parent->left) {
         parent->left = child;
       } else {
-        assert(n == parent->right.getPointer());
+        assert(n == parent->right);
         parent->right = child;
       }
     }
 
-    delete n;
+    destroyNode(n);
   }
 }
 
-void PTree::dump(llvm::raw_ostream &os) {
+static std::string searchersLabel(const PTreeNode *n, unsigned numSearchers) {
+  std::string label = "0b";
+  for (unsigned i = std::max(numSearchers, 1U); i-- > 0;)
+    label += n->belongsTo(i) ? '1' : '0';
+  return label;
+}
+
+void PTree::dump(llvm::raw_ostream &os, unsigned numSearchers) {
   ExprPPrinter *pp = ExprPPrinter::create(os);
   pp->setNewline("\\l");
   os << "digraph G {\n";
@@ -105,7 +136,8 @@ void PTree::dump(llvm::raw_ostream &os) {
   os << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n";
   os << "\tedge [arrowsize=.3]\n";
   std::vector<const PTreeNode *> stack;
-  stack.push_back(root.getPointer());
+  if (root)
+    stack.push_back(root);
   while (!stack.empty()) {
     const PTreeNode *n = stack.back();
     stack.pop_back();
@@ -113,17 +145,15 @@ void PTree::dump(llvm::raw_ostream &os) {
     if (n->state)
       os << ",fillcolor=green";
     os << "];\n";
-    if (n->left.getPointer()) {
-      os << "\tn" << n << " -> n" << n->left.getPointer();
-      os << " [label=0b"
-         << std::bitset<PtrBitCount>(n->left.getInt()).to_string() << "];\n";
-      stack.push_back(n->left.getPointer());
+    if (n->left) {
+      os << "\tn" << n << " -> n" << n->left;
+      os << " [label=" << searchersLabel(n->left, numSearchers) << "];\n";
+      stack.push_back(n->left);
     }
-    if (n->right.getPointer()) {
-      os << "\tn" << n << " -> n" << n->right.getPointer();
-      os << " [label=0b"
-         << std::bitset<PtrBitCount>(n->right.getInt()).to_string() << "];\n";
-      stack.push_back(n->right.getPointer());
+    if (n->right) {
+      os << "\tn" << n << " -> n" << n->right;
+      os << " [label=" << searchersLabel(n->right, numSearchers) << "];\n";
+      stack.push_back(n->right);
     }
   }
   os << "}\n";
@@ -133,6 +163,4 @@ void PTree::dump(llvm::raw_ostream &os) {
 PTreeNode::PTreeNode(PTreeNode *parent, ExecutionState *state, uint32_t id)
     : parent{parent}, state{state}, treeID{id} {
   state->ptreeNode = this;
-  left = PTreeNodePtr(nullptr);
-  right = PTreeNodePtr(nullptr);
 }
@@ -13,51 +13,83 @@
 #include "klee/Core/BranchTypes.h"
 #include "klee/Expr/Expr.h"
 
-#include "llvm/ADT/PointerIntPair.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/RecyclingAllocator.h"
 
 namespace klee {
 class ExecutionState;
-class PTreeNode;
-/* PTreeNodePtr is used by the Random Path Searcher object to efficiently
-record which PTreeNode belongs to it. PTree is a global structure that
-captures all  states, whereas a Random Path Searcher might only care about
-a subset. The integer part of PTreeNodePtr is a bitmask (a "tag") of which
-Random Path Searchers PTreeNode belongs to. */
-constexpr int PtrBitCount = 3;
-using PTreeNodePtr = llvm::PointerIntPair<PTreeNode *, PtrBitCount, uint8_t>;
 
 class PTreeNode {
 public:
   PTreeNode *parent = nullptr;
 
-  PTreeNodePtr left;
-  PTreeNodePtr right;
+  PTreeNode *left = nullptr;
+  PTreeNode *right = nullptr;
   ExecutionState *state = nullptr;
 
   std::uint32_t treeID;
 
+  /* Random path searchers only care about a subset of all states, so each
+  node records which of them have a state in its subtree, indexed by the id
+  the PForest handed out to the searcher. */
+  llvm::SmallBitVector searchers;
+
+  /* Weighted random path searchers keep the total weight of their states in
+  the subtree, indexed by the weight slot the PForest handed out to them. */
+  llvm::SmallVector<double, 1> weights;
+
   PTreeNode(const PTreeNode &) = delete;
   PTreeNode(PTreeNode *parent, ExecutionState *state, std::uint32_t id);
   ~PTreeNode() = default;
 
   std::uint32_t getTreeID() const { return treeID; };
+
+  bool belongsTo(unsigned searcherID) const {
+    return searcherID < searchers.size() && searchers.test(searcherID);
+  }
+  void addSearcher(unsigned searcherID) {
+    if (searcherID >= searchers.size())
+      searchers.resize(searcherID + 1);
+    searchers.set(searcherID);
+  }
+  void removeSearcher(unsigned searcherID) {
+    if (searcherID < searchers.size())
+      searchers.reset(searcherID);
+  }
+
+  double getWeight(unsigned slot) const {
+    return slot < weights.size() ? weights[slot] : 0.;
+  }
+  void setWeight(unsigned slot, double weight) {
+    if (slot >= weights.size())
+      weights.resize(slot + 1, 0.);
+    weights[slot] = weight;
+  }
 };
 
 class PTree {
 private:
   // The tree id
   uint32_t id;
+  // Nodes are recycled rather than returned to the system allocator, as
+  // states fork and terminate at a high rate
+  llvm::RecyclingAllocator<llvm::BumpPtrAllocator, PTreeNode> allocator;
+
+  PTreeNode *createNode(PTreeNode *parent, ExecutionState *state);
+  void destroyNode(PTreeNode *node);
 
 public:
-  PTreeNodePtr root;
+  PTreeNode *root;
   PTree(ExecutionState *initialState, uint32_t id);
   explicit PTree(ExecutionState *initialState) : PTree(initialState, 0) {}
-  ~PTree() = default;
+  ~PTree();
 
   void attach(PTreeNode *node, ExecutionState *leftState,
               ExecutionState *rightState);
   void remove(PTreeNode *node);
-  void dump(llvm::raw_ostream &os);
+  void dump(llvm::raw_ostream &os, unsigned numSearchers);
   std::uint32_t getID() const { return id; };
 };
 } // namespace klee
@@ -351,22 +351,22 @@ void GuidedSearcher::printName(llvm::raw_ostream &os) {
 WeightedRandomSearcher::WeightedRandomSearcher(WeightType type, RNG &rng)
     : states(std::make_unique<
              DiscretePDF<ExecutionState *, ExecutionStateIDCompare>>()),
-      theRNG{rng}, type(type) {
+      theRNG{rng}, type(type), updateWeights(hasChangingWeights(type)) {}
 
+bool WeightedRandomSearcher::hasChangingWeights(WeightType type) {
   switch (type) {
   case Depth:
   case RP:
-    updateWeights = false;
-    break;
+    return false;
   case InstCount:
   case CPInstCount:
   case QueryCost:
   case MinDistToUncovered:
   case CoveringNew:
-    updateWeights = true;
-    break;
+    return true;
   default:
     assert(0 && "invalid weight type");
+    return false;
   }
 }
 
@@ -374,7 +374,7 @@ ExecutionState &WeightedRandomSearcher::selectState() {
   return *states->choose(theRNG.getDoubleL());
 }
 
-double WeightedRandomSearcher::getWeight(ExecutionState *es) {
+double WeightedRandomSearcher::getWeight(WeightType type, ExecutionState *es) {
   switch (type) {
   default:
   case Depth:
@@ -423,11 +423,11 @@ void WeightedRandomSearcher::update(
   if (current && updateWeights &&
       std::find(removedStates.begin(), removedStates.end(), current) ==
           removedStates.end())
-    states->update(current, getWeight(current));
+    states->update(current, getWeight(type, current));
 
   // insert states
   for (const auto state : addedStates)
-    states->insert(state, getWeight(state));
+    states->insert(state, getWeight(type, state));
 
   // remove states
   for (const auto state : removedStates)
@@ -468,40 +468,33 @@ void WeightedRandomSearcher::printName(llvm::raw_ostream &os) {
 
 ///
 
-// Check if n is a valid pointer and a node belonging to us
-#define IS_OUR_NODE_VALID(n)                                                   \
-  (((n).getPointer() != nullptr) && (((n).getInt() & idBitMask) != 0))
-
 RandomPathSearcher::RandomPathSearcher(PForest &processForest, RNG &rng)
     : processForest{processForest}, theRNG{rng},
-      idBitMask{processForest.getNextId()} {};
+      id{processForest.getNextId()} {};
 
 ExecutionState &RandomPathSearcher::selectState() {
   unsigned flips = 0, bits = 0, range = 0;
-  PTreeNodePtr *root = nullptr;
-  while (!root || !IS_OUR_NODE_VALID(*root))
-    root = &processForest.getPTrees()
-                .at(range++ % processForest.getPTrees().size() + 1)
-                ->root;
-  assert(root->getInt() & idBitMask && "Root should belong to the searcher");
-  PTreeNode *n = root->getPointer();
+  PTreeNode *n = nullptr;
+  while (!isOurNode(n))
+    n = processForest.getPTrees()
+            .at(range++ % processForest.getPTrees().size() + 1)
+            ->root;
   while (!n->state) {
-    if (!IS_OUR_NODE_VALID(n->left)) {
-      assert(IS_OUR_NODE_VALID(n->right) &&
-             "Both left and right nodes invalid");
-      assert(n != n->right.getPointer());
-      n = n->right.getPointer();
-    } else if (!IS_OUR_NODE_VALID(n->right)) {
-      assert(IS_OUR_NODE_VALID(n->left) && "Both right and left nodes invalid");
-      assert(n != n->left.getPointer());
-      n = n->left.getPointer();
+    if (!isOurNode(n->left)) {
+      assert(isOurNode(n->right) && "Both left and right nodes invalid");
+      assert(n != n->right);
+      n = n->right;
+    } else if (!isOurNode(n->right)) {
+      assert(isOurNode(n->left) && "Both right and left nodes invalid");
+      assert(n != n->left);
+      n = n->left;
     } else {
       if (bits == 0) {
         flips = theRNG.getInt32();
         bits = 32;
       }
       --bits;
-      n = ((flips & (1U << bits)) ? n->left : n->right).getPointer();
+      n = (flips & (1U << bits)) ? n->left : n->right;
     }
   }
 
@@ -513,42 +506,19 @@ void RandomPathSearcher::update(
     const std::vector<ExecutionState *> &removedStates) {
   // insert states
   for (auto &es : addedStates) {
-    PTreeNode *pnode = es->ptreeNode, *parent = pnode->parent;
-    PTreeNodePtr &root = processForest.getPTrees().at(pnode->getTreeID())->root;
-    PTreeNodePtr *childPtr;
-
-    childPtr = parent ? ((parent->left.getPointer() == pnode) ? &parent->left
-                                                              : &parent->right)
-                      : &root;
-    while (pnode && !IS_OUR_NODE_VALID(*childPtr)) {
-      childPtr->setInt(childPtr->getInt() | idBitMask);
-      pnode = parent;
-      if (pnode)
-        parent = pnode->parent;
-
-      childPtr = parent
-                     ? ((parent->left.getPointer() == pnode) ? &parent->left
-                                                             : &parent->right)
-                     : &root;
+    for (PTreeNode *pnode = es->ptreeNode; pnode && !isOurNode(pnode);
+         pnode = pnode->parent) {
+      pnode->addSearcher(id);
     }
   }
 
   // remove states
   for (auto es : removedStates) {
-    PTreeNode *pnode = es->ptreeNode, *parent = pnode->parent;
-    PTreeNodePtr &root = processForest.getPTrees().at(pnode->getTreeID())->root;
-
-    while (pnode && !IS_OUR_NODE_VALID(pnode->left) &&
-           !IS_OUR_NODE_VALID(pnode->right)) {
-      auto childPtr =
-          parent ? ((parent->left.getPointer() == pnode) ? &parent->left
-                                                         : &parent->right)
-                 : &root;
-      assert(IS_OUR_NODE_VALID(*childPtr) && "Removing pTree child not ours");
-      childPtr->setInt(childPtr->getInt() & ~idBitMask);
-      pnode = parent;
-      if (pnode)
-        parent = pnode->parent;
+    for (PTreeNode *pnode = es->ptreeNode;
+         pnode && !isOurNode(pnode->left) && !isOurNode(pnode->right);
+         pnode = pnode->parent) {
+      assert(isOurNode(pnode) && "Removing pTree child not ours");
+      pnode->removeSearcher(id);
     }
   }
 }
@@ -556,7 +526,7 @@ void RandomPathSearcher::update(
 bool RandomPathSearcher::empty() {
   bool res = true;
   for (const auto &ntree : processForest.getPTrees())
-    res = res && !IS_OUR_NODE_VALID(ntree.second->root);
+    res = res && !isOurNode(ntree.second->root);
   return res;
 }
 
@@ -566,6 +536,105 @@ void RandomPathSearcher::printName(llvm::raw_ostream &os) {
 
 ///
 
+WeightedRandomPathSearcher::WeightedRandomPathSearcher(
+    PForest &processForest, WeightedRandomSearcher::WeightType type, RNG &rng)
+    : processForest{processForest}, theRNG{rng}, type{type},
+      updateWeights{WeightedRandomSearcher::hasChangingWeights(type)},
+      id{processForest.getNextId()},
+      slot{processForest.getNextWeightSlot()} {}
+
+void WeightedRandomPathSearcher::setWeight(PTreeNode *leaf, double weight) {
+  leaf->setWeight(slot, weight);
+  for (PTreeNode *n = leaf->parent; n; n = n->parent) {
+    n->setWeight(slot, getSubtreeWeight(n->left) + getSubtreeWeight(n->right));
+  }
+}
+
+ExecutionState &WeightedRandomPathSearcher::selectState() {
+  unsigned range = 0;
+  PTreeNode *n = nullptr;
+  while (!isOurNode(n))
+    n = processForest.getPTrees()
+            .at(range++ % processForest.getPTrees().size() + 1)
+            ->root;
+  while (!n->state) {
+    if (!isOurNode(n->left)) {
+      assert(isOurNode(n->right) && "Both left and right nodes invalid");
+      n = n->right;
+    } else if (!isOurNode(n->right)) {
+      assert(isOurNode(n->left) && "Both right and left nodes invalid");
+      n = n->left;
+    } else {
+      double left = getSubtreeWeight(n->left);
+      double total = left + getSubtreeWeight(n->right);
+      // Subtrees whose states all weigh nothing are as likely as others
+      bool goLeft =
+          total > 0. ? theRNG.getDoubleL() * total < left : theRNG.getBool();
+      n = goLeft ? n->left : n->right;
+    }
+  }
+
+  return *n->state;
+}
+
+void WeightedRandomPathSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  // update current
+  if (current && updateWeights && isOurNode(current->ptreeNode) &&
+      std::find(removedStates.begin(), removedStates.end(), current) ==
+          removedStates.end())
+    setWeight(current->ptreeNode,
+              WeightedRandomSearcher::getWeight(type, current));
+
+  // insert states
+  for (auto es : addedStates) {
+    for (PTreeNode *pnode = es->ptreeNode; pnode && !isOurNode(pnode);
+         pnode = pnode->parent) {
+      pnode->addSearcher(id);
+    }
+    setWeight(es->ptreeNode, WeightedRandomSearcher::getWeight(type, es));
+  }
+
+  // remove states
+  for (auto es : removedStates) {
+    setWeight(es->ptreeNode, 0.);
+    for (PTreeNode *pnode = es->ptreeNode;
+         pnode && !isOurNode(pnode->left) && !isOurNode(pnode->right);
+         pnode = pnode->parent) {
+      assert(isOurNode(pnode) && "Removing pTree child not ours");
+      pnode->removeSearcher(id);
+    }
+  }
+}
+
+bool WeightedRandomPathSearcher::empty() {
+  bool res = true;
+  for (const auto &ntree : processForest.getPTrees())
+    res = res && !isOurNode(ntree.second->root);
+  return res;
+}
+
+void WeightedRandomPathSearcher::printName(llvm::raw_ostream &os) {
+  os << "WeightedRandomPathSearcher::";
+  switch (type) {
+  case WeightedRandomSearcher::Depth:
+    os << "Depth\n";
+    return;
+  case WeightedRandomSearcher::MinDistToUncovered:
+    os << "MinDistToUncovered\n";
+    return;
+  case WeightedRandomSearcher::CoveringNew:
+    os << "CoveringNew\n";
+    return;
+  default:
+    os << "<unknown type>\n";
+    return;
+  }
+}
+
+///
+
 BatchingSearcher::BatchingSearcher(Searcher *baseSearcher,
                                    time::Span timeBudget,
                                    unsigned instructionBudget)
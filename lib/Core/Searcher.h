@@ -78,7 +78,10 @@ public:
     NURS_RP,
     NURS_ICnt,
     NURS_CPICnt,
-    NURS_QC
+    NURS_QC,
+    RandomPath_CovNew,
+    RandomPath_MD2U,
+    RandomPath_Depth
   };
 };
 
@@ -225,14 +228,17 @@ private:
   WeightType type;
   bool updateWeights;
 
-  double getWeight(ExecutionState *);
-
 public:
   /// \param type The WeightType that determines the underlying heuristic.
   /// \param RNG A random number generator.
   WeightedRandomSearcher(WeightType type, RNG &rng);
   ~WeightedRandomSearcher() override = default;
 
+  /// \return The weight of \p es under the heuristic \p type.
+  static double getWeight(WeightType type, ExecutionState *es);
+  /// \return True if weights under \p type change while a state executes.
+  static bool hasChangingWeights(WeightType type);
+
   ExecutionState &selectState() override;
   void update(ExecutionState *current,
               const std::vector<ExecutionState *> &addedStates,
@@ -247,22 +253,18 @@ public:
 ///
 /// To support this, RandomPathSearcher has a subgraph view of PTree, in that it
 /// only walks the PTreeNodes that it "owns". Ownership is stored in the
-/// getInt method of the PTreeNodePtr class (which hides it in the pointer
-/// itself).
-///
-/// The current implementation of PTreeNodePtr supports only 3 instances of the
-/// RandomPathSearcher. This is because the current PTreeNodePtr implementation
-/// conforms to C++ and only steals the last 3 alignment bits. This restriction
-/// could be relaxed slightly by an architecture-specific implementation of
-/// PTreeNodePtr that also steals the top bits of the pointer.
+/// searchers bitmap of each PTreeNode, indexed by the id of the searcher, so
+/// there is no limit on the number of RandomPathSearchers.
 ///
 /// The ownership bits are maintained in the update method.
 class RandomPathSearcher final : public Searcher {
   PForest &processForest;
   RNG &theRNG;
 
-  // Unique bitmask of this searcher
-  const uint8_t idBitMask;
+  // Unique id of this searcher
+  const unsigned id;
+
+  bool isOurNode(const PTreeNode *n) const { return n && n->belongsTo(id); }
 
 public:
   /// \param processTree The process tree.
@@ -278,6 +280,50 @@ public:
   void printName(llvm::raw_ostream &os) override;
 };
 
+/// WeightedRandomPathSearcher walks the PTree like RandomPathSearcher, but at
+/// every node it descends into a subtree with probability proportional to the
+/// total weight of the states of the subtree, so that each state is selected
+/// with probability proportional to its weight. The weights are those of
+/// WeightedRandomSearcher.
+///
+/// Each PTreeNode caches the total weight of the subtree in the weight slot of
+/// the searcher. The update method sets the weight of a leaf and recomputes
+/// the totals on the path to the root, so both updates and selections visit
+/// one node per fork between live states rather than every state.
+class WeightedRandomPathSearcher final : public Searcher {
+  PForest &processForest;
+  RNG &theRNG;
+  WeightedRandomSearcher::WeightType type;
+  bool updateWeights;
+
+  // Unique id of this searcher
+  const unsigned id;
+  // Weight slot of this searcher
+  const unsigned slot;
+
+  bool isOurNode(const PTreeNode *n) const { return n && n->belongsTo(id); }
+  double getSubtreeWeight(const PTreeNode *n) const {
+    return isOurNode(n) ? n->getWeight(slot) : 0.;
+  }
+  void setWeight(PTreeNode *leaf, double weight);
+
+public:
+  /// \param processForest The process forest.
+  /// \param type The WeightType that determines the weights of states.
+  /// \param RNG A random number generator.
+  WeightedRandomPathSearcher(PForest &processForest,
+                             WeightedRandomSearcher::WeightType type,
+                             RNG &rng);
+  ~WeightedRandomPathSearcher() override = default;
+
+  ExecutionState &selectState() override;
+  void update(ExecutionState *current,
+              const std::vector<ExecutionState *> &addedStates,
+              const std::vector<ExecutionState *> &removedStates) override;
+  bool empty() override;
+  void printName(llvm::raw_ostream &os) override;
+};
+
 /// BatchingSearcher selects a state from an underlying searcher and returns
 /// that state for further exploration for a given time or a given number
 /// of instructions.
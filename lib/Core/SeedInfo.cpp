@@ -22,7 +22,22 @@
 
 using namespace klee;
 
+SeedInput::~SeedInput() {
+  if (input)
+    kTest_free(input);
+}
+
+KTest *SeedInput::get() {
+  if (!input) {
+    input = kTest_fromFileMapped(path.c_str());
+    if (!input)
+      klee_error("unable to open seed: %s", path.c_str());
+  }
+  return input;
+}
+
 KTestObject *SeedInfo::getNextInput(const MemoryObject *mo, bool byName) {
+  KTest *input = source->get();
   if (byName) {
     unsigned i;
 
@@ -12,7 +12,9 @@
 
 #include "klee/Expr/Assignment.h"
 
+#include <memory>
 #include <set>
+#include <string>
 
 extern "C" {
 struct KTest;
@@ -24,15 +26,33 @@ class ExecutionState;
 class TimingSolver;
 class MemoryObject;
 
+/// SeedInput - A seed file, read when its values are first needed and
+/// released together with the last SeedInfo using it.
+class SeedInput {
+  std::string path;
+  KTest *input = nullptr;
+
+public:
+  explicit SeedInput(std::string _path) : path(std::move(_path)) {}
+  ~SeedInput();
+
+  SeedInput(const SeedInput &) = delete;
+  SeedInput &operator=(const SeedInput &) = delete;
+
+  KTest *get();
+};
+
 class SeedInfo {
+  std::shared_ptr<SeedInput> source;
+
 public:
   Assignment assignment;
-  KTest *input;
   unsigned inputPosition;
   std::set<struct KTestObject *> used;
 
 public:
-  explicit SeedInfo(KTest *_input) : input(_input), inputPosition(0) {}
+  explicit SeedInfo(std::shared_ptr<SeedInput> _source)
+      : source(std::move(_source)), inputPosition(0) {}
 
   KTestObject *getNextInput(const MemoryObject *mo, bool byName);
 
@@ -12,11 +12,13 @@
 #include "ExecutionState.h"
 
 #include "klee/Core/TerminationTypes.h"
+#include "klee/Expr/ExprStats.h"
 #include "klee/Module/KInstruction.h"
 #include "klee/Module/KModule.h"
 #include "klee/Module/LocationInfo.h"
 #include "klee/Solver/SolverStats.h"
 #include "klee/Statistics/Statistics.h"
+#include "klee/Support/CoverageFile.h"
 #include "klee/Support/ErrorHandling.h"
 #include "klee/Support/ModuleUtil.h"
 #include "klee/System/MemoryUsage.h"
@@ -27,7 +29,6 @@
 #include "MemoryManager.h"
 #include "UserSearcher.h"
 
-#include "llvm/ADT/SmallBitVector.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
@@ -39,8 +40,14 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 
+#include <algorithm>
+#include <map>
+#include <queue>
 #include <unistd.h>
+#include <unordered_map>
 
 using namespace klee;
 using namespace llvm;
@@ -86,6 +93,13 @@ cl::opt<unsigned> CommitEvery(
              "-stats-write-after-instructions. (default=0)"),
     cl::cat(StatsCat));
 
+cl::opt<bool> OutputCoverageBitmap(
+    "output-coverage-bitmap", cl::init(false),
+    cl::desc("Write binary instruction and branch coverage bitmaps (run.cov) "
+             "which can be merged across runs with klee-cov-merge. Requires "
+             "--output-istats (default=false)"),
+    cl::cat(StatsCat));
+
 cl::opt<std::string> IStatsWriteInterval(
     "istats-write-interval", cl::init("10s"),
     cl::desc(
@@ -144,6 +158,12 @@ cl::opt<bool> UseCallPaths("use-call-paths", cl::init(true),
                                     "level statistics (default=true)"),
                            cl::cat(StatsCat));
 
+cl::opt<unsigned> CallPathMaxDepth(
+    "call-path-max-depth", cl::init(0),
+    cl::desc("Track call paths up to this depth; deeper calls are summarized "
+             "on the last level (default=0 (no limit))"),
+    cl::cat(StatsCat));
+
 } // namespace klee
 
 ///
@@ -176,6 +196,62 @@ static bool instructionIsCoverable(Instruction *i) {
   return true;
 }
 
+namespace klee {
+struct IStatsCallRow {
+  const llvm::Function *callee;
+  unsigned count;
+  std::vector<uint64_t> values;
+
+  bool operator==(const IStatsCallRow &other) const {
+    return callee == other.callee && count == other.count &&
+           values == other.values;
+  }
+};
+
+typedef std::map<const llvm::Instruction *, std::vector<IStatsCallRow>>
+    IStatsCallTable;
+
+/// The part of run.istats which only depends on the module. It is computed
+/// once on the interpreter thread, so that the writer thread can render a
+/// snapshot without touching LLVM or the statistic manager.
+struct IStatsLayout {
+  struct Line {
+    /// "fl="/"fn=" records emitted before this instruction
+    std::string header;
+    /// "<asm line> <source line> " position of the instruction
+    std::string position;
+    /// source file in effect after the header
+    std::string sourceFile;
+    unsigned index;
+    const llvm::Instruction *callSite;
+  };
+
+  struct Callee {
+    std::string file;
+    std::string name;
+    std::string position;
+  };
+
+  std::string header;
+  std::vector<Line> lines;
+  std::unordered_map<const llvm::Function *, Callee> callees;
+  std::vector<Statistic *> stats;
+
+  // Writer thread side: values and rendered text of the last dump, so that
+  // only lines whose counters changed are formatted again.
+  std::vector<uint64_t> lastValues;
+  std::vector<std::string> lastText;
+  IStatsCallTable lastCalls;
+};
+
+/// A copy of the counters referenced by run.istats, taken on the
+/// interpreter thread.
+struct IStatsSnapshot {
+  std::vector<uint64_t> values;
+  IStatsCallTable calls;
+};
+} // namespace klee
+
 std::string sqlite3ErrToStringAndFree(const std::string &prefix,
                                       char *sqlite3ErrMsg) {
   std::ostringstream sstream;
@@ -189,7 +265,7 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     : executor(_executor), objectFilename(_objectFilename),
       startWallTime(time::getWallTime()), numBranches(0), fullBranches(0),
       partialBranches(0), totalBranches(0), totalInstructions(0),
-      localInstructionCount(0),
+      localInstructionCount(0), callPathManager(CallPathMaxDepth),
       updateMinDistToUncovered(_updateMinDistToUncovered),
       releaseStates(false) {
 
@@ -228,6 +304,12 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
   if (useStatistics() || userSearcherRequiresMD2U())
     theStatisticManager->useIndexedStats(km->getMaxGlobalIndex());
 
+  if (OutputStats || OutputIStats)
+    writer = std::make_unique<StatsWriter>();
+
+  if (OutputIStats)
+    uncoveredCoverable.resize(km->getMaxGlobalIndex());
+
   for (auto &kfp : km->functions) {
     KFunction *kf = kfp.get();
 
@@ -239,6 +321,7 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
         theStatisticManager->setIndex(id);
         if (instructionIsCoverable(ki->inst())) {
           ++stats::uncoveredInstructions;
+          uncoveredCoverable.set(id);
         }
       }
 
@@ -326,18 +409,27 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
   }
 
   if (OutputIStats) {
-    istatsFile = executor.interpreterHandler->openOutputFile("run.istats");
-    if (istatsFile) {
-      if (iStatsWriteInterval)
-        executor.timers.add(std::make_unique<Timer>(iStatsWriteInterval,
-                                                    [&] { writeIStats(); }));
-    } else {
-      klee_error("Unable to open instruction level stats file (run.istats).");
+    // run.istats is rewritten through a temporary file and renamed into place,
+    // so readers never observe a partially written file.
+    istatsFilename =
+        executor.interpreterHandler->getOutputFilename("run.istats");
+    {
+      std::error_code ec;
+      llvm::raw_fd_ostream probe(istatsFilename, ec, sys::fs::OF_None);
+      if (ec)
+        klee_error("Unable to open instruction level stats file (run.istats).");
     }
+    istatsLayout = buildIStatsLayout();
+    if (iStatsWriteInterval)
+      executor.timers.add(std::make_unique<Timer>(iStatsWriteInterval,
+                                                  [&] { writeIStats(); }));
   }
 }
 
 StatsTracker::~StatsTracker() {
+  // drain pending writes before tearing down the database
+  writer.reset();
+
   if (statsFile) {
     auto rc = sqlite3_step(transactionEndStmt);
     if (rc != SQLITE_DONE) {
@@ -358,9 +450,15 @@ void StatsTracker::done() {
   if (OutputIStats) {
     if (updateMinDistToUncovered)
       computeReachableUncovered();
-    if (istatsFile)
+    if (istatsLayout)
       writeIStats();
   }
+
+  if (OutputCoverageBitmap)
+    writeCoverageBitmap();
+
+  if (writer)
+    writer->flush();
 }
 
 void StatsTracker::stepInstruction(ExecutionState &es) {
@@ -383,37 +481,40 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
       }
     }
 
-    Instruction *inst = es.pc->inst();
     const KInstruction *ki = es.pc;
-    auto &sf = es.stack.infoStack().back();
-    theStatisticManager->setIndex(ki->getGlobalIndex());
+    unsigned index = ki->getGlobalIndex();
+    theStatisticManager->setIndex(index);
     if (UseCallPaths)
-      theStatisticManager->setContext(&sf.callPathNode->statistics);
+      theStatisticManager->setContext(
+          &es.stack.infoStack().back().callPathNode->statistics);
 
     if (es.instsSinceCovNew)
       ++es.instsSinceCovNew;
 
-    if (instructionIsCoverable(inst)) {
-      if (!theStatisticManager->getIndexedValue(stats::coveredInstructions,
-                                                ki->getGlobalIndex())) {
-        // Checking for actual stoppoints avoids inconsistencies due
-        // to line number propogation.
-        //
-        // FIXME: This trick no longer works, we should fix this in the line
-        // number propogation.
-        es.coveredLines[ki->getSourceFilepath()].insert(ki->getLine());
-        es.instsSinceCovNew = 1;
-        ++stats::coveredInstructions;
-        stats::uncoveredInstructions += (uint64_t)-1;
-      }
+    // Uncoverable and already covered instructions are cleared in the same
+    // bitmap, so the common case is a single test
+    if (uncoveredCoverable.test(index)) {
+      uncoveredCoverable.reset(index);
+      es.coveredInstructions.set(index);
+      es.instsSinceCovNew = 1;
+      ++stats::coveredInstructions;
+      stats::uncoveredInstructions += (uint64_t)-1;
+      if (uncoveredDistance)
+        newlyCovered.push_back(index);
     }
+
+    // Newly covered instructions are folded into the distances once per
+    // basic block, so that searchers see them without waiting for the next
+    // full update.
+    if (ki->inst()->isTerminator())
+      updateReachableUncovered();
   }
 
   if (statsFile && StatsWriteAfterInstructions &&
       stats::instructions % StatsWriteAfterInstructions.getValue() == 0)
     writeStatsLine();
 
-  if (istatsFile && IStatsWriteAfterInstructions &&
+  if (istatsLayout && IStatsWriteAfterInstructions &&
       stats::instructions % IStatsWriteAfterInstructions.getValue() == 0)
     writeIStats();
 
@@ -507,17 +608,26 @@ void StatsTracker::writeStatsHeader() {
          << "CoveredInstructions INTEGER,"
          << "UncoveredInstructions INTEGER,"
          << "QueryTime INTEGER,"
+         << "TranslationTime INTEGER,"
          << "SolverTime INTEGER,"
          << "CexCacheTime INTEGER,"
+         << "CexCacheLookupTime INTEGER,"
          << "ForkTime INTEGER,"
          << "ResolveTime INTEGER,"
+         << "ArrayOptimizationTime INTEGER,"
          << "QueryCacheMisses INTEGER,"
          << "QueryCacheHits INTEGER,"
          << "QueryCexCacheMisses INTEGER,"
          << "QueryCexCacheHits INTEGER,"
+         << "CexCacheProbes INTEGER,"
+         << "CexCacheEvictions INTEGER,"
+         << "SimplificationCacheMisses INTEGER,"
+         << "SimplificationCacheHits INTEGER,"
          << "InhibitedForks INTEGER,"
          << "ExternalCalls INTEGER,"
          << "Allocations INTEGER,"
+         << "BoundsChecks INTEGER,"
+         << "RangeBoundsChecks INTEGER,"
          << "States INTEGER," BRANCH_TYPES TERMINATION_CLASSES
          << "ArrayHashTime INTEGER" << ')';
   char *zErrMsg = nullptr;
@@ -556,17 +666,26 @@ void StatsTracker::writeStatsHeader() {
          << "CoveredInstructions,"
          << "UncoveredInstructions,"
          << "QueryTime,"
+         << "TranslationTime,"
          << "SolverTime,"
          << "CexCacheTime,"
+         << "CexCacheLookupTime,"
          << "ForkTime,"
          << "ResolveTime,"
+         << "ArrayOptimizationTime,"
          << "QueryCacheMisses,"
          << "QueryCacheHits,"
          << "QueryCexCacheMisses,"
          << "QueryCexCacheHits,"
+         << "CexCacheProbes,"
+         << "CexCacheEvictions,"
+         << "SimplificationCacheMisses,"
+         << "SimplificationCacheHits,"
          << "InhibitedForks,"
          << "ExternalCalls,"
          << "Allocations,"
+         << "BoundsChecks,"
+         << "RangeBoundsChecks,"
          << "States," BRANCH_TYPES TERMINATION_CLASSES << "ArrayHashTime"
          << ')';
 #undef BTYPE
@@ -599,6 +718,15 @@ void StatsTracker::writeStatsHeader() {
          << "?,"
          << "?,"
          << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
          << "?," BRANCH_TYPES TERMINATION_CLASSES << "? " << ')';
 
   if (sqlite3_prepare_v2(statsFile, insert.str().c_str(), -1, &insertStmt,
@@ -614,63 +742,80 @@ time::Span StatsTracker::elapsed() {
 
 void StatsTracker::writeStatsLine() {
 #undef BTYPE
-#define BTYPE(Name, I)                                                         \
-  sqlite3_bind_int64(insertStmt, arg++, stats::branches##Name);
+#define BTYPE(Name, I) row.push_back(stats::branches##Name);
 #undef TCLASS
-#define TCLASS(Name, I)                                                        \
-  sqlite3_bind_int64(insertStmt, arg++, stats::termination##Name);
-  int arg = 1;
-  sqlite3_bind_int64(insertStmt, arg++, stats::instructions);
-  sqlite3_bind_int64(insertStmt, arg++, fullBranches);
-  sqlite3_bind_int64(insertStmt, arg++, partialBranches);
-  sqlite3_bind_int64(insertStmt, arg++, numBranches);
-  sqlite3_bind_int64(insertStmt, arg++, time::getUserTime().toMicroseconds());
-  sqlite3_bind_int64(insertStmt, arg++,
-                     executor.objectManager->getStates().size());
-  sqlite3_bind_int64(
-      insertStmt, arg++,
-      util::GetTotalMallocUsage() +
-          (executor.memory ? executor.memory->getUsedDeterministicSize() : 0));
-  sqlite3_bind_int64(insertStmt, arg++, stats::queries);
-  sqlite3_bind_int64(insertStmt, arg++, stats::solverQueries);
-  sqlite3_bind_int64(insertStmt, arg++, stats::queryConstructs);
-  sqlite3_bind_int64(insertStmt, arg++, elapsed().toMicroseconds());
-  sqlite3_bind_int64(insertStmt, arg++, stats::coveredInstructions);
-  sqlite3_bind_int64(insertStmt, arg++, stats::uncoveredInstructions);
-  sqlite3_bind_int64(insertStmt, arg++, stats::queryTime);
-  sqlite3_bind_int64(insertStmt, arg++, stats::solverTime);
-  sqlite3_bind_int64(insertStmt, arg++, stats::cexCacheTime);
-  sqlite3_bind_int64(insertStmt, arg++, stats::forkTime);
-  sqlite3_bind_int64(insertStmt, arg++, stats::resolveTime);
-  sqlite3_bind_int64(insertStmt, arg++, stats::queryCacheMisses);
-  sqlite3_bind_int64(insertStmt, arg++, stats::queryCacheHits);
-  sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheMisses);
-  sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheHits);
-  sqlite3_bind_int64(insertStmt, arg++, stats::inhibitedForks);
-  sqlite3_bind_int64(insertStmt, arg++, stats::externalCalls);
-  sqlite3_bind_int64(insertStmt, arg++, stats::allocations);
-  sqlite3_bind_int64(insertStmt, arg++, ExecutionState::getLastID());
+#define TCLASS(Name, I) row.push_back(stats::termination##Name);
+  // Only take a snapshot here, the insert itself happens on the writer thread
+  std::vector<std::int64_t> row;
+  row.push_back(stats::instructions);
+  row.push_back(fullBranches);
+  row.push_back(partialBranches);
+  row.push_back(numBranches);
+  row.push_back(time::getUserTime().toMicroseconds());
+  row.push_back(executor.objectManager->getStates().size());
+  row.push_back(util::GetTotalMallocUsage() +
+                (executor.memory ? executor.memory->getUsedDeterministicSize()
+                                 : 0));
+  row.push_back(stats::queries);
+  row.push_back(stats::solverQueries);
+  row.push_back(stats::queryConstructs);
+  row.push_back(elapsed().toMicroseconds());
+  row.push_back(stats::coveredInstructions);
+  row.push_back(stats::uncoveredInstructions);
+  row.push_back(stats::queryTime);
+  row.push_back(stats::translationTime);
+  row.push_back(stats::solverTime);
+  row.push_back(stats::cexCacheTime);
+  row.push_back(stats::cexCacheLookupTime);
+  row.push_back(stats::forkTime);
+  row.push_back(stats::resolveTime);
+  row.push_back(stats::arrayOptimizationTime);
+  row.push_back(stats::queryCacheMisses);
+  row.push_back(stats::queryCacheHits);
+  row.push_back(stats::queryCexCacheMisses);
+  row.push_back(stats::queryCexCacheHits);
+  row.push_back(stats::cexCacheProbes);
+  row.push_back(stats::cexCacheEvictions);
+  row.push_back(stats::simplificationCacheMisses);
+  row.push_back(stats::simplificationCacheHits);
+  row.push_back(stats::inhibitedForks);
+  row.push_back(stats::externalCalls);
+  row.push_back(stats::allocations);
+  row.push_back(stats::boundsChecks);
+  row.push_back(stats::rangeBoundsChecks);
+  row.push_back(ExecutionState::getLastID());
   BRANCH_TYPES
   TERMINATION_CLASSES
 #ifdef KLEE_ARRAY_DEBUG
-  sqlite3_bind_int64(insertStmt, arg++, stats::arrayHashTime);
+  row.push_back(stats::arrayHashTime);
 #else
-  sqlite3_bind_int64(insertStmt, arg++, -1LL);
+  row.push_back(-1LL);
 #endif
+
+  writer->submit([this, row] { insertStatsLine(row); });
+}
+
+void StatsTracker::insertStatsLine(const std::vector<std::int64_t> &row) {
+  int arg = 1;
+  for (auto value : row)
+    sqlite3_bind_int64(insertStmt, arg++, value);
   int errCode = sqlite3_step(insertStmt);
   if (errCode != SQLITE_DONE)
-    klee_error("Error writing stats data: %s", sqlite3_errmsg(statsFile));
+    writer->error(std::string("Error writing stats data: ") +
+                  sqlite3_errmsg(statsFile));
   sqlite3_reset(insertStmt);
 
   statsWriteCount++;
   if (statsWriteCount == statsCommitEvery) {
     errCode = sqlite3_step(transactionEndStmt);
     if (errCode != SQLITE_DONE)
-      klee_warning("Transaction commit error: %s", sqlite3_errmsg(statsFile));
+      writer->warning(std::string("Transaction commit error: ") +
+                      sqlite3_errmsg(statsFile));
     sqlite3_reset(transactionEndStmt);
     errCode = sqlite3_step(transactionBeginStmt);
     if (errCode != SQLITE_DONE)
-      klee_warning("Transaction begin error: %s", sqlite3_errmsg(statsFile));
+      writer->warning(std::string("Transaction begin error: ") +
+                      sqlite3_errmsg(statsFile));
     sqlite3_reset(transactionBeginStmt);
 
     statsWriteCount = 0;
@@ -691,166 +836,261 @@ void StatsTracker::updateStateStatistics(uint64_t addend) {
   }
 }
 
-void StatsTracker::writeIStats() {
+std::unique_ptr<IStatsLayout> StatsTracker::buildIStatsLayout() const {
   const auto m = executor.kmodule->module.get();
-  llvm::raw_fd_ostream &of = *istatsFile;
+  auto layout = std::make_unique<IStatsLayout>();
 
-  // We assume that we didn't move the file pointer
-  unsigned istatsSize = of.tell();
-
-  of.seek(0);
+  StatisticManager &sm = *theStatisticManager;
+  for (auto name :
+       {"Queries", "QueriesValid", "QueriesInvalid", "QueryTime",
+        "ResolveTime", "Instructions", "InstructionTimes",
+        "InstructionRealTimes", "Forks", "CoveredInstructions",
+        "UncoveredInstructions", "States", "MinDistToUncovered"}) {
+    layout->stats.push_back(sm.getStatisticByName(name));
+  }
+  // keep the order of registration, as the events line did before
+  std::sort(layout->stats.begin(), layout->stats.end(),
+            [](const Statistic *a, const Statistic *b) {
+              return a->getID() < b->getID();
+            });
+
+  llvm::raw_string_ostream header(layout->header);
+  header << "version: 1\n";
+  header << "creator: klee\n";
+  header << "pid: " << getpid() << "\n";
+  header << "cmd: " << m->getModuleIdentifier() << "\n\n";
+  header << "\n";
+  header << "positions: instr line\n";
+  for (auto s : layout->stats)
+    header << "event: " << s->getShortName() << " : " << s->getName() << "\n";
+  header << "events: ";
+  for (auto s : layout->stats)
+    header << s->getShortName() << " ";
+  header << "\n";
+  header << "ob=" << llvm::sys::path::filename(objectFilename).str() << "\n";
+  header.flush();
 
-  of << "version: 1\n";
-  of << "creator: klee\n";
-  of << "pid: " << getpid() << "\n";
-  of << "cmd: " << m->getModuleIdentifier() << "\n\n";
-  of << "\n";
+  std::string sourceFile = "";
+  for (auto &fn : *m) {
+    if (fn.isDeclaration())
+      continue;
+
+    auto fli = getLocationInfo(&fn);
+    {
+      auto asmLine = executor.kmodule->getAsmLine(&fn);
+      assert(asmLine.has_value());
+      layout->callees[&fn] = {fli.file, fn.getName().str(),
+                              std::to_string(asmLine.value()) + " " +
+                                  std::to_string(fli.line)};
+    }
 
-  StatisticManager &sm = *theStatisticManager;
-  unsigned nStats = sm.getNumStatistics();
-  llvm::SmallBitVector istatsMask(nStats);
-
-  istatsMask.set(sm.getStatisticID("Queries"));
-  istatsMask.set(sm.getStatisticID("QueriesValid"));
-  istatsMask.set(sm.getStatisticID("QueriesInvalid"));
-  istatsMask.set(sm.getStatisticID("QueryTime"));
-  istatsMask.set(sm.getStatisticID("ResolveTime"));
-  istatsMask.set(sm.getStatisticID("Instructions"));
-  istatsMask.set(sm.getStatisticID("InstructionTimes"));
-  istatsMask.set(sm.getStatisticID("InstructionRealTimes"));
-  istatsMask.set(sm.getStatisticID("Forks"));
-  istatsMask.set(sm.getStatisticID("CoveredInstructions"));
-  istatsMask.set(sm.getStatisticID("UncoveredInstructions"));
-  istatsMask.set(sm.getStatisticID("States"));
-  istatsMask.set(sm.getStatisticID("MinDistToUncovered"));
-
-  of << "positions: instr line\n";
-
-  for (unsigned i = 0; i < nStats; i++) {
-    if (istatsMask.test(i)) {
-      Statistic &s = sm.getStatistic(i);
-      of << "event: " << s.getShortName() << " : " << s.getName() << "\n";
+    // Always try to write the filename before the function name, as otherwise
+    // KCachegrind can create two entries for the function, one with an
+    // unnamed file and one without.
+    std::string fnHeader;
+    if (fli.file != sourceFile) {
+      fnHeader += "fl=" + fli.file + "\n";
+      sourceFile = fli.file;
+    }
+    fnHeader += "fn=" + fn.getName().str() + "\n";
+
+    for (auto &bb : fn) {
+      for (auto &instr : bb) {
+        Instruction *instrPtr = &instr;
+        auto instrLI = getLocationInfo(instrPtr);
+
+        IStatsLayout::Line line;
+        line.header = std::move(fnHeader);
+        fnHeader.clear();
+        if (instrLI.file != sourceFile) {
+          line.header += "fl=" + instrLI.file + "\n";
+          sourceFile = instrLI.file;
+        }
+        line.sourceFile = sourceFile;
+
+        auto asmLine = executor.kmodule->getAsmLine(instrPtr);
+        assert(asmLine.has_value());
+        line.position = std::to_string(asmLine.value()) + " " +
+                        std::to_string(instrLI.line) + " ";
+        line.index = executor.kmodule->getGlobalIndex(instrPtr);
+        line.callSite = (isa<CallInst>(instrPtr) || isa<InvokeInst>(instrPtr))
+                            ? instrPtr
+                            : nullptr;
+        layout->lines.push_back(std::move(line));
+      }
     }
   }
 
-  of << "events: ";
-  for (unsigned i = 0; i < nStats; i++) {
-    if (istatsMask.test(i))
-      of << sm.getStatistic(i).getShortName() << " ";
-  }
-  of << "\n";
+  return layout;
+}
+
+void StatsTracker::writeIStats() {
+  StatisticManager &sm = *theStatisticManager;
+  const IStatsLayout &layout = *istatsLayout;
+  const auto &istats = layout.stats;
+
+  auto snapshot = std::make_shared<IStatsSnapshot>();
 
   // set state counts, decremented after we process so that we don't
   // have to zero all records each time.
-  if (istatsMask.test(stats::states.getID()))
-    updateStateStatistics(1);
+  updateStateStatistics(1);
 
-  std::string sourceFile = "";
+  snapshot->values.reserve(layout.lines.size() * istats.size());
+  for (auto &line : layout.lines)
+    for (auto s : istats)
+      snapshot->values.push_back(sm.getIndexedValue(*s, line.index));
 
-  CallSiteSummaryTable callSiteStats;
-  if (UseCallPaths)
+  if (UseCallPaths) {
+    CallSiteSummaryTable callSiteStats;
     callPathManager.getSummaryStatistics(callSiteStats);
-
-  of << "ob=" << llvm::sys::path::filename(objectFilename).str() << "\n";
-
-  for (auto &fn : *m) {
-    if (!fn.isDeclaration()) {
-      // Always try to write the filename before the function name, as otherwise
-      // KCachegrind can create two entries for the function, one with an
-      // unnamed file and one without.
-      auto fnlFile = getLocationInfo(&fn).file;
-      if (fnlFile != sourceFile) {
-        of << "fl=" << fnlFile << "\n";
-        sourceFile = fnlFile;
+    for (auto &site : callSiteStats) {
+      auto &rows = snapshot->calls[site.first];
+      for (auto &fit : site.second) {
+        const CallSiteInfo &csi = fit.second;
+        IStatsCallRow row{fit.first, csi.count, {}};
+        for (auto s : istats) {
+          // Hack, ignore things that don't make sense on call paths.
+          row.values.push_back(s == &stats::uncoveredInstructions
+                                   ? 0
+                                   : csi.statistics.getValue(*s));
+        }
+        rows.push_back(std::move(row));
       }
+    }
+  }
 
-      of << "fn=" << fn.getName().str() << "\n";
-      for (auto &bb : fn) {
-        for (auto &instr : bb) {
-          Instruction *instrPtr = &instr;
-
-          auto instrLI = getLocationInfo(instrPtr);
+  updateStateStatistics((uint64_t)-1);
 
-          unsigned index = executor.kmodule->getGlobalIndex(instrPtr);
-          if (instrLI.file != sourceFile) {
-            of << "fl=" << instrLI.file << "\n";
-            sourceFile = instrLI.file;
-          }
+  writer->submit([this, snapshot] { dumpIStats(*snapshot); });
+}
 
-          {
-            auto asmLine = executor.kmodule->getAsmLine(instrPtr);
-            assert(asmLine.has_value());
-            of << asmLine.value() << " ";
-          }
+void StatsTracker::dumpIStats(const IStatsSnapshot &snapshot) {
+  IStatsLayout &layout = *istatsLayout;
+  const size_t nStats = layout.stats.size();
+
+  // Re-render only the lines whose counters changed since the last dump
+  bool changed = layout.lastText.empty();
+  layout.lastText.resize(layout.lines.size());
+  layout.lastValues.resize(snapshot.values.size(), 0);
+  for (size_t i = 0; i < layout.lines.size(); ++i) {
+    auto first = snapshot.values.begin() + i * nStats;
+    auto last = layout.lastValues.begin() + i * nStats;
+    if (!layout.lastText[i].empty() && std::equal(first, first + nStats, last))
+      continue;
+    std::copy(first, first + nStats, last);
+    std::string &text = layout.lastText[i];
+    text.clear();
+    for (size_t j = 0; j < nStats; ++j)
+      text += std::to_string(first[j]) + " ";
+    text += "\n";
+    changed = true;
+  }
+  if (snapshot.calls != layout.lastCalls) {
+    layout.lastCalls = snapshot.calls;
+    changed = true;
+  }
+  if (!changed)
+    return;
+
+  std::string tmpFilename = istatsFilename + ".tmp";
+  {
+    std::error_code ec;
+    llvm::raw_fd_ostream of(tmpFilename, ec, sys::fs::OF_None);
+    if (ec) {
+      writer->warning("Unable to write instruction level stats file: " +
+                      ec.message());
+      return;
+    }
 
-          of << instrLI.line << " ";
-          for (unsigned i = 0; i < nStats; i++)
-            if (istatsMask.test(i))
-              of << sm.getIndexedValue(sm.getStatistic(i), index) << " ";
-          of << "\n";
-
-          if (UseCallPaths &&
-              (isa<CallInst>(instrPtr) || isa<InvokeInst>(instrPtr))) {
-            CallSiteSummaryTable::iterator it = callSiteStats.find(instrPtr);
-            if (it != callSiteStats.end()) {
-              for (auto &fit : it->second) {
-                const Function *f = fit.first;
-                CallSiteInfo &csi = fit.second;
-                auto fli = getLocationInfo(f);
-                if (fli.file != "" && fli.file != sourceFile)
-                  of << "cfl=" << fli.file << "\n";
-                of << "cfn=" << f->getName().str() << "\n";
-                of << "calls=" << csi.count << " ";
-
-                {
-                  auto asmLine = executor.kmodule->getAsmLine(f);
-                  assert(asmLine.has_value());
-                  of << asmLine.value() << " ";
-                }
-
-                of << fli.line << "\n";
-
-                {
-                  auto asmLine = executor.kmodule->getAsmLine(instrPtr);
-                  assert(asmLine.has_value());
-                  of << asmLine.value() << " ";
-                }
-
-                of << instrLI.line << " ";
-                for (unsigned i = 0; i < nStats; i++) {
-                  if (istatsMask.test(i)) {
-                    Statistic &s = sm.getStatistic(i);
-                    uint64_t value;
-
-                    // Hack, ignore things that don't make sense on
-                    // call paths.
-                    if (&s == &stats::uncoveredInstructions) {
-                      value = 0;
-                    } else {
-                      value = csi.statistics.getValue(s);
-                    }
-
-                    of << value << " ";
-                  }
-                }
-                of << "\n";
-              }
-            }
-          }
-        }
+    of << layout.header;
+    for (size_t i = 0; i < layout.lines.size(); ++i) {
+      const IStatsLayout::Line &line = layout.lines[i];
+      of << line.header << line.position << layout.lastText[i];
+
+      if (!line.callSite)
+        continue;
+      auto it = snapshot.calls.find(line.callSite);
+      if (it == snapshot.calls.end())
+        continue;
+      for (auto &row : it->second) {
+        const IStatsLayout::Callee &callee = layout.callees.at(row.callee);
+        if (callee.file != "" && callee.file != line.sourceFile)
+          of << "cfl=" << callee.file << "\n";
+        of << "cfn=" << callee.name << "\n";
+        of << "calls=" << row.count << " " << callee.position << "\n";
+        of << line.position;
+        for (auto value : row.values)
+          of << value << " ";
+        of << "\n";
       }
     }
   }
 
-  if (istatsMask.test(stats::states.getID()))
-    updateStateStatistics((uint64_t)-1);
+  if (auto ec = sys::fs::rename(tmpFilename, istatsFilename))
+    writer->warning("Unable to replace run.istats: " + ec.message());
+}
+
+/// Hash of the prepared module which does not depend on pointer values or
+/// the process, so coverage files of different runs can be checked for
+/// compatibility.
+static uint64_t computeModuleHash(const KModule &km) {
+  std::string buffer;
+  llvm::raw_string_ostream os(buffer);
+  for (auto &kf : km.functions) {
+    os << kf->function()->getName() << ':' << kf->getGlobalIndex() << ':';
+    for (unsigned i = 0; i < kf->numInstructions; ++i)
+      os << kf->instructions[i]->inst()->getOpcode() << ',';
+    os << ';';
+  }
+  return llvm::xxHash64(os.str());
+}
+
+void StatsTracker::writeCoverageBitmap() {
+  if (!OutputIStats) {
+    klee_warning("--output-coverage-bitmap requires --output-istats, "
+                 "not writing run.cov");
+    return;
+  }
+
+  const KModule &km = *executor.kmodule;
+  StatisticManager &sm = *theStatisticManager;
+  CoverageData coverage(computeModuleHash(km), km.getMaxGlobalIndex());
+
+  for (auto &kf : km.functions) {
+    unsigned first = kf->getGlobalIndex();
+    unsigned last = first;
+    uint32_t fileString = coverage.addString(kf->getSourceFilepath());
+    coverage.lines[first] = {fileString, static_cast<uint32_t>(kf->getLine())};
+
+    for (unsigned i = 0; i < kf->numInstructions; ++i) {
+      KInstruction *ki = kf->instructions[i];
+      unsigned id = ki->getGlobalIndex();
+      last = std::max(last, id);
+
+      coverage.lines[id] = {coverage.addString(ki->getSourceFilepath()),
+                            static_cast<uint32_t>(ki->getLine())};
+      coverage.counts[id] = sm.getIndexedValue(stats::instructions, id);
+      if (instructionIsCoverable(ki->inst()))
+        coverage.set(CoverageBitmap::Coverable, id);
+      if (sm.getIndexedValue(stats::coveredInstructions, id))
+        coverage.set(CoverageBitmap::Covered, id);
+      if (sm.getIndexedValue(stats::trueBranches, id))
+        coverage.set(CoverageBitmap::BranchTrue, id);
+      if (sm.getIndexedValue(stats::falseBranches, id))
+        coverage.set(CoverageBitmap::BranchFalse, id);
+    }
 
-  // Clear then end of the file if necessary (no truncate op?).
-  unsigned pos = of.tell();
-  for (unsigned i = pos; i < istatsSize; ++i)
-    of << '\n';
+    uint32_t nameString = coverage.addString(kf->function()->getName().str());
+    coverage.functions.push_back(
+        {nameString, fileString, first, last - first + 1});
+  }
 
-  of.flush();
+  auto os = executor.interpreterHandler->openOutputFile("run.cov");
+  if (!os) {
+    klee_warning("Unable to open coverage bitmap file (run.cov).");
+    return;
+  }
+  coverage.write(*os);
 }
 
 ///
@@ -898,15 +1138,195 @@ uint64_t klee::computeMinDistToUncovered(const KInstruction *ki,
   }
 }
 
+namespace klee {
+/// Shortest distance (counted in instructions, plus one) from every
+/// instruction to an uncovered instruction over the interprocedural CFG,
+/// 0 meaning that no uncovered instruction is reachable. Results are stored
+/// in the MinDistToUncovered indexed statistic.
+///
+/// Coverage only grows, so distances only grow. Instead of recomputing the
+/// fixpoint over the whole module on every update, newly covered
+/// instructions are handed to cover(), which only revisits the instructions
+/// whose shortest path led through one of them (a decremental variant of
+/// Ramalingam-Reps) and re-runs Dijkstra restricted to that region.
+class UncoveredDistance {
+  // Candidate edges: dist[from] <= weight + dist[to], stored in CSR form in
+  // both directions.
+  struct Edge {
+    unsigned node;
+    unsigned weight;
+  };
+  std::vector<unsigned> succBegin, predBegin;
+  std::vector<Edge> succs, preds;
+
+  std::vector<uint64_t> dist;
+  std::vector<bool> isTarget;
+  std::vector<bool> affected;
+
+  typedef std::pair<uint64_t, unsigned> QueueEntry;
+  typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                              std::greater<QueueEntry>>
+      Queue;
+
+  void set(unsigned id, uint64_t value) {
+    dist[id] = value;
+    theStatisticManager->setIndexedValue(stats::minDistToUncovered, id, value);
+  }
+
+  /// Relax predecessors of everything in the queue. When \p onlyAffected is
+  /// set, propagation is limited to the affected region.
+  void propagate(Queue &queue, bool onlyAffected) {
+    while (!queue.empty()) {
+      auto [d, id] = queue.top();
+      queue.pop();
+      if (d != dist[id])
+        continue;
+      for (unsigned e = predBegin[id]; e < predBegin[id + 1]; ++e) {
+        const Edge &pred = preds[e];
+        if (onlyAffected && !affected[pred.node])
+          continue;
+        uint64_t val = d + pred.weight;
+        if (dist[pred.node] == 0 || val < dist[pred.node]) {
+          set(pred.node, val);
+          queue.push({val, pred.node});
+        }
+      }
+    }
+  }
+
+public:
+  UncoveredDistance(const KModule &km) {
+    unsigned n = km.getMaxGlobalIndex();
+    std::vector<std::pair<unsigned, Edge>> edges;
+
+    for (auto &kf : km.functions) {
+      for (unsigned i = 0; i < kf->numInstructions; ++i) {
+        KInstruction *ki = kf->instructions[i];
+        Instruction *inst = ki->inst();
+        unsigned id = ki->getGlobalIndex();
+        unsigned bestThrough = 0;
+
+        if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
+          for (auto target : callTargets[inst]) {
+            uint64_t dist = functionShortestPath[target];
+            if (dist) {
+              dist = 1 + dist; // count instruction itself
+              if (bestThrough == 0 || dist < bestThrough)
+                bestThrough = dist;
+            }
+
+            if (!target->isDeclaration())
+              edges.push_back(
+                  {id, {km.getGlobalIndex(&*target->begin()->begin()), 1}});
+          }
+        } else {
+          bestThrough = 1;
+        }
+
+        if (bestThrough)
+          for (auto succ : getSuccs(inst))
+            edges.push_back({id, {km.getGlobalIndex(succ), bestThrough}});
+      }
+    }
+
+    succBegin.assign(n + 1, 0);
+    predBegin.assign(n + 1, 0);
+    for (auto &edge : edges) {
+      ++succBegin[edge.first + 1];
+      ++predBegin[edge.second.node + 1];
+    }
+    for (unsigned i = 0; i < n; ++i) {
+      succBegin[i + 1] += succBegin[i];
+      predBegin[i + 1] += predBegin[i];
+    }
+    succs.resize(edges.size());
+    preds.resize(edges.size());
+    std::vector<unsigned> succFill(succBegin.begin(), succBegin.end() - 1);
+    std::vector<unsigned> predFill(predBegin.begin(), predBegin.end() - 1);
+    for (auto &edge : edges) {
+      succs[succFill[edge.first]++] = edge.second;
+      preds[predFill[edge.second.node]++] = {edge.first, edge.second.weight};
+    }
+
+    // initial, full computation: multi-source Dijkstra from all uncovered
+    // instructions
+    dist.assign(n, 0);
+    isTarget.assign(n, false);
+    affected.assign(n, false);
+    Queue queue;
+    StatisticManager &sm = *theStatisticManager;
+    for (unsigned id = 0; id < n; ++id) {
+      isTarget[id] = sm.getIndexedValue(stats::uncoveredInstructions, id) != 0;
+      set(id, isTarget[id] ? 1 : 0);
+      if (isTarget[id])
+        queue.push({1, id});
+    }
+    propagate(queue, false);
+  }
+
+  /// Update distances after the given instructions have been covered.
+  void cover(const std::vector<unsigned> &covered) {
+    // Collect every instruction whose distance may have been witnessed by a
+    // path through a newly covered one.
+    std::vector<unsigned> region;
+    for (auto id : covered) {
+      if (!isTarget[id])
+        continue;
+      isTarget[id] = false;
+      affected[id] = true;
+      region.push_back(id);
+    }
+    for (size_t i = 0; i < region.size(); ++i) {
+      unsigned id = region[i];
+      for (unsigned e = predBegin[id]; e < predBegin[id + 1]; ++e) {
+        const Edge &pred = preds[e];
+        if (affected[pred.node] || isTarget[pred.node] ||
+            dist[pred.node] != dist[id] + pred.weight)
+          continue;
+        affected[pred.node] = true;
+        region.push_back(pred.node);
+      }
+    }
+
+    // Seed the affected region from its unaffected boundary.
+    Queue queue;
+    for (auto id : region) {
+      uint64_t best = 0;
+      for (unsigned e = succBegin[id]; e < succBegin[id + 1]; ++e) {
+        const Edge &succ = succs[e];
+        if (affected[succ.node] || dist[succ.node] == 0)
+          continue;
+        uint64_t val = dist[succ.node] + succ.weight;
+        if (best == 0 || val < best)
+          best = val;
+      }
+      set(id, best);
+    }
+    for (auto id : region)
+      if (dist[id])
+        queue.push({dist[id], id});
+
+    propagate(queue, true);
+
+    for (auto id : region)
+      affected[id] = false;
+  }
+};
+} // namespace klee
+
+void StatsTracker::updateReachableUncovered() {
+  if (!uncoveredDistance || newlyCovered.empty())
+    return;
+  uncoveredDistance->cover(newlyCovered);
+  newlyCovered.clear();
+}
+
 void StatsTracker::computeReachableUncovered() {
   KModule *km = executor.kmodule.get();
   const auto m = km->module.get();
-  static bool init = true;
   StatisticManager &sm = *theStatisticManager;
 
-  if (init) {
-    init = false;
-
+  if (!uncoveredDistance) {
     // Compute call targets. It would be nice to use alias information
     // instead of assuming all indirect calls hit all escaping
     // functions, eh?
@@ -1033,82 +1453,11 @@ void StatsTracker::computeReachableUncovered() {
         }
       }
     } while (changed);
-  }
 
-  // compute minDistToUncovered, 0 is unreachable
-  std::vector<Instruction *> instructions;
-  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); fnIt != fn_ie;
-       ++fnIt) {
-    // Not sure if I should bother to preorder here.
-    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end();
-         bbIt != bb_ie; ++bbIt) {
-      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); it != ie;
-           ++it) {
-        Instruction *inst = &*it;
-        unsigned id = km->getGlobalIndex(inst);
-        instructions.push_back(inst);
-        sm.setIndexedValue(
-            stats::minDistToUncovered, id,
-            sm.getIndexedValue(stats::uncoveredInstructions, id));
-      }
-    }
+    uncoveredDistance = std::make_unique<UncoveredDistance>(*km);
   }
 
-  std::reverse(instructions.begin(), instructions.end());
-
-  // I'm so lazy it's not even worklisted.
-  bool changed;
-  do {
-    changed = false;
-    for (auto inst : instructions) {
-      uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToUncovered,
-                                                     km->getGlobalIndex(inst));
-      unsigned bestThrough = 0;
-
-      if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
-        std::vector<Function *> &targets = callTargets[inst];
-        for (auto &target : targets) {
-          uint64_t dist = functionShortestPath[target];
-          if (dist) {
-            dist = 1 + dist; // count instruction itself
-            if (bestThrough == 0 || dist < bestThrough)
-              bestThrough = dist;
-          }
-
-          if (!target->isDeclaration()) {
-            uint64_t calleeDist = sm.getIndexedValue(
-                stats::minDistToUncovered, km->getGlobalIndex(target));
-            if (calleeDist) {
-              calleeDist = 1 + calleeDist; // count instruction itself
-              if (best == 0 || calleeDist < best)
-                best = calleeDist;
-            }
-          }
-        }
-      } else {
-        bestThrough = 1;
-      }
-
-      if (bestThrough) {
-        std::vector<Instruction *> succs = getSuccs(inst);
-        for (auto &succ : succs) {
-          uint64_t dist = sm.getIndexedValue(stats::minDistToUncovered,
-                                             km->getGlobalIndex(succ));
-          if (dist) {
-            uint64_t val = bestThrough + dist;
-            if (best == 0 || val < best)
-              best = val;
-          }
-        }
-      }
-
-      if (best != cur) {
-        sm.setIndexedValue(stats::minDistToUncovered, km->getGlobalIndex(inst),
-                           best);
-        changed = true;
-      }
-    }
-  } while (changed);
+  updateReachableUncovered();
 
   for (std::set<ExecutionState *>::iterator
            it = executor.objectManager->getStates().begin(),
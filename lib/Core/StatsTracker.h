@@ -11,10 +11,15 @@
 #define KLEE_STATSTRACKER_H
 
 #include "CallPathManager.h"
+#include "StatsWriter.h"
 #include "klee/System/Time.h"
 
+#include "llvm/ADT/BitVector.h"
+
+#include <cstdint>
 #include <memory>
 #include <sqlite3.h>
+#include <vector>
 
 namespace llvm {
 class BranchInst;
@@ -29,6 +34,9 @@ class Executor;
 class InterpreterHandler;
 struct KInstruction;
 struct InfoStackFrame;
+struct IStatsLayout;
+struct IStatsSnapshot;
+class UncoveredDistance;
 
 class StatsTracker {
   friend class WriteStatsTimer;
@@ -37,7 +45,8 @@ class StatsTracker {
   Executor &executor;
   std::string objectFilename;
 
-  std::unique_ptr<llvm::raw_fd_ostream> istatsFile;
+  std::string istatsFilename;
+  std::unique_ptr<IStatsLayout> istatsLayout;
   ::sqlite3 *statsFile = nullptr;
   ::sqlite3_stmt *transactionBeginStmt = nullptr;
   ::sqlite3_stmt *transactionEndStmt = nullptr;
@@ -56,6 +65,17 @@ class StatsTracker {
   bool updateMinDistToUncovered;
   bool releaseStates;
 
+  /// Coverable instructions which no state has covered yet, by global index
+  llvm::BitVector uncoveredCoverable;
+
+  std::unique_ptr<UncoveredDistance> uncoveredDistance;
+  /// Global indices of instructions covered since the last distance update
+  std::vector<unsigned> newlyCovered;
+
+  // Must be declared last: it is destroyed (and its queue drained) before
+  // any state the pending jobs may refer to.
+  std::unique_ptr<StatsWriter> writer;
+
 public:
   static bool useStatistics();
   static bool useIStats();
@@ -65,6 +85,12 @@ private:
   void writeStatsHeader();
   void writeStatsLine();
   void writeIStats();
+  std::unique_ptr<IStatsLayout> buildIStatsLayout() const;
+  void writeCoverageBitmap();
+
+  // executed on the writer thread, problems are reported through writer
+  void insertStatsLine(const std::vector<std::int64_t> &row);
+  void dumpIStats(const IStatsSnapshot &snapshot);
 
 public:
   StatsTracker(Executor &_executor, std::string _objectFilename,
@@ -95,8 +121,13 @@ public:
   /// Return duration since execution start.
   time::Span elapsed();
 
+  /// Compute distances to uncovered instructions (incrementally after the
+  /// first call) and refresh the per-frame return distances of all states.
   void computeReachableUncovered();
 
+  /// Fold instructions covered since the last update into the distances.
+  void updateReachableUncovered();
+
   void checkCoverage();
 };
 
@@ -0,0 +1,90 @@
+//===-- StatsWriter.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "StatsWriter.h"
+
+#include "klee/Support/ErrorHandling.h"
+
+#include <utility>
+
+using namespace klee;
+
+StatsWriter::StatsWriter() : worker([this] { run(); }) {}
+
+StatsWriter::~StatsWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  hasWork.notify_one();
+  worker.join();
+  // jobs drained by the join may have recorded problems of their own
+  reportProblems();
+}
+
+void StatsWriter::submit(Job job) {
+  reportProblems();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+  }
+  hasWork.notify_one();
+}
+
+void StatsWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  isIdle.wait(lock, [this] { return jobs.empty() && !busy; });
+  lock.unlock();
+  reportProblems();
+}
+
+void StatsWriter::warning(std::string message) {
+  std::lock_guard<std::mutex> lock(mutex);
+  problems.emplace_back(false, std::move(message));
+}
+
+void StatsWriter::error(std::string message) {
+  std::lock_guard<std::mutex> lock(mutex);
+  problems.emplace_back(true, std::move(message));
+}
+
+void StatsWriter::reportProblems() {
+  std::vector<std::pair<bool, std::string>> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.swap(problems);
+  }
+  for (auto &problem : pending) {
+    if (problem.first)
+      klee_error("%s", problem.second.c_str());
+    klee_warning("%s", problem.second.c_str());
+  }
+}
+
+void StatsWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    hasWork.wait(lock, [this] { return stopping || !jobs.empty(); });
+    if (jobs.empty()) {
+      // stopping and drained
+      break;
+    }
+
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    busy = true;
+    lock.unlock();
+    job();
+    lock.lock();
+    busy = false;
+
+    if (jobs.empty())
+      isIdle.notify_all();
+  }
+}
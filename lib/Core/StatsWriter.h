@@ -0,0 +1,73 @@
+//===-- StatsWriter.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATSWRITER_H
+#define KLEE_STATSWRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace klee {
+
+/// StatsWriter - A dedicated background thread which executes statistics
+/// output jobs (sqlite inserts, istats dumps) in submission order, so that
+/// the interpreter only pays for taking a snapshot of the counters.
+///
+/// Jobs must not touch the StatisticManager or any other interpreter state;
+/// everything they need has to be captured by value at submission time.
+/// This includes error reporting: jobs record problems with warning() and
+/// error(), which are reported on the interpreter thread by the next
+/// submit() or flush(), or at the latest by the destructor.
+class StatsWriter {
+public:
+  typedef std::function<void()> Job;
+
+private:
+  std::mutex mutex;
+  std::condition_variable hasWork;
+  std::condition_variable isIdle;
+  std::deque<Job> jobs;
+  bool busy = false;
+  bool stopping = false;
+  /// problems recorded by jobs and not reported yet, true if fatal
+  std::vector<std::pair<bool, std::string>> problems;
+  std::thread worker;
+
+  void run();
+  void reportProblems();
+
+public:
+  StatsWriter();
+  ~StatsWriter();
+
+  StatsWriter(const StatsWriter &) = delete;
+  StatsWriter &operator=(const StatsWriter &) = delete;
+
+  /// Enqueue a job to be executed on the writer thread.
+  void submit(Job job);
+
+  /// Block until every job submitted so far has been executed.
+  void flush();
+
+  /// Called by jobs to record a warning.
+  void warning(std::string message);
+  /// Called by jobs to record an error, which terminates KLEE once it is
+  /// reported.
+  void error(std::string message);
+};
+
+} // namespace klee
+
+#endif /* KLEE_STATSWRITER_H */
@@ -19,6 +19,8 @@
 #include "klee/Module/KModule.h"
 #include "klee/Support/ErrorHandling.h"
 
+#include "llvm/Support/ThreadPool.h"
+
 #include <memory>
 
 using namespace llvm;
@@ -178,6 +180,11 @@ llvm::cl::opt<bool> SmartResolveEntryFunction(
     cl::desc("Resolve entry function using code flow graph instead of taking "
              "function of first location (default=false)"));
 
+llvm::cl::opt<unsigned> TargetPreparationThreads(
+    "target-preparation-threads", cl::init(0),
+    cl::desc("Number of threads used to resolve and check the traces of the "
+             "report (default=0, one per hardware thread)"));
+
 cl::opt<unsigned long long>
     MaxCycles("max-cycles",
               cl::desc("stop execution after visiting some basic block this "
@@ -325,36 +332,51 @@ TargetedExecutionManager::LocationToBlocks
 TargetedExecutionManager::prepareAllLocations(KModule *kmodule,
                                               Locations &locations) const {
   LocationToBlocks locToBlocks;
-  std::unordered_map<std::string, std::unordered_set<const llvm::Function *>>
-      fileNameToFunctions;
-
-  for (const auto &kfunc : kmodule->functions) {
-    fileNameToFunctions[kfunc->getSourceFilepath()].insert(kfunc->function());
-  }
-
-  for (auto it = locations.begin(); it != locations.end(); ++it) {
-    auto loc = *it;
-    for (const auto &[fileName, origInstsInFile] : kmodule->origInstructions) {
-      if (kmodule->origInstructions.count(fileName) == 0) {
-        continue;
-      }
-      if (!loc->isInside(fileName)) {
-        continue;
+  const auto &index = kmodule->locationIndex;
+  assert(!index.empty() && "source locations are not indexed");
+  // Module source files matching each file name of the report
+  std::unordered_map<std::string, std::vector<std::string>> fileNameToFiles;
+  std::vector<KBlock *> blocks;
+  std::vector<SourceLocationIndex::InstructionPosition> insts;
+
+  for (const auto &loc : locations) {
+    auto files = fileNameToFiles.find(loc->filename);
+    if (files == fileNameToFiles.end()) {
+      std::vector<std::string> matching;
+      for (const auto &[fileName, origInstsInFile] :
+           kmodule->origInstructions) {
+        if (loc->isInside(fileName)) {
+          matching.push_back(fileName);
+        }
       }
+      files = fileNameToFiles.emplace(loc->filename, std::move(matching)).first;
+    }
 
-      const auto &relatedFunctions = fileNameToFunctions.at(fileName);
-
-      for (const auto func : relatedFunctions) {
-        const auto kfunc = kmodule->functionMap[func];
-
-        for (const auto &kblock : kfunc->blocks) {
-          auto b = kblock.get();
-          if (!loc->isInside(b, origInstsInFile)) {
+    for (const auto &fileName : files->second) {
+      blocks.clear();
+      if (!loc->startColumn.has_value()) {
+        index.findBlocks(fileName, loc->startLine, loc->endLine, blocks);
+      } else {
+        // Only instructions present in the original source count
+        const auto &origInstsInFile = kmodule->origInstructions.at(fileName);
+        insts.clear();
+        index.findInstructions(fileName, loc->startLine, loc->endLine,
+                               *loc->startColumn, *loc->endColumn, insts);
+        for (const auto &inst : insts) {
+          auto line = origInstsInFile.find(inst.line);
+          if (line == origInstsInFile.end()) {
             continue;
           }
-          locToBlocks[loc].insert(b);
+          auto column = line->second.find(inst.column);
+          if (column != line->second.end() &&
+              column->second.count(inst.inst->inst()->getOpcode())) {
+            blocks.push_back(inst.inst->parent);
+          }
         }
       }
+      if (!blocks.empty()) {
+        locToBlocks[loc].insert(blocks.begin(), blocks.end());
+      }
     }
   }
 
@@ -373,20 +395,23 @@ TargetedExecutionManager::collectAllLocations(const SarifReport &paths) const {
   return locations;
 }
 
-bool TargetedExecutionManager::canReach(const ref<Location> &from,
-                                        const ref<Location> &to,
-                                        LocationToBlocks &locToBlocks) const {
-  for (auto fromBlock : locToBlocks[from]) {
-    for (auto toBlock : locToBlocks[to]) {
-      auto fromKf = fromBlock->parent;
-      auto toKf = toBlock->parent;
-      if (fromKf == toKf) {
-        if (fromBlock == toBlock) {
-          return true;
-        }
+bool TargetedExecutionManager::canReach(
+    const ref<Location> &from, const ref<Location> &to,
+    const LocationToBlocks &locToBlocks) const {
+  // Reachability is decided once per pair of functions rather than per pair
+  // of blocks
+  KFunctionMap<KBlockSet> fromFunctions, toFunctions;
+  for (auto fromBlock : locToBlocks.at(from)) {
+    fromFunctions[fromBlock->parent].insert(fromBlock);
+  }
+  for (auto toBlock : locToBlocks.at(to)) {
+    toFunctions[toBlock->parent].insert(toBlock);
+  }
 
-        const auto &blockDist = codeGraphInfo.getDistance(fromBlock);
-        if (blockDist.count(toBlock) != 0) {
+  for (const auto &[fromKf, fromBlocks] : fromFunctions) {
+    for (const auto &[toKf, toBlocks] : toFunctions) {
+      if (fromKf == toKf) {
+        if (codeGraphInfo.isReachable(fromBlocks, toBlocks)) {
           return true;
         }
       } else {
@@ -408,46 +433,48 @@ bool TargetedExecutionManager::canReach(const ref<Location> &from,
 }
 
 bool TargetedExecutionManager::tryResolveLocations(
-    Result &result, LocationToBlocks &locToBlocks) const {
-  std::vector<ref<Location>> resolvedLocations;
-  size_t index = 0;
-  for (const auto &location : result.locations) {
-    auto it = locToBlocks.find(location);
-    if (it != locToBlocks.end()) {
-      if (!resolvedLocations.empty() && CheckTraversability) {
-        if (!canReach(resolvedLocations.back(), location, locToBlocks)) {
-          klee_warning("Trace %s is untraversable! Can't reach location %s "
-                       "from location %s, so skipping this trace.",
-                       result.id.c_str(), location->toString().c_str(),
-                       resolvedLocations.back()->toString().c_str());
+    const Result &result, const LocationToBlocks &locToBlocks,
+    TraceResolution &resolution) const {
+  auto &resolved = resolution.locations;
+  for (size_t index = 0; index < result.locations.size(); ++index) {
+    const auto &location = result.locations[index];
+    if (locToBlocks.count(location)) {
+      if (!resolved.empty() && CheckTraversability) {
+        const auto &previous = result.locations[resolved.back()];
+        if (!canReach(previous, location, locToBlocks)) {
+          resolution.warning =
+              "Trace " + result.id + " is untraversable! Can't reach " +
+              "location " + location->toString() + " from location " +
+              previous->toString() + ", so skipping this trace.";
           return false;
         }
       }
-      resolvedLocations.push_back(location);
+      resolved.push_back(index);
     } else if (index == result.locations.size() - 1) {
-      klee_warning(
-          "Trace %s is malformed! %s at location %s, so skipping this trace.",
-          result.id.c_str(), getErrorsString(result.errors).c_str(),
-          location->toString().c_str());
+      resolution.warning = "Trace " + result.id + " is malformed! " +
+                           getErrorsString(result.errors) + " at location " +
+                           location->toString() + ", so skipping this trace.";
       return false;
     }
-    ++index;
   }
 
-  result.locations = std::move(resolvedLocations);
-
   return true;
 }
 
 KFunction *TargetedExecutionManager::tryResolveEntryFunction(
-    const Result &result, LocationToBlocks &locToBlocks) const {
-  assert(result.locations.size() > 0);
+    const Result &result, const LocationToBlocks &locToBlocks,
+    TraceResolution &resolution) const {
+  const auto &resolved = resolution.locations;
+  assert(resolved.size() > 0);
+  auto blocksOf = [&](size_t i) -> const Blocks & {
+    return locToBlocks.at(result.locations[resolved[i]]);
+  };
 
   KFunction *resKf = nullptr;
   if (SmartResolveEntryFunction) {
-    for (size_t i = 0; i < result.locations.size() && !resKf; ++i) {
+    for (size_t i = 0; i < resolved.size() && !resKf; ++i) {
       std::vector<KFunction *> applicantKFs;
-      for (auto block : locToBlocks[result.locations[i]]) {
+      for (auto block : blocksOf(i)) {
         if (std::find(applicantKFs.begin(), applicantKFs.end(),
                       block->parent) == applicantKFs.end()) {
           applicantKFs.push_back(block->parent);
@@ -455,14 +482,14 @@ KFunction *TargetedExecutionManager::tryResolveEntryFunction(
       }
       for (size_t k = 0; k < applicantKFs.size() && !resKf; ++k) {
         resKf = applicantKFs.at(k);
-        for (size_t j = i; j < result.locations.size(); ++j) {
+        for (size_t j = i; j < resolved.size(); ++j) {
           if (i == j) {
             continue;
           }
           const auto &funcDist = codeGraphInfo.getDistance(resKf);
 
           std::vector<KFunction *> currKFs;
-          for (auto block : locToBlocks[result.locations[j]]) {
+          for (auto block : blocksOf(j)) {
             if (std::find(currKFs.begin(), currKFs.end(), block->parent) ==
                 currKFs.end()) {
               currKFs.push_back(block->parent);
@@ -489,13 +516,13 @@ KFunction *TargetedExecutionManager::tryResolveEntryFunction(
       }
     }
   } else {
-    resKf = (*locToBlocks[result.locations[0]].begin())->parent;
+    resKf = (*blocksOf(0).begin())->parent;
   }
 
   if (!resKf) {
-    klee_warning("Trace %s is malformed! Can't resolve entry function, "
-                 "so skipping this trace.",
-                 result.id.c_str());
+    resolution.warning = "Trace " + result.id +
+                         " is malformed! Can't resolve entry function, so "
+                         "skipping this trace.";
   }
   return resKf;
 }
@@ -508,19 +535,51 @@ ref<TargetForest> TargetedExecutionManager::prepareTargets(KModule *kmodule,
   Locations locations = collectAllLocations(paths);
   LocationToBlocks locToBlocks = prepareAllLocations(kmodule, locations);
 
-  for (auto &result : paths.results) {
-    bool isFullyResolved = tryResolveLocations(result, locToBlocks);
-    if (!isFullyResolved) {
-      brokenTraces.insert(result.id);
-      continue;
+  // Traces are resolved and checked concurrently. The workers only read
+  // locToBlocks, the reports and the code graph, whose caches are filled
+  // beforehand, and must not copy refs, whose counters are not atomic.
+  if (CheckTraversability || SmartResolveEntryFunction) {
+    KFunctionSet functions;
+    for (const auto &locationBlocks : locToBlocks) {
+      for (auto block : locationBlocks.second) {
+        functions.insert(block->parent);
+      }
     }
+    codeGraphInfo.precompute(functions, TargetPreparationThreads);
+  }
 
-    auto kf = tryResolveEntryFunction(result, locToBlocks);
-    if (!kf) {
+  std::vector<TraceResolution> resolutions(paths.results.size());
+  {
+    llvm::ThreadPool pool(llvm::hardware_concurrency(TargetPreparationThreads));
+    for (size_t i = 0; i < paths.results.size(); ++i) {
+      pool.async([this, &paths, &locToBlocks, &resolutions, i] {
+        const auto &result = paths.results[i];
+        auto &resolution = resolutions[i];
+        resolution.isResolved =
+            tryResolveLocations(result, locToBlocks, resolution) &&
+            tryResolveEntryFunction(result, locToBlocks, resolution);
+      });
+    }
+    pool.wait();
+  }
+
+  // Traces are added to the forest in the order of the report
+  for (size_t i = 0; i < paths.results.size(); ++i) {
+    auto &result = paths.results[i];
+    const auto &resolution = resolutions[i];
+    if (!resolution.isResolved) {
+      klee_warning("%s", resolution.warning.c_str());
       brokenTraces.insert(result.id);
       continue;
     }
 
+    std::vector<ref<Location>> resolvedLocations;
+    resolvedLocations.reserve(resolution.locations.size());
+    for (auto index : resolution.locations) {
+      resolvedLocations.push_back(result.locations[index]);
+    }
+    result.locations = std::move(resolvedLocations);
+
     forest->addTrace(result, locToBlocks);
   }
 
@@ -100,16 +100,28 @@ private:
   std::unordered_set<std::string> brokenTraces;
   std::unordered_set<std::string> reportedTraces;
 
-  bool tryResolveLocations(Result &result, LocationToBlocks &locToBlocks) const;
+  /// Outcome of resolving a single trace of the report
+  struct TraceResolution {
+    /// Indices of the locations of the trace that were resolved
+    std::vector<size_t> locations;
+    /// Why the trace is skipped, unless it is resolved
+    std::string warning;
+    bool isResolved = false;
+  };
+
+  bool tryResolveLocations(const Result &result,
+                           const LocationToBlocks &locToBlocks,
+                           TraceResolution &resolution) const;
   LocationToBlocks prepareAllLocations(KModule *kmodule,
                                        Locations &locations) const;
   Locations collectAllLocations(const SarifReport &paths) const;
 
   bool canReach(const ref<Location> &from, const ref<Location> &to,
-                LocationToBlocks &locToBlocks) const;
+                const LocationToBlocks &locToBlocks) const;
 
   KFunction *tryResolveEntryFunction(const Result &result,
-                                     LocationToBlocks &locToBlocks) const;
+                                     const LocationToBlocks &locToBlocks,
+                                     TraceResolution &resolution) const;
 
   CodeGraphInfo &codeGraphInfo;
   TargetManager &targetManager;
@@ -46,7 +46,14 @@ cl::list<Searcher::CoreSearchType> CoreSearch(
                    "use NURS with Instr-Count"),
         clEnumValN(Searcher::NURS_CPICnt, "nurs:cpicnt",
                    "use NURS with CallPath-Instr-Count"),
-        clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost")),
+        clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost"),
+        clEnumValN(Searcher::RandomPath_CovNew, "random-path:covnew",
+                   "use Random Path Selection weighted by Coverage-New"),
+        clEnumValN(Searcher::RandomPath_MD2U, "random-path:md2u",
+                   "use Random Path Selection weighted by "
+                   "Min-Dist-to-Uncovered"),
+        clEnumValN(Searcher::RandomPath_Depth, "random-path:depth",
+                   "use Random Path Selection weighted by depth")),
     cl::cat(SearchCat));
 
 cl::opt<HaltExecution::Reason> UseIterativeDeepeningSearch(
@@ -107,7 +114,11 @@ bool klee::userSearcherRequiresMD2U() {
           std::find(CoreSearch.begin(), CoreSearch.end(),
                     Searcher::NURS_CPICnt) != CoreSearch.end() ||
           std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::NURS_QC) !=
-              CoreSearch.end());
+              CoreSearch.end() ||
+          std::find(CoreSearch.begin(), CoreSearch.end(),
+                    Searcher::RandomPath_CovNew) != CoreSearch.end() ||
+          std::find(CoreSearch.begin(), CoreSearch.end(),
+                    Searcher::RandomPath_MD2U) != CoreSearch.end());
 }
 
 Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
@@ -152,6 +163,18 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
     searcher =
         new WeightedRandomSearcher(WeightedRandomSearcher::QueryCost, rng);
     break;
+  case Searcher::RandomPath_CovNew:
+    searcher = new WeightedRandomPathSearcher(
+        processForest, WeightedRandomSearcher::CoveringNew, rng);
+    break;
+  case Searcher::RandomPath_MD2U:
+    searcher = new WeightedRandomPathSearcher(
+        processForest, WeightedRandomSearcher::MinDistToUncovered, rng);
+    break;
+  case Searcher::RandomPath_Depth:
+    searcher = new WeightedRandomPathSearcher(
+        processForest, WeightedRandomSearcher::Depth, rng);
+    break;
   }
 
   return searcher;
@@ -44,6 +44,7 @@ const Array *AlphaBuilder::visitArray(const Array *arr) {
       alphaArrayMap[arr] = arr;
       reverseAlphaArrayMap[arr] = arr;
     }
+    mappedArrays.push_back(arr);
   }
   if (reverse) {
     return reverseAlphaArrayMap[arr];
@@ -103,4 +104,12 @@ ref<Expr> AlphaBuilder::reverseBuild(ref<Expr> v) {
   return e;
 }
 
+void AlphaBuilder::mapArray(const Array *arr, const Array *alpha,
+                            unsigned newIndex) {
+  alphaArrayMap[arr] = alpha;
+  reverseAlphaArrayMap[alpha] = arr;
+  mappedArrays.push_back(arr);
+  index = newIndex;
+}
+
 } // namespace klee
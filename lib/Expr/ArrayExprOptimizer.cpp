@@ -10,11 +10,14 @@
 #include "klee/Expr/ArrayExprOptimizer.h"
 
 #include "klee/ADT/BitArray.h"
+#include "klee/ADT/GenerationalCache.h"
 #include "klee/Expr/ArrayExprRewriter.h"
 #include "klee/Expr/ArrayExprVisitor.h"
 #include "klee/Expr/Assignment.h"
 #include "klee/Expr/AssignmentGenerator.h"
 #include "klee/Expr/ExprBuilder.h"
+#include "klee/Expr/ExprStats.h"
+#include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Support/Casting.h"
 #include "klee/Support/ErrorHandling.h"
 #include "klee/Support/OptionCategories.h"
@@ -26,6 +29,7 @@
 #include <cassert>
 #include <cstddef>
 #include <set>
+#include <tuple>
 
 using namespace klee;
 
@@ -56,8 +60,42 @@ llvm::cl::opt<double> ArrayValueSymbRatio(
                    "the mixed value-based transformations are applied."),
     llvm::cl::init(1.0), llvm::cl::value_desc("Symbolic Values / Array Size"),
     llvm::cl::cat(klee::SolvingCat));
+
+llvm::cl::opt<unsigned> OptimizeArrayCacheSize(
+    "optimize-array-cache-size",
+    llvm::cl::desc("Maximum number of expressions and reads kept in each "
+                   "generation of the array optimization caches. 0 disables "
+                   "the caches (default=16384)"),
+    llvm::cl::init(16384), llvm::cl::cat(klee::SolvingCat));
 }; // namespace klee
 
+namespace {
+/// Optimizer cache, bounded by --optimize-array-cache-size entries per
+/// generation. With a size of 0 nothing is cached.
+class OptimizerCache {
+  GenerationalCache<ref<Expr>, ref<Expr>, ExprHashMap<ref<Expr>>> cache{
+      OptimizeArrayCacheSize};
+
+public:
+  const ref<Expr> *lookup(const ref<Expr> &e) { return cache.lookup(e); }
+
+  void insert(const ref<Expr> &e, ref<Expr> value) {
+    if (OptimizeArrayCacheSize)
+      cache.insert(e, std::move(value));
+  }
+};
+} // namespace
+
+struct ExprOptimizer::Caches {
+  /// optimized version of expressions, or the expression itself if it
+  /// cannot be optimized
+  OptimizerCache exprs;
+  /// select expressions built for reads from (partially) concrete arrays
+  OptimizerCache reads;
+};
+
+ExprOptimizer::ExprOptimizer() : caches(std::make_shared<Caches>()) {}
+
 ref<Expr> extendRead(const UpdateList &ul, const ref<Expr> index,
                      Expr::Width w) {
   switch (w) {
@@ -108,14 +146,11 @@ ref<Expr> ExprOptimizer::optimizeExpr(const ref<Expr> &e, bool valueOnly) {
   if (OptimizeArray == NONE)
     return e;
 
-  if (cacheExprUnapplicable.count(e) > 0)
-    return e;
-
-  // Find cached expressions
-  auto cached = cacheExprOptimized.find(e);
-  if (cached != cacheExprOptimized.end())
-    return cached->second;
+  // Find cached expressions, including those that cannot be optimized
+  if (auto cached = caches->exprs.lookup(e))
+    return *cached;
 
+  TimerStatIncrementer timer(stats::arrayOptimizationTime);
   ref<Expr> result;
   // ----------------------- INDEX-BASED OPTIMIZATION -------------------------
   if (!valueOnly && (OptimizeArray == ALL || OptimizeArray == INDEX)) {
@@ -129,7 +164,7 @@ ref<Expr> ExprOptimizer::optimizeExpr(const ref<Expr> &e, bool valueOnly) {
       // If we cannot optimize the expression, we return a failure only
       // when we are not combining the optimizations
       if (OptimizeArray == INDEX) {
-        cacheExprUnapplicable.insert(e);
+        caches->exprs.insert(e, e);
         return e;
       }
     } else {
@@ -147,13 +182,13 @@ ref<Expr> ExprOptimizer::optimizeExpr(const ref<Expr> &e, bool valueOnly) {
         // Add new expression to cache
         if (result) {
           klee_warning("OPT_I: successful");
-          cacheExprOptimized[e] = result;
+          caches->exprs.insert(e, result);
         } else {
           klee_warning("OPT_I: unsuccessful");
         }
       } else {
         klee_warning("OPT_I: unsuccessful");
-        cacheExprUnapplicable.insert(e);
+        caches->exprs.insert(e, e);
       }
     }
   }
@@ -167,7 +202,7 @@ ref<Expr> ExprOptimizer::optimizeExpr(const ref<Expr> &e, bool valueOnly) {
     std::reverse(reads.begin(), reads.end());
 
     if (reads.empty() || are.isIncompatible()) {
-      cacheExprUnapplicable.insert(e);
+      caches->exprs.insert(e, e);
       return e;
     }
 
@@ -176,10 +211,10 @@ ref<Expr> ExprOptimizer::optimizeExpr(const ref<Expr> &e, bool valueOnly) {
     if (selectOpt) {
       klee_warning("OPT_V: successful");
       result = selectOpt;
-      cacheExprOptimized[e] = result;
+      caches->exprs.insert(e, result);
     } else {
       klee_warning("OPT_V: unsuccessful");
-      cacheExprUnapplicable.insert(e);
+      caches->exprs.insert(e, e);
     }
   }
   if (!result)
@@ -261,11 +296,13 @@ ref<Expr> ExprOptimizer::getSelectOptExpr(
   // Array is concrete
   if (!isSymbolic) {
     ExprHashMap<ref<Expr>> optimized;
+    std::map<std::tuple<const Array *, const UpdateNode *, Expr::Width>,
+             std::vector<uint64_t>>
+        concreteValues;
     for (auto &read : reads) {
       auto info = readInfo[read];
-      auto cached = cacheReadExprOptimized.find(const_cast<ReadExpr *>(read));
-      if (cached != cacheReadExprOptimized.end()) {
-        optimized.insert(std::make_pair(info.first, (*cached).second));
+      if (auto cached = caches->reads.lookup(const_cast<ReadExpr *>(read))) {
+        optimized.insert(std::make_pair(info.first, *cached));
         continue;
       }
       Expr::Width width = read->getWidth();
@@ -281,47 +318,51 @@ ref<Expr> ExprOptimizer::getSelectOptExpr(
       unsigned bytesPerElement = width / 8;
       unsigned elementsInArray = size / bytesPerElement;
 
-      // Note: we already filtered the ReadExpr, so here we can safely
-      // assume that the UpdateNodes contain ConstantExpr indexes and values
-      assert(read->updates.root->isConstantArray() &&
-             "Expected concrete array, found symbolic array");
-
-      // We need to read updates from lest recent to most recent, therefore
-      // reverse the list
-      std::vector<const UpdateNode *> us;
-      us.reserve(read->updates.getSize());
-      for (const UpdateNode *un = read->updates.head.get(); un;
-           un = un->next.get())
-        us.push_back(un);
-
-      std::vector<ref<ConstantExpr>> arrayConstValues;
-      if (ref<ConstantSource> constantSource =
-              dyn_cast<ConstantSource>(read->updates.root->source)) {
-        arrayConstValues =
-            constantSource->constantValues->getFirstNIndexes(size);
-      }
-      for (auto it = us.rbegin(); it != us.rend(); it++) {
-        const UpdateNode *un = *it;
-        auto ce = dyn_cast<ConstantExpr>(un->index);
-        assert(ce && "Not a constant expression");
-        uint64_t index = ce->getAPValue().getZExtValue();
-        assert(index < arrayConstValues.size());
-        auto arrayValue = dyn_cast<ConstantExpr>(un->value);
-        assert(arrayValue && "Not a constant expression");
-        arrayConstValues[index] = arrayValue;
-      }
-      std::vector<uint64_t> arrayValues;
-      // Get the concrete values from the array
-      for (unsigned i = 0; i < elementsInArray; i++) {
-        uint64_t val = 0;
-        for (unsigned j = 0; j < bytesPerElement; j++) {
-          val |= (*(arrayConstValues[(i * bytesPerElement) + j]
-                        .get()
-                        ->getAPValue()
-                        .getRawData())
-                  << (j * 8));
+      // Reads from the same update list share the array analysis
+      auto &arrayValues = concreteValues[std::make_tuple(
+          read->updates.root, read->updates.head.get(), width)];
+      if (arrayValues.empty()) {
+        // Note: we already filtered the ReadExpr, so here we can safely
+        // assume that the UpdateNodes contain ConstantExpr indexes and values
+        assert(read->updates.root->isConstantArray() &&
+               "Expected concrete array, found symbolic array");
+
+        // We need to read updates from lest recent to most recent, therefore
+        // reverse the list
+        std::vector<const UpdateNode *> us;
+        us.reserve(read->updates.getSize());
+        for (const UpdateNode *un = read->updates.head.get(); un;
+             un = un->next.get())
+          us.push_back(un);
+
+        std::vector<ref<ConstantExpr>> arrayConstValues;
+        if (ref<ConstantSource> constantSource =
+                dyn_cast<ConstantSource>(read->updates.root->source)) {
+          arrayConstValues =
+              constantSource->constantValues->getFirstNIndexes(size);
+        }
+        for (auto it = us.rbegin(); it != us.rend(); it++) {
+          const UpdateNode *un = *it;
+          auto ce = dyn_cast<ConstantExpr>(un->index);
+          assert(ce && "Not a constant expression");
+          uint64_t index = ce->getAPValue().getZExtValue();
+          assert(index < arrayConstValues.size());
+          auto arrayValue = dyn_cast<ConstantExpr>(un->value);
+          assert(arrayValue && "Not a constant expression");
+          arrayConstValues[index] = arrayValue;
+        }
+        // Get the concrete values from the array
+        for (unsigned i = 0; i < elementsInArray; i++) {
+          uint64_t val = 0;
+          for (unsigned j = 0; j < bytesPerElement; j++) {
+            val |= (*(arrayConstValues[(i * bytesPerElement) + j]
+                          .get()
+                          ->getAPValue()
+                          .getRawData())
+                    << (j * 8));
+          }
+          arrayValues.push_back(val);
         }
-        arrayValues.push_back(val);
       }
 
       ref<Expr> index = UDivExpr::create(
@@ -331,7 +372,7 @@ ref<Expr> ExprOptimizer::getSelectOptExpr(
       ref<Expr> opt =
           buildConstantSelectExpr(index, arrayValues, width, elementsInArray);
       if (opt) {
-        cacheReadExprOptimized[const_cast<ReadExpr *>(read)] = opt;
+        caches->reads.insert(const_cast<ReadExpr *>(read), opt);
         optimized.insert(std::make_pair(info.first, opt));
       }
     }
@@ -345,11 +386,13 @@ ref<Expr> ExprOptimizer::getSelectOptExpr(
   //       array is symbolic && updatelist contains at least one concrete value
   else {
     ExprHashMap<ref<Expr>> optimized;
+    std::map<std::tuple<const Array *, const UpdateNode *, Expr::Width>,
+             std::vector<std::pair<uint64_t, bool>>>
+        mixedValues;
     for (auto &read : reads) {
       auto info = readInfo[read];
-      auto cached = cacheReadExprOptimized.find(const_cast<ReadExpr *>(read));
-      if (cached != cacheReadExprOptimized.end()) {
-        optimized.insert(std::make_pair(info.first, (*cached).second));
+      if (auto cached = caches->reads.lookup(const_cast<ReadExpr *>(read))) {
+        optimized.insert(std::make_pair(info.first, *cached));
         continue;
       }
       Expr::Width width = read->getWidth();
@@ -366,70 +409,75 @@ ref<Expr> ExprOptimizer::getSelectOptExpr(
       unsigned elementsInArray = size / bytesPerElement;
       bool symbArray = read->updates.root->isSymbolicArray();
 
-      BitArray ba(size, symbArray);
-      // Note: we already filtered the ReadExpr, so here we can safely
-      // assume that the UpdateNodes contain ConstantExpr indexes, but in
-      // this case we *cannot* assume anything on the values
-      std::vector<ref<ConstantExpr>> arrayConstValues;
-      if (ref<ConstantSource> constantSource =
-              dyn_cast<ConstantSource>(read->updates.root->source)) {
-        arrayConstValues =
-            constantSource->constantValues->getFirstNIndexes(size);
-      }
-      if (arrayConstValues.size() < size) {
-        // We need to "force" initialization of the values
-        for (size_t i = arrayConstValues.size(); i < size; i++) {
-          arrayConstValues.push_back(ConstantExpr::create(0, Expr::Int8));
+      // Reads from the same update list share the array analysis
+      auto &arrayValues = mixedValues[std::make_tuple(
+          read->updates.root, read->updates.head.get(), width)];
+      if (arrayValues.empty()) {
+        BitArray ba(size, symbArray);
+        // Note: we already filtered the ReadExpr, so here we can safely
+        // assume that the UpdateNodes contain ConstantExpr indexes, but in
+        // this case we *cannot* assume anything on the values
+        std::vector<ref<ConstantExpr>> arrayConstValues;
+        if (ref<ConstantSource> constantSource =
+                dyn_cast<ConstantSource>(read->updates.root->source)) {
+          arrayConstValues =
+              constantSource->constantValues->getFirstNIndexes(size);
         }
-      }
-
-      // We need to read updates from lest recent to most recent, therefore
-      // reverse the list
-      std::vector<const UpdateNode *> us;
-      us.reserve(read->updates.getSize());
-      for (const UpdateNode *un = read->updates.head.get(); un;
-           un = un->next.get())
-        us.push_back(un);
-
-      for (auto it = us.rbegin(); it != us.rend(); it++) {
-        const UpdateNode *un = *it;
-        auto ce = dyn_cast<ConstantExpr>(un->index);
-        assert(ce && "Not a constant expression");
-        uint64_t index = ce->getAPValue().getLimitedValue();
-        if (!isa<ConstantExpr>(un->value)) {
-          ba.set(index);
-        } else {
-          ba.unset(index);
-          auto arrayValue = dyn_cast<ConstantExpr>(un->value);
-          assert(arrayValue && "Not a constant expression");
-          arrayConstValues[index] = arrayValue;
+        if (arrayConstValues.size() < size) {
+          // We need to "force" initialization of the values
+          for (size_t i = arrayConstValues.size(); i < size; i++) {
+            arrayConstValues.push_back(ConstantExpr::create(0, Expr::Int8));
+          }
         }
-      }
 
-      std::vector<std::pair<uint64_t, bool>> arrayValues;
-      unsigned symByteNum = 0;
-      for (unsigned i = 0; i < elementsInArray; i++) {
-        uint64_t val = 0;
-        bool elementIsConcrete = true;
-        for (unsigned j = 0; j < bytesPerElement; j++) {
-          if (ba.get((i * bytesPerElement) + j)) {
-            elementIsConcrete = false;
-            break;
+        // We need to read updates from lest recent to most recent, therefore
+        // reverse the list
+        std::vector<const UpdateNode *> us;
+        us.reserve(read->updates.getSize());
+        for (const UpdateNode *un = read->updates.head.get(); un;
+             un = un->next.get())
+          us.push_back(un);
+
+        for (auto it = us.rbegin(); it != us.rend(); it++) {
+          const UpdateNode *un = *it;
+          auto ce = dyn_cast<ConstantExpr>(un->index);
+          assert(ce && "Not a constant expression");
+          uint64_t index = ce->getAPValue().getLimitedValue();
+          if (!isa<ConstantExpr>(un->value)) {
+            ba.set(index);
           } else {
-            val |= (*(arrayConstValues[(i * bytesPerElement) + j]
-                          .get()
-                          ->getAPValue()
-                          .getRawData())
-                    << (j * 8));
+            ba.unset(index);
+            auto arrayValue = dyn_cast<ConstantExpr>(un->value);
+            assert(arrayValue && "Not a constant expression");
+            arrayConstValues[index] = arrayValue;
           }
         }
-        if (elementIsConcrete) {
-          arrayValues.emplace_back(val, true);
-        } else {
-          symByteNum++;
-          arrayValues.emplace_back(0, false);
+
+        for (unsigned i = 0; i < elementsInArray; i++) {
+          uint64_t val = 0;
+          bool elementIsConcrete = true;
+          for (unsigned j = 0; j < bytesPerElement; j++) {
+            if (ba.get((i * bytesPerElement) + j)) {
+              elementIsConcrete = false;
+              break;
+            } else {
+              val |= (*(arrayConstValues[(i * bytesPerElement) + j]
+                            .get()
+                            ->getAPValue()
+                            .getRawData())
+                      << (j * 8));
+            }
+          }
+          if (elementIsConcrete) {
+            arrayValues.emplace_back(val, true);
+          } else {
+            arrayValues.emplace_back(0, false);
+          }
         }
       }
+      unsigned symByteNum =
+          std::count_if(arrayValues.begin(), arrayValues.end(),
+                        [](const auto &value) { return !value.second; });
 
       if (((double)symByteNum / (double)elementsInArray) <=
           ArrayValueSymbRatio) {
@@ -438,7 +486,7 @@ ref<Expr> ExprOptimizer::getSelectOptExpr(
         ref<Expr> opt =
             buildMixedSelectExpr(read, arrayValues, width, elementsInArray);
         if (opt) {
-          cacheReadExprOptimized[const_cast<ReadExpr *>(read)] = opt;
+          caches->reads.insert(const_cast<ReadExpr *>(read), opt);
           optimized.insert(std::make_pair(info.first, opt));
         }
       }
@@ -12,6 +12,7 @@
 #include "klee/Expr/Assignment.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Expr/ExprHashMap.h"
+#include "klee/Expr/ExprStats.h"
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/ExprVisitor.h"
 #include "klee/Expr/IndependentConstraintSetUnion.h"
@@ -27,6 +28,8 @@
 #include "llvm/IR/Function.h"
 #include "llvm/Support/CommandLine.h"
 
+#include <algorithm>
+
 using namespace klee;
 
 namespace {
@@ -41,8 +44,20 @@ llvm::cl::opt<RewriteEqualitiesPolicy> RewriteEqualities(
                      clEnumValN(RewriteEqualitiesPolicy::Full, "full",
                                 "more powerful visitor")),
     llvm::cl::init(RewriteEqualitiesPolicy::Simple), llvm::cl::cat(SolvingCat));
+
+llvm::cl::opt<unsigned> SimplificationCacheSize(
+    "simplification-cache-size",
+    llvm::cl::desc("Maximum number of simplified expressions remembered per "
+                   "constraint set, 0 disables the cache (default=4096)"),
+    llvm::cl::init(4096), llvm::cl::cat(SolvingCat));
 } // namespace
 
+namespace klee {
+struct SimplificationMemo {
+  ExprHashMap<Simplificator::ExprResult> results;
+};
+} // namespace klee
+
 class ExprReplaceVisitor : public ExprVisitor {
 private:
   ref<Expr> src, dst;
@@ -66,15 +81,13 @@ public:
   }
 };
 
-class ExprReplaceVisitor2 : public ExprVisitor {
+template <typename Map> class ExprReplaceVisitor2 : public ExprVisitor {
 private:
-  std::vector<std::reference_wrapper<const ExprHashMap<ref<Expr>>>>
-      replacements;
-  const ExprHashMap<ref<Expr>> &replacementParents;
+  std::vector<std::reference_wrapper<const Map>> replacements;
+  const Map &replacementParents;
 
 public:
-  explicit ExprReplaceVisitor2(const ExprHashMap<ref<Expr>> &_replacements,
-                               const ExprHashMap<ref<Expr>> &_parents)
+  explicit ExprReplaceVisitor2(const Map &_replacements, const Map &_parents)
       : ExprVisitor(true), replacements({_replacements}),
         replacementParents(_parents) {}
 
@@ -230,6 +243,70 @@ public:
   ExprHashSet replacementDependency;
 };
 
+/// Calls \p f with every (expression, replacement) pair that \p constraint
+/// contributes to the rewrites used by Simplificator::simplifyExpr.
+template <typename F>
+static void forEachRewrite(const ref<Expr> &constraint, F f) {
+  if (const EqExpr *ee = dyn_cast<EqExpr>(constraint)) {
+    ref<Expr> small = ee->left;
+    ref<Expr> big = ee->right;
+    if (!isa<ConstantExpr>(small)) {
+      auto hr = big->height(), hl = small->height();
+      if (hr < hl || (hr == hl && big < small))
+        std::swap(small, big);
+      f(constraint, Expr::createTrue());
+    }
+    f(big, small);
+  } else {
+    f(constraint, Expr::createTrue());
+    if (const NotExpr *ne = dyn_cast<NotExpr>(constraint)) {
+      f(ne->expr, Expr::createFalse());
+    }
+  }
+}
+
+void RewriteIndex::add(const ref<Expr> &constraint) {
+  forEachRewrite(constraint, [&](const ref<Expr> &from, const ref<Expr> &to) {
+    owners_ty owners;
+    if (const owners_ty *known = _owners.lookup(from)) {
+      owners = *known;
+    } else {
+      _equalities.insert({from, to});
+      _parents.insert({from, constraint});
+    }
+    owners.emplace_back(constraint, to);
+    _owners.replace({from, owners});
+  });
+}
+
+void RewriteIndex::remove(const ref<Expr> &constraint) {
+  forEachRewrite(constraint, [&](const ref<Expr> &from, const ref<Expr> &) {
+    const owners_ty *known = _owners.lookup(from);
+    if (!known)
+      return;
+    owners_ty owners = *known;
+    auto it = std::find_if(owners.begin(), owners.end(), [&](const auto &o) {
+      return o.first == constraint;
+    });
+    if (it == owners.end())
+      return;
+    bool inEffect = it == owners.begin();
+    owners.erase(it);
+    if (owners.empty()) {
+      _owners.remove(from);
+      _equalities.remove(from);
+      _parents.remove(from);
+      return;
+    }
+    _owners.replace({from, owners});
+    // fall back to the rewrite of the next constraint owning the expression
+    if (inEffect) {
+      _equalities.replace({from, owners.front().second});
+      _parents.replace({from, owners.front().first});
+    }
+  });
+}
+
 ConstraintSet::ConstraintSet(constraints_ty cs, symcretes_ty symcretes,
                              Assignment concretization)
     : cowKey(1), _constraints(cs), _symcretes(symcretes),
@@ -284,6 +361,16 @@ void ConstraintSet::addConstraint(ref<Expr> e) {
   checkCopyOnWriteOwner();
   _constraints.insert(e);
   _independentElements->addExpr(e);
+  if (hasRewrites)
+    _rewrites.add(e);
+  if (*_ranges) {
+    RangeIndex ranges = **_ranges;
+    ranges.add(e);
+    _ranges = std::make_shared<std::optional<RangeIndex>>(std::move(ranges));
+  } else {
+    _ranges = std::make_shared<std::optional<RangeIndex>>();
+  }
+  _simplified.reset();
 }
 
 IDType Symcrete::idCounter = 0;
@@ -355,7 +442,20 @@ void ConstraintSet::print(llvm::raw_ostream &os) const {
 void ConstraintSet::dump() const { this->print(llvm::errs()); }
 
 void ConstraintSet::changeCS(constraints_ty &cs) {
+  if (hasRewrites) {
+    for (const auto &constraint : _constraints) {
+      if (!cs.count(constraint))
+        _rewrites.remove(constraint);
+    }
+    for (const auto &constraint : cs) {
+      if (!_constraints.count(constraint))
+        _rewrites.add(constraint);
+    }
+  }
   _constraints = cs;
+  // rewritten constraints may no longer imply the recorded bounds
+  _ranges = std::make_shared<std::optional<RangeIndex>>();
+  _simplified.reset();
   _independentElements = std::make_shared<IndependentConstraintSetUnion>(
       IndependentConstraintSetUnion(_constraints, _symcretes,
                                     *_concretization));
@@ -370,6 +470,25 @@ ConstraintSet::independentElements() const {
   return *_independentElements;
 }
 
+const RewriteIndex &ConstraintSet::rewrites() const {
+  if (!hasRewrites) {
+    for (const auto &constraint : _constraints)
+      _rewrites.add(constraint);
+    hasRewrites = true;
+  }
+  return _rewrites;
+}
+
+const RangeIndex &ConstraintSet::ranges() const {
+  if (!*_ranges) {
+    RangeIndex ranges;
+    for (const auto &constraint : _constraints)
+      ranges.add(constraint);
+    *_ranges = std::move(ranges);
+  }
+  return **_ranges;
+}
+
 const Path &PathConstraints::path() const { return _path; }
 
 const ExprHashMap<Path::PathIndex> &PathConstraints::indexes() const {
@@ -460,26 +579,10 @@ Simplificator::simplifyExpr(const constraints_ty &constraints,
   ExprHashMap<ref<Expr>> equalitiesParents;
 
   for (auto &constraint : constraints) {
-    if (const EqExpr *ee = dyn_cast<EqExpr>(constraint)) {
-      ref<Expr> small = ee->left;
-      ref<Expr> big = ee->right;
-      if (!isa<ConstantExpr>(small)) {
-        auto hr = big->height(), hl = small->height();
-        if (hr < hl || (hr == hl && big < small))
-          std::swap(small, big);
-        equalities.emplace(constraint, Expr::createTrue());
-        equalitiesParents.emplace(constraint, constraint);
-      }
-      equalities.emplace(big, small);
-      equalitiesParents.emplace(big, constraint);
-    } else {
-      equalities.emplace(constraint, Expr::createTrue());
-      equalitiesParents.emplace(constraint, constraint);
-      if (const NotExpr *ne = dyn_cast<NotExpr>(constraint)) {
-        equalities.emplace(ne->expr, Expr::createFalse());
-        equalitiesParents.emplace(ne->expr, constraint);
-      }
-    }
+    forEachRewrite(constraint, [&](const ref<Expr> &from, const ref<Expr> &to) {
+      equalities.emplace(from, to);
+      equalitiesParents.emplace(from, constraint);
+    });
   }
 
   ExprReplaceVisitor2 visitor(equalities, equalitiesParents);
@@ -490,7 +593,32 @@ Simplificator::simplifyExpr(const constraints_ty &constraints,
 Simplificator::ExprResult
 Simplificator::simplifyExpr(const ConstraintSet &constraints,
                             const ref<Expr> &expr) {
-  return simplifyExpr(constraints.cs(), expr);
+  if (isa<ConstantExpr>(expr))
+    return {expr, {}};
+
+  if (SimplificationCacheSize) {
+    if (!constraints._simplified)
+      constraints._simplified = std::make_shared<SimplificationMemo>();
+    auto &memo = constraints._simplified->results;
+    auto it = memo.find(expr);
+    if (it != memo.end()) {
+      ++stats::simplificationCacheHits;
+      return it->second;
+    }
+    ++stats::simplificationCacheMisses;
+  }
+
+  const RewriteIndex &rewrites = constraints.rewrites();
+  ExprReplaceVisitor2 visitor(rewrites.equalities(), rewrites.parents());
+  ExprResult result = {visitor.visit(expr), visitor.replacementDependency};
+
+  if (SimplificationCacheSize) {
+    auto &memo = constraints._simplified->results;
+    if (memo.size() >= SimplificationCacheSize)
+      memo.clear();
+    memo.emplace(expr, result);
+  }
+  return result;
 }
 
 Simplificator::SetResult
@@ -1542,7 +1542,18 @@ ref<Expr> ReadExpr::create(const UpdateList &ul, ref<Expr> index, bool safe) {
   // array element has been updated
   auto un = ul.head.get();
   bool updateListHasSymbolicWrites = false;
+  uint64_t concreteIndex;
+  bool isConcreteIndex = false;
+  if (auto CE = dyn_cast<ConstantExpr>(index)) {
+    if (CE->getWidth() <= 64) {
+      concreteIndex = CE->getZExtValue();
+      isConcreteIndex = true;
+    }
+  }
   for (; un; un = un->next.get()) {
+    // Skip the updates to other concrete indices
+    if (isConcreteIndex && !(un = un->findWrite(concreteIndex)))
+      break;
     ref<Expr> cond = EqExpr::create(index, un->index);
     if (ConstantExpr *CE = dyn_cast<ConstantExpr>(cond)) {
       if (CE->isTrue())
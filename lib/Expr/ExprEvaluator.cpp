@@ -14,6 +14,9 @@ using namespace klee;
 ExprVisitor::Action ExprEvaluator::evalRead(const UpdateList &ul,
                                             unsigned index) {
   for (auto un = ul.head; un; un = un->next) {
+    // Skip the updates to other concrete indices
+    if (!(un = un->findWrite(index)))
+      break;
     ref<Expr> ui = visit(un->index);
 
     if (ConstantExpr *CE = dyn_cast<ConstantExpr>(ui)) {
@@ -0,0 +1,17 @@
+//===-- ExprStats.cpp -----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/ExprStats.h"
+
+using namespace klee;
+
+Statistic stats::arrayOptimizationTime("ArrayOptimizationTime", "AOtime");
+Statistic stats::simplificationCacheHits("SimplificationCacheHits", "SChits");
+Statistic stats::simplificationCacheMisses("SimplificationCacheMisses",
+                                           "SCmisses");
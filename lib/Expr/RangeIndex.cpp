@@ -0,0 +1,691 @@
+//===-- RangeIndex.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/RangeIndex.h"
+
+#include "klee/ADT/Bits.h"
+
+#include <algorithm>
+
+using namespace klee;
+
+namespace {
+using Range = RangeIndex::Range;
+using u128 = unsigned __int128;
+using s128 = __int128;
+
+uint64_t mask(Expr::Width w) { return bits64::maxValueOfNBits(w); }
+
+Range fullRange(Expr::Width w) { return {0, mask(w)}; }
+
+Range point(uint64_t value, Expr::Width w) {
+  return {value, value, ~value & mask(w), value};
+}
+
+Range boolean(bool value) { return point(value, Expr::Bool); }
+
+const Range unknownBool = {0, 1};
+
+uint64_t knownBits(const Range &r) { return r.zeros | r.ones; }
+
+unsigned trailingOnes(uint64_t x) {
+  return ~x ? __builtin_ctzll(~x) : 64;
+}
+
+/// Reduces [lo, hi] modulo 2^w, provided it stays contiguous.
+Range wrap(u128 lo, u128 hi, Expr::Width w) {
+  if (lo > hi || (lo >> w) != (hi >> w))
+    return fullRange(w);
+  return {(uint64_t)(lo & mask(w)), (uint64_t)(hi & mask(w))};
+}
+
+/// Sets the bits of \p value under \p low as known in \p r.
+Range withLowBits(Range r, uint64_t value, uint64_t low) {
+  r.ones |= value & low;
+  r.zeros |= ~value & low;
+  return r;
+}
+
+/// Smallest all-ones value not below \p x.
+uint64_t fillBits(uint64_t x) {
+  for (unsigned shift = 1; shift < 64; shift <<= 1)
+    x |= x >> shift;
+  return x;
+}
+
+bool agrees(uint64_t value, const Range &r) {
+  return (value & r.zeros) == 0 && (value & r.ones) == r.ones;
+}
+
+/// Smallest value not below \p v that agrees with the known bits of \p r.
+std::optional<uint64_t> roundUp(uint64_t v, const Range &r, Expr::Width w) {
+  if (agrees(v, r))
+    return v;
+  std::optional<uint64_t> best;
+  uint64_t prefix = 0;
+  for (unsigned i = w; i-- > 0;) {
+    uint64_t bit = (uint64_t)1 << i, below = bit - 1;
+    if (v & bit) {
+      if (r.zeros & bit)
+        return best;
+      prefix |= bit;
+    } else if (r.ones & bit) {
+      return prefix | bit | (r.ones & below);
+    } else if (!(r.zeros & bit)) {
+      // setting this bit instead is the smallest way to exceed v so far
+      best = prefix | bit | (r.ones & below);
+    }
+  }
+  return v;
+}
+
+/// Largest value not above \p v that agrees with the known bits of \p r.
+std::optional<uint64_t> roundDown(uint64_t v, const Range &r, Expr::Width w) {
+  if (agrees(v, r))
+    return v;
+  uint64_t allowed = mask(w) & ~r.zeros;
+  std::optional<uint64_t> best;
+  uint64_t prefix = 0;
+  for (unsigned i = w; i-- > 0;) {
+    uint64_t bit = (uint64_t)1 << i, below = bit - 1;
+    if (v & bit) {
+      if (r.zeros & bit)
+        return prefix | (allowed & below);
+      if (!(r.ones & bit))
+        best = prefix | (allowed & below);
+      prefix |= bit;
+    } else if (r.ones & bit) {
+      return best;
+    }
+  }
+  return v;
+}
+
+/// Tightens the bounds of \p r to values that agree with its known bits and
+/// the known bits to the prefix shared by its bounds. Returns false if no
+/// value fits.
+bool normalize(Range &r, Expr::Width w) {
+  r.zeros &= mask(w);
+  r.ones &= mask(w);
+  if (r.zeros & r.ones)
+    return false;
+  auto lo = roundUp(r.min, r, w), hi = roundDown(r.max, r, w);
+  if (!lo || !hi || *lo > *hi)
+    return false;
+  r.min = *lo;
+  r.max = *hi;
+  uint64_t prefix = mask(w) & ~fillBits(r.min ^ r.max);
+  r.ones |= r.min & prefix;
+  r.zeros |= ~r.min & prefix;
+  return true;
+}
+
+/// Values in both \p a and \p b.
+std::optional<Range> meet(const Range &a, const Range &b, Expr::Width w) {
+  Range r = {std::max(a.min, b.min), std::min(a.max, b.max), a.zeros | b.zeros,
+             a.ones | b.ones};
+  if (!normalize(r, w))
+    return std::nullopt;
+  return r;
+}
+
+bool same(const Range &a, const Range &b) {
+  return a.min == b.min && a.max == b.max && a.zeros == b.zeros &&
+         a.ones == b.ones;
+}
+
+/// Splits the operands of \p e into a constant, if there is one, and the
+/// other operand.
+std::pair<ref<ConstantExpr>, ref<Expr>> splitConstant(const ref<Expr> &e) {
+  if (auto ce = dyn_cast<ConstantExpr>(e->getKid(1)))
+    return {ce, e->getKid(0)};
+  return {dyn_cast<ConstantExpr>(e->getKid(0)), e->getKid(1)};
+}
+
+s128 toSigned(uint64_t value, Expr::Width w) {
+  if (value >> (w - 1))
+    return (s128)value - ((s128)1 << w);
+  return value;
+}
+
+/// Signed bounds of \p r if it does not cross the sign boundary.
+std::optional<std::pair<s128, s128>> toSigned(Range r, Expr::Width w) {
+  uint64_t signBit = (uint64_t)1 << (w - 1);
+  if (r.max < signBit || r.min >= signBit)
+    return std::make_pair(toSigned(r.min, w), toSigned(r.max, w));
+  return std::nullopt;
+}
+
+/// Decides `kind(a, b)` for operands bounded by \p a and \p b.
+Range compare(Expr::Kind kind, Range a, Range b, Expr::Width w) {
+  switch (kind) {
+  case Expr::Eq:
+    if (a.max < b.min || b.max < a.min || (a.ones & b.zeros) ||
+        (a.zeros & b.ones))
+      return boolean(false);
+    if (a.min == a.max && b.min == b.max)
+      return boolean(true);
+    return unknownBool;
+  case Expr::Ne: {
+    Range eq = compare(Expr::Eq, a, b, w);
+    return {1 - eq.max, 1 - eq.min};
+  }
+  case Expr::Ult:
+    if (a.max < b.min)
+      return boolean(true);
+    if (a.min >= b.max)
+      return boolean(false);
+    return unknownBool;
+  case Expr::Ule:
+    if (a.max <= b.min)
+      return boolean(true);
+    if (a.min > b.max)
+      return boolean(false);
+    return unknownBool;
+  case Expr::Ugt:
+    return compare(Expr::Ult, b, a, w);
+  case Expr::Uge:
+    return compare(Expr::Ule, b, a, w);
+  case Expr::Slt:
+  case Expr::Sle: {
+    auto sa = toSigned(a, w), sb = toSigned(b, w);
+    if (!sa || !sb)
+      return unknownBool;
+    bool strict = kind == Expr::Slt;
+    if (strict ? sa->second < sb->first : sa->second <= sb->first)
+      return boolean(true);
+    if (strict ? sa->first >= sb->second : sa->first > sb->second)
+      return boolean(false);
+    return unknownBool;
+  }
+  case Expr::Sgt:
+    return compare(Expr::Slt, b, a, w);
+  case Expr::Sge:
+    return compare(Expr::Sle, b, a, w);
+  default:
+    return unknownBool;
+  }
+}
+
+/// Bounds `kind(a, b)` for operands bounded by \p a and \p b.
+Range binary(Expr::Kind kind, Range a, Range b, Expr::Width w) {
+  uint64_t m = mask(w);
+  bool exact = b.min == b.max;
+  // the low bits of sums, differences and products only depend on the low
+  // bits of the operands
+  uint64_t low =
+      mask(std::min<unsigned>(trailingOnes(knownBits(a) & knownBits(b)), w));
+  switch (kind) {
+  case Expr::Add:
+    return withLowBits(wrap((u128)a.min + b.min, (u128)a.max + b.max, w),
+                       a.ones + b.ones, low);
+  case Expr::Sub: {
+    u128 mod = (u128)1 << w;
+    return withLowBits(wrap(mod + a.min - b.max, mod + a.max - b.min, w),
+                       a.ones - b.ones, low);
+  }
+  case Expr::Mul: {
+    Range r = withLowBits(wrap((u128)a.min * b.min, (u128)a.max * b.max, w),
+                          a.ones * b.ones, low);
+    unsigned zeros = trailingOnes(a.zeros) + trailingOnes(b.zeros);
+    r.zeros |= mask(std::min<unsigned>(zeros, w));
+    return r;
+  }
+  case Expr::UDiv:
+    if (b.min == 0)
+      return fullRange(w);
+    return {a.min / b.max, a.max / b.min};
+  case Expr::URem: {
+    if (b.min == 0)
+      return fullRange(w);
+    Range r = a.max < b.min ? a : Range{0, std::min(a.max, b.max - 1)};
+    if (exact && bits64::isPowerOfTwo(b.min)) {
+      uint64_t kept = b.min - 1;
+      r.zeros |= (m & ~kept) | (a.zeros & kept);
+      r.ones |= a.ones & kept;
+    }
+    return r;
+  }
+  case Expr::And: {
+    Range r = w == 1 || (a.min == a.max && exact)
+                  ? Range{a.min & b.min, a.max & b.max}
+                  : Range{0, std::min(a.max, b.max)};
+    r.zeros = a.zeros | b.zeros;
+    r.ones = a.ones & b.ones;
+    return r;
+  }
+  case Expr::Or: {
+    Range r = w == 1 || (a.min == a.max && exact)
+                  ? Range{a.min | b.min, a.max | b.max}
+                  : Range{std::max(a.min, b.min), fillBits(a.max | b.max)};
+    r.zeros = a.zeros & b.zeros;
+    r.ones = a.ones | b.ones;
+    return r;
+  }
+  case Expr::Xor:
+    return {0, fillBits(a.max | b.max), (a.zeros & b.zeros) | (a.ones & b.ones),
+            (a.zeros & b.ones) | (a.ones & b.zeros)};
+  case Expr::Shl: {
+    if (!exact || b.min >= w)
+      return fullRange(w);
+    unsigned k = b.min;
+    Range r = wrap((u128)a.min << k, (u128)a.max << k, w);
+    r.zeros = ((a.zeros << k) | mask(k)) & m;
+    r.ones = (a.ones << k) & m;
+    return r;
+  }
+  case Expr::LShr:
+  case Expr::AShr: {
+    if (b.max >= w)
+      return fullRange(w);
+    uint64_t signBit = (uint64_t)1 << (w - 1);
+    bool logical = kind == Expr::LShr || (a.zeros & signBit);
+    Range r = logical ? Range{a.min >> b.max, a.max >> b.min} : fullRange(w);
+    if (exact) {
+      unsigned k = b.min;
+      uint64_t high = m & ~mask(w - k);
+      r.zeros = a.zeros >> k;
+      r.ones = a.ones >> k;
+      if (logical)
+        r.zeros |= high;
+      else if (a.ones & signBit)
+        r.ones |= high;
+    }
+    return r;
+  }
+  default:
+    return fullRange(w);
+  }
+}
+
+class RangeEvaluator {
+public:
+  explicit RangeEvaluator(const RangeIndex::ranges_ty &ranges)
+      : ranges(ranges) {}
+
+  std::optional<Range> eval(const ref<Expr> &e);
+
+private:
+  Range compute(const ref<Expr> &e);
+
+  const RangeIndex::ranges_ty &ranges;
+  ExprHashMap<Range> cache;
+};
+
+std::optional<Range> RangeEvaluator::eval(const ref<Expr> &e) {
+  Expr::Width w = e->getWidth();
+  if (w == 0 || w > 64)
+    return std::nullopt;
+  if (auto ce = dyn_cast<ConstantExpr>(e))
+    return point(ce->getZExtValue(), w);
+  auto it = cache.find(e);
+  if (it != cache.end())
+    return it->second;
+
+  Range r = compute(e);
+  if (!normalize(r, w))
+    r = fullRange(w);
+  if (auto known = ranges.lookup(e)) {
+    // disjoint values only arise from unsatisfiable constraints
+    r = meet(r, *known, w).value_or(*known);
+  }
+  cache.insert({e, r});
+  return r;
+}
+
+Range RangeEvaluator::compute(const ref<Expr> &e) {
+  Expr::Width w = e->getWidth();
+  switch (e->getKind()) {
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    Range cond = *eval(se->cond);
+    Range t = *eval(se->trueExpr), f = *eval(se->falseExpr);
+    if (cond.min == 1)
+      return t;
+    if (cond.max == 0)
+      return f;
+    return {std::min(t.min, f.min), std::max(t.max, f.max), t.zeros & f.zeros,
+            t.ones & f.ones};
+  }
+
+  case Expr::Concat: {
+    const ConcatExpr *ce = cast<ConcatExpr>(e);
+    Range l = *eval(ce->getLeft()), r = *eval(ce->getRight());
+    unsigned shift = ce->getRight()->getWidth();
+    return {(l.min << shift) | r.min, (l.max << shift) | r.max,
+            (l.zeros << shift) | r.zeros, (l.ones << shift) | r.ones};
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    auto kid = eval(ee->expr);
+    if (!kid)
+      return fullRange(w);
+    Range r = wrap(kid->min >> ee->offset, kid->max >> ee->offset, w);
+    r.zeros = kid->zeros >> ee->offset;
+    r.ones = kid->ones >> ee->offset;
+    return r;
+  }
+
+  case Expr::ZExt: {
+    Range r = *eval(e->getKid(0));
+    r.zeros |= mask(w) & ~mask(e->getKid(0)->getWidth());
+    return r;
+  }
+
+  case Expr::SExt: {
+    const ref<Expr> &kid = e->getKid(0);
+    Expr::Width kw = kid->getWidth();
+    Range k = *eval(kid);
+    uint64_t signBit = (uint64_t)1 << (kw - 1);
+    uint64_t ext = mask(w) & ~mask(kw);
+    Range r = k;
+    if (k.min >= signBit)
+      r = {k.min + ext, k.max + ext};
+    else if (k.max >= signBit)
+      r = fullRange(w);
+    r.zeros = k.zeros | (k.zeros & signBit ? ext : 0);
+    r.ones = k.ones | (k.ones & signBit ? ext : 0);
+    return r;
+  }
+
+  case Expr::Not: {
+    Range r = *eval(e->getKid(0));
+    uint64_t max = mask(w);
+    return {max - r.max, max - r.min, r.ones, r.zeros};
+  }
+
+  case Expr::Add:
+  case Expr::Sub:
+  case Expr::Mul:
+  case Expr::UDiv:
+  case Expr::URem:
+  case Expr::And:
+  case Expr::Or:
+  case Expr::Xor:
+  case Expr::Shl:
+  case Expr::LShr:
+  case Expr::AShr:
+    return binary(e->getKind(), *eval(e->getKid(0)), *eval(e->getKid(1)), w);
+
+  case Expr::Eq:
+  case Expr::Ne:
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Ugt:
+  case Expr::Uge:
+  case Expr::Slt:
+  case Expr::Sle:
+  case Expr::Sgt:
+  case Expr::Sge: {
+    auto a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    if (!a || !b)
+      return unknownBool;
+    return compare(e->getKind(), *a, *b, e->getKid(0)->getWidth());
+  }
+
+  default:
+    return fullRange(w);
+  }
+}
+} // namespace
+
+void RangeIndex::add(const ref<Expr> &constraint) { addFact(constraint, true); }
+
+std::optional<RangeIndex::Range>
+RangeIndex::getRange(const ref<Expr> &e) const {
+  return RangeEvaluator(_ranges).eval(e);
+}
+
+std::optional<bool> RangeIndex::evaluate(const ref<Expr> &e) const {
+  assert(e->getWidth() == Expr::Bool && "Expected a boolean expression");
+  auto r = getRange(e);
+  if (!r || r->min != r->max)
+    return std::nullopt;
+  return r->min == 1;
+}
+
+void RangeIndex::addFact(const ref<Expr> &e, bool value) {
+  if (isa<ConstantExpr>(e))
+    return;
+  restrict(e, boolean(value));
+
+  switch (e->getKind()) {
+  case Expr::Not:
+    addFact(e->getKid(0), !value);
+    return;
+  case Expr::And:
+    if (value) {
+      addFact(e->getKid(0), true);
+      addFact(e->getKid(1), true);
+    }
+    return;
+  case Expr::Or:
+    if (!value) {
+      addFact(e->getKid(0), false);
+      addFact(e->getKid(1), false);
+    }
+    return;
+  case Expr::Eq: {
+    auto [ce, x] = splitConstant(e);
+    if (!ce || ce->getWidth() > 64)
+      return;
+    uint64_t c = ce->getZExtValue();
+    if (ce->getWidth() == Expr::Bool) {
+      addFact(x, value == (c == 1));
+    } else if (value) {
+      restrict(x, point(c, ce->getWidth()));
+    } else {
+      // excluding a value only narrows bounds that end at it
+      Range r = *getRange(x);
+      if (r.min == c && r.max > c)
+        restrict(x, {c + 1, r.max, r.zeros, r.ones});
+      else if (r.max == c && r.min < c)
+        restrict(x, {r.min, c - 1, r.zeros, r.ones});
+    }
+    return;
+  }
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Slt:
+  case Expr::Sle:
+    break;
+  default:
+    return;
+  }
+
+  const CmpExpr *cmp = cast<CmpExpr>(e);
+  ref<Expr> a = cmp->left, b = cmp->right;
+  Expr::Kind kind = e->getKind();
+  if (!value) {
+    // !(a < b) is b <= a and !(a <= b) is b < a
+    std::swap(a, b);
+    kind = kind == Expr::Ult   ? Expr::Ule
+           : kind == Expr::Ule ? Expr::Ult
+           : kind == Expr::Slt ? Expr::Sle
+                               : Expr::Slt;
+  }
+  bool constantLeft = isa<ConstantExpr>(a);
+  if (constantLeft == isa<ConstantExpr>(b))
+    return;
+  const ref<Expr> &x = constantLeft ? b : a;
+  Expr::Width w = x->getWidth();
+  if (w > 64)
+    return;
+  uint64_t c = cast<ConstantExpr>(constantLeft ? a : b)->getZExtValue();
+  bool strict = kind == Expr::Ult || kind == Expr::Slt;
+
+  if (kind == Expr::Ult || kind == Expr::Ule) {
+    uint64_t max = mask(w);
+    if (constantLeft && !(strict && c == max))
+      restrict(x, {strict ? c + 1 : c, max});
+    else if (!constantLeft && !(strict && c == 0))
+      restrict(x, {0, strict ? c - 1 : c});
+    return;
+  }
+
+  s128 sc = toSigned(c, w);
+  s128 smin = -((s128)1 << (w - 1)), smax = ((s128)1 << (w - 1)) - 1;
+  s128 lo = smin, hi = smax;
+  if (constantLeft)
+    lo = strict ? sc + 1 : sc;
+  else
+    hi = strict ? sc - 1 : sc;
+  if (lo > hi)
+    return;
+
+  // Signed bounds that cross zero wrap around in unsigned order; they still
+  // narrow the part of the current range on either side of the sign bit.
+  Range r = fullRange(w);
+  if (auto known = _ranges.lookup(x))
+    r = *known;
+  uint64_t signBit = (uint64_t)1 << (w - 1);
+  std::optional<Range> hull;
+  auto join = [&](s128 pieceMin, s128 pieceMax, s128 bias) {
+    s128 pieceLo = std::max(pieceMin, lo), pieceHi = std::min(pieceMax, hi);
+    if (pieceLo > pieceHi)
+      return;
+    Range piece = {(uint64_t)(pieceLo + bias), (uint64_t)(pieceHi + bias)};
+    hull = hull ? Range{hull->min, piece.max} : piece;
+  };
+  if (r.min < signBit)
+    join(r.min, std::min<uint64_t>(r.max, signBit - 1), 0);
+  if (r.max >= signBit) {
+    s128 bias = (s128)1 << w;
+    join(toSigned(std::max(r.min, signBit), w), toSigned(r.max, w), bias);
+  }
+  if (hull)
+    restrict(x, *hull);
+}
+
+void RangeIndex::restrict(const ref<Expr> &e, Range range) {
+  Expr::Width w = e->getWidth();
+  if (w == 0 || w > 64 || isa<ConstantExpr>(e))
+    return;
+  // facts without any value only arise from unsatisfiable constraints
+  if (!normalize(range, w))
+    return;
+  if (auto known = _ranges.lookup(e)) {
+    auto narrowed = meet(range, *known, w);
+    if (!narrowed || same(*narrowed, *known))
+      return;
+    range = *narrowed;
+  } else if (range.min == 0 && range.max == mask(w) && !knownBits(range)) {
+    return;
+  }
+  _ranges.replace({e, range});
+
+  // The value of a result bounds the operands it is computed from
+  uint64_t m = mask(w);
+  switch (e->getKind()) {
+  case Expr::ZExt:
+  case Expr::SExt: {
+    const ref<Expr> &kid = e->getKid(0);
+    Expr::Width kw = kid->getWidth();
+    uint64_t km = mask(kw);
+    Range kidRange = {0, km, range.zeros & km, range.ones & km};
+    if (e->getKind() == Expr::ZExt) {
+      if (range.min <= km) {
+        kidRange.min = range.min;
+        kidRange.max = std::min(range.max, km);
+      }
+      restrict(kid, kidRange);
+      break;
+    }
+    // Non-negative kids keep their value, negative ones land at the top of
+    // the result range. The kid range is the hull of both parts.
+    uint64_t half = mask(kw - 1), extended = m - half;
+    bool low = range.min <= half, high = range.max >= extended;
+    if (low || high) {
+      kidRange.min = low ? range.min
+                         : half + 1 + (std::max(range.min, extended) - extended);
+      kidRange.max = high ? half + 1 + (range.max - extended)
+                          : std::min(range.max, half);
+    }
+    restrict(kid, kidRange);
+    break;
+  }
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    Expr::Width kw = ee->expr->getWidth();
+    if (kw > 64)
+      break;
+    restrict(ee->expr, {0, mask(kw), range.zeros << ee->offset,
+                        range.ones << ee->offset});
+    break;
+  }
+  case Expr::Concat: {
+    const ConcatExpr *ce = cast<ConcatExpr>(e);
+    unsigned shift = ce->getRight()->getWidth();
+    uint64_t rm = mask(shift);
+    restrict(ce->getLeft(), {range.min >> shift, range.max >> shift,
+                             range.zeros >> shift, range.ones >> shift});
+    restrict(ce->getRight(), {0, rm, range.zeros & rm, range.ones & rm});
+    break;
+  }
+  case Expr::Not:
+    restrict(e->getKid(0), {m - range.max, m - range.min, range.ones,
+                            range.zeros});
+    break;
+  case Expr::Add: {
+    auto [ce, x] = splitConstant(e);
+    if (!ce)
+      break;
+    u128 mod = (u128)1 << w;
+    uint64_t c = ce->getZExtValue();
+    uint64_t low = mask(std::min<unsigned>(trailingOnes(knownBits(range)), w));
+    restrict(x,
+             withLowBits(wrap(mod + range.min - c, mod + range.max - c, w),
+                         range.ones - c, low));
+    break;
+  }
+  case Expr::And:
+  case Expr::Or:
+  case Expr::Xor: {
+    // Set bits of an And and clear bits of an Or are set or clear in both
+    // operands. A constant operand tells which other bits come from the
+    // remaining operand.
+    auto [ce, x] = splitConstant(e);
+    uint64_t c = ce ? ce->getZExtValue() : 0;
+    Range kid = fullRange(w);
+    if (e->getKind() == Expr::And) {
+      kid.ones = range.ones;
+      kid.zeros = ce ? range.zeros & c : 0;
+    } else if (e->getKind() == Expr::Or) {
+      kid.zeros = range.zeros;
+      kid.ones = ce ? range.ones & ~c : 0;
+    } else if (ce) {
+      kid.zeros = (range.zeros & ~c) | (range.ones & c);
+      kid.ones = (range.ones & ~c) | (range.zeros & c);
+    }
+    restrict(x, kid);
+    if (!ce && e->getKind() != Expr::Xor)
+      restrict(e->getKid(0), kid);
+    break;
+  }
+  case Expr::Shl:
+  case Expr::LShr: {
+    auto ce = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!ce || ce->getZExtValue() >= w)
+      break;
+    unsigned k = ce->getZExtValue();
+    if (e->getKind() == Expr::Shl) {
+      restrict(e->getKid(0), {0, m, range.zeros >> k, range.ones >> k});
+    } else {
+      u128 hi = ((u128)range.max << k) | mask(k);
+      restrict(e->getKid(0),
+               {range.min << k, (uint64_t)std::min<u128>(hi, m),
+                range.zeros << k, range.ones << k});
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
@@ -9,10 +9,34 @@
 
 #include "klee/Expr/Expr.h"
 
+#include "klee/ADT/ImmutableMap.h"
+
 #include <cassert>
 
 using namespace klee;
 
+namespace klee {
+struct UpdateSnapshot {
+  /// most recent update of each concrete index in the run
+  ImmutableMap<uint64_t, UpdateNode *> latest;
+  /// first update below the run, or nullptr
+  UpdateNode *end = nullptr;
+};
+} // namespace klee
+
+namespace {
+/// number of updates of a concrete run between two snapshots
+const unsigned SnapshotInterval = 32;
+
+bool getConcreteIndex(const ref<Expr> &index, uint64_t &value) {
+  auto CE = dyn_cast<ConstantExpr>(index);
+  if (!CE || CE->getWidth() > 64)
+    return false;
+  value = CE->getZExtValue();
+  return true;
+}
+} // namespace
+
 ///
 
 UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
@@ -27,6 +51,56 @@ UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
   computeHash();
   computeHeight();
   size = next ? next->size + 1 : 1;
+
+  uint64_t concreteIndex;
+  if (getConcreteIndex(index, concreteIndex)) {
+    concreteRun = next ? next->concreteRun + 1 : 1;
+    if (concreteRun % SnapshotInterval == 0)
+      buildSnapshot();
+  } else {
+    concreteRun = 0;
+  }
+}
+
+void UpdateNode::buildSnapshot() {
+  // The updates since the previous snapshot of this run, oldest last
+  std::vector<UpdateNode *> recent;
+  UpdateNode *un = this;
+  for (unsigned i = 0; i < SnapshotInterval; ++i, un = un->next.get())
+    recent.push_back(un);
+
+  auto result = std::make_shared<UpdateSnapshot>();
+  if (concreteRun > SnapshotInterval) {
+    assert(un && un->snapshot && "missing previous snapshot");
+    *result = *un->snapshot;
+  } else {
+    result->end = un;
+  }
+
+  for (auto it = recent.rbegin(), ie = recent.rend(); it != ie; ++it) {
+    uint64_t concreteIndex = 0;
+    getConcreteIndex((*it)->index, concreteIndex);
+    result->latest = result->latest.replace({concreteIndex, *it});
+  }
+  snapshot = std::move(result);
+}
+
+UpdateNode *UpdateNode::findWrite(uint64_t index) {
+  UpdateNode *un = this;
+  while (un && un->concreteRun) {
+    uint64_t concreteIndex = 0;
+    getConcreteIndex(un->index, concreteIndex);
+    if (concreteIndex == index)
+      return un;
+    if (un->snapshot) {
+      if (auto entry = un->snapshot->latest.lookup(index))
+        return entry->second;
+      un = un->snapshot->end;
+    } else {
+      un = un->next.get();
+    }
+  }
+  return un;
 }
 
 extern "C" void vc_DeleteExpr(void *);
@@ -13,6 +13,7 @@
 #include "klee/Module/KModule.h"
 
 #include "llvm/IR/CFG.h"
+#include "llvm/Support/ThreadPool.h"
 
 #include <deque>
 #include <unordered_map>
@@ -66,9 +67,8 @@ void CodeGraphInfo::calculateBackwardDistance(KBlock *bb) {
   }
 }
 
-void CodeGraphInfo::calculateDistance(KFunction *kf) {
-  auto &dist = functionDistance[kf];
-  auto &sort = functionSortedDistance[kf];
+void CodeGraphInfo::calculateDistance(KFunction *kf, FunctionDistanceMap &dist,
+                                      SortedFunctionDistances &sort) {
   std::deque<KFunction *> nodes;
   nodes.push_back(kf);
   dist[kf] = 0;
@@ -91,16 +91,19 @@ void CodeGraphInfo::calculateDistance(KFunction *kf) {
   }
 }
 
-void CodeGraphInfo::calculateBackwardDistance(KFunction *kf) {
-  auto &callMap = kf->parent->callMap;
-  auto &bdist = functionBackwardDistance[kf];
-  auto &bsort = functionSortedBackwardDistance[kf];
+void CodeGraphInfo::calculateBackwardDistance(KFunction *kf,
+                                              FunctionDistanceMap &bdist,
+                                              SortedFunctionDistances &bsort) {
+  const auto &callMap = kf->parent->callMap;
   std::deque<KFunction *> nodes = {kf};
   bdist[kf] = 0;
   bsort.emplace_back(kf, 0);
   for (; !nodes.empty(); nodes.pop_front()) {
     auto currKF = nodes.front();
-    for (auto cf : callMap[currKF]) {
+    auto callers = callMap.find(currKF);
+    if (callers == callMap.end())
+      continue;
+    for (auto cf : callers->second) {
       if (cf->function()->isDeclaration())
         continue;
       auto it = bdist.find(cf);
@@ -147,6 +150,119 @@ void CodeGraphInfo::calculateFunctionBlocks(KFunction *kf) {
   }
 }
 
+void CodeGraphInfo::calculateReachability(KFunction *kf,
+                                          BlockReachability &reachability) {
+  auto &component = reachability.component;
+  auto &reachable = reachability.reachable;
+  unsigned numBlocks = kf->blocks.size();
+
+  // Tarjan's algorithm, which completes a component only after all
+  // components reachable from it
+  std::unordered_map<KBlock *, std::vector<KBlock *>> successors;
+  for (auto &kb : kf->blocks) {
+    auto succs = kb->successors();
+    successors[kb.get()].assign(succs.begin(), succs.end());
+  }
+  std::unordered_map<KBlock *, unsigned> order, lowLink;
+  std::vector<KBlock *> stack;
+  std::vector<std::pair<KBlock *, size_t>> work;
+  auto visit = [&](KBlock *kb) {
+    unsigned n = order.size();
+    order[kb] = lowLink[kb] = n;
+    stack.push_back(kb);
+    work.emplace_back(kb, 0);
+  };
+
+  for (auto &root : kf->blocks) {
+    if (order.count(root.get()))
+      continue;
+    visit(root.get());
+    while (!work.empty()) {
+      KBlock *kb = work.back().first;
+      auto &succs = successors[kb];
+      if (work.back().second < succs.size()) {
+        KBlock *succ = succs[work.back().second++];
+        if (!order.count(succ))
+          visit(succ);
+        else if (!component.count(succ))
+          lowLink[kb] = std::min(lowLink[kb], order[succ]);
+        continue;
+      }
+      work.pop_back();
+      if (!work.empty()) {
+        KBlock *pred = work.back().first;
+        lowLink[pred] = std::min(lowLink[pred], lowLink[kb]);
+      }
+      if (lowLink[kb] != order[kb])
+        continue;
+
+      unsigned c = reachable.size();
+      reachable.emplace_back(numBlocks);
+      reachable[c].set(c);
+      std::vector<KBlock *> members;
+      KBlock *top;
+      do {
+        top = stack.back();
+        stack.pop_back();
+        component[top] = c;
+        members.push_back(top);
+      } while (top != kb);
+      for (auto member : members) {
+        for (auto succ : successors[member]) {
+          reachable[c] |= reachable[component.at(succ)];
+        }
+      }
+    }
+  }
+}
+
+bool CodeGraphInfo::isReachable(const KBlockSet &from, const KBlockSet &to) {
+  if (from.empty() || to.empty())
+    return false;
+  KFunction *kf = (*from.begin())->parent;
+  if (functionReachability.count(kf) == 0)
+    calculateReachability(kf, functionReachability[kf]);
+  const auto &reachability = functionReachability.at(kf);
+
+  llvm::BitVector reachable(kf->blocks.size());
+  for (auto kb : from) {
+    assert(kb->parent == kf && "blocks from different functions");
+    reachable |= reachability.reachable[reachability.component.at(kb)];
+  }
+  for (auto kb : to) {
+    assert(kb->parent == kf && "blocks from different functions");
+    if (reachable.test(reachability.component.at(kb)))
+      return true;
+  }
+  return false;
+}
+
+void CodeGraphInfo::precompute(const KFunctionSet &kfs, unsigned numThreads) {
+  // Each task fills only its own entries, which stay in place while further
+  // entries are inserted
+  llvm::ThreadPool pool(llvm::hardware_concurrency(numThreads));
+  for (auto kf : kfs) {
+    if (functionDistance.count(kf) == 0) {
+      auto &dist = functionDistance[kf];
+      auto &sort = functionSortedDistance[kf];
+      pool.async([kf, &dist, &sort] { calculateDistance(kf, dist, sort); });
+    }
+    if (functionBackwardDistance.count(kf) == 0) {
+      auto &bdist = functionBackwardDistance[kf];
+      auto &bsort = functionSortedBackwardDistance[kf];
+      pool.async([kf, &bdist, &bsort] {
+        calculateBackwardDistance(kf, bdist, bsort);
+      });
+    }
+    if (functionReachability.count(kf) == 0) {
+      auto &reachability = functionReachability[kf];
+      pool.async(
+          [kf, &reachability] { calculateReachability(kf, reachability); });
+    }
+  }
+  pool.wait();
+}
+
 const BlockDistanceMap &CodeGraphInfo::getDistance(KBlock *b) {
   if (blockDistance.count(b) == 0)
     calculateDistance(b);
@@ -167,13 +283,14 @@ const BlockDistanceMap &CodeGraphInfo::getBackwardDistance(KBlock *kb) {
 
 const FunctionDistanceMap &CodeGraphInfo::getDistance(KFunction *kf) {
   if (functionDistance.count(kf) == 0)
-    calculateDistance(kf);
+    calculateDistance(kf, functionDistance[kf], functionSortedDistance[kf]);
   return functionDistance.at(kf);
 }
 
 const FunctionDistanceMap &CodeGraphInfo::getBackwardDistance(KFunction *kf) {
   if (functionBackwardDistance.count(kf) == 0)
-    calculateBackwardDistance(kf);
+    calculateBackwardDistance(kf, functionBackwardDistance[kf],
+                              functionSortedBackwardDistance[kf]);
   return functionBackwardDistance.at(kf);
 }
 
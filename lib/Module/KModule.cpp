@@ -33,6 +33,7 @@
 #include "llvm/Transforms/Utils.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -218,15 +219,19 @@ void KModule::instrument(const Interpreter::ModuleOptions &opts) {
                    module.get());
 }
 
-void KModule::optimiseAndPrepare(
-    const Interpreter::ModuleOptions &opts,
-    llvm::ArrayRef<const char *> preservedFunctions) {
+void KModule::addInternalFunctions(const Interpreter::ModuleOptions &opts) {
   // Add internal functions which are not used to check if instructions
   // have been already visited
   if (opts.CheckDivZero)
     addInternalFunction("klee_div_zero_check");
   if (opts.CheckOvershift)
     addInternalFunction("klee_overshift_check");
+}
+
+void KModule::optimiseAndPrepare(
+    const Interpreter::ModuleOptions &opts,
+    llvm::ArrayRef<const char *> preservedFunctions) {
+  addInternalFunctions(opts);
 
   klee::optimiseAndPrepare(OptimiseKLEECall, opts.Optimize, opts.Simplify,
                            opts.WithFPRuntime, SwitchType, opts.EntryPoint,
@@ -265,6 +270,14 @@ buildInstructionToLineMap(const llvm::Module &m,
   return a.getMapping();
 }
 
+void KModule::setPreparedModule(std::unique_ptr<llvm::Module> preparedModule,
+                                const Interpreter::ModuleOptions &opts) {
+  assert(!module && "module already set");
+  module = std::move(preparedModule);
+  targetData = std::make_unique<llvm::DataLayout>(module.get());
+  addInternalFunctions(opts);
+}
+
 void KModule::manifest(InterpreterHandler *ih,
                        Interpreter::GuidanceKind guidance,
                        bool forceSourceOutput) {
@@ -346,6 +359,10 @@ void KModule::manifest(InterpreterHandler *ih,
     }
   }
 
+  if (guidance == Interpreter::GuidanceKind::ErrorGuidance) {
+    locationIndex.build(functions);
+  }
+
   if (DebugPrintEscapingFunctions && !escapingFunctions.empty()) {
     llvm::errs() << "KLEE: escaping functions: [";
     std::string delimiter = "";
@@ -440,6 +457,25 @@ unsigned KModule::getFunctionId(const llvm::Function *func) const {
 unsigned KModule::getGlobalIndex(const llvm::Function *func) const {
   return functionMap.at(func)->getGlobalIndex();
 }
+KInstruction *KModule::getInstruction(unsigned globalIndex) const {
+  // Each function takes one global index, followed by those of its
+  // instructions in order
+  auto it = std::upper_bound(
+      functions.begin(), functions.end(), globalIndex,
+      [](unsigned index, const std::unique_ptr<KFunction> &kf) {
+        return index < kf->getGlobalIndex();
+      });
+  assert(it != functions.begin() && "global index out of range");
+  const KFunction *kf = (--it)->get();
+  if (globalIndex == kf->getGlobalIndex())
+    return nullptr;
+  unsigned n = globalIndex - kf->getGlobalIndex() - 1;
+  assert(n < kf->numInstructions && "global index out of range");
+  KInstruction *ki = kf->instructions[n];
+  assert(ki->getGlobalIndex() == globalIndex);
+  return ki;
+}
+
 unsigned KModule::getGlobalIndex(const llvm::Instruction *inst) const {
   return functionMap.at(inst->getFunction())
       ->instructionMap.at(inst)
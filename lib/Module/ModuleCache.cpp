@@ -0,0 +1,139 @@
+//===-- ModuleCache.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Module/ModuleCache.h"
+
+#include "klee/Config/CompileTimeInfo.h"
+#include "klee/Config/config.h"
+#include "klee/Support/ErrorHandling.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace klee;
+
+namespace {
+/// Output stream feeding everything written to it into a hash.
+class HashingOStream : public llvm::raw_ostream {
+  llvm::SHA1 &hasher;
+  std::uint64_t pos = 0;
+
+  void write_impl(const char *ptr, size_t size) override {
+    hasher.update(llvm::ArrayRef<std::uint8_t>(
+        reinterpret_cast<const std::uint8_t *>(ptr), size));
+    pos += size;
+  }
+  std::uint64_t current_pos() const override { return pos; }
+
+public:
+  explicit HashingOStream(llvm::SHA1 &hasher) : hasher(hasher) {}
+  ~HashingOStream() override { flush(); }
+};
+} // namespace
+
+ModuleCacheKey::ModuleCacheKey() {
+  add(PACKAGE_STRING);
+  add(KLEE_BUILD_MODE);
+#ifdef KLEE_BUILD_REVISION
+  add(KLEE_BUILD_REVISION);
+#endif
+  add(LLVM_VERSION_MAJOR);
+  add(LLVM_VERSION_MINOR);
+}
+
+void ModuleCacheKey::add(llvm::StringRef data) {
+  // length prefix, so that consecutive strings cannot run into each other
+  add(static_cast<std::uint64_t>(data.size()));
+  hasher.update(data);
+}
+
+void ModuleCacheKey::add(std::uint64_t value) {
+  std::uint8_t bytes[sizeof(value)];
+  for (unsigned i = 0; i < sizeof(value); ++i)
+    bytes[i] = (value >> (8 * i)) & 0xff;
+  hasher.update(bytes);
+}
+
+void ModuleCacheKey::add(const llvm::Module &module) {
+  HashingOStream os(hasher);
+  llvm::WriteBitcodeToFile(module, os);
+}
+
+void ModuleCacheKey::addFile(const std::string &path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    add("<missing>");
+    return;
+  }
+  add(buffer.get()->getBuffer());
+}
+
+std::string ModuleCacheKey::str() { return llvm::toHex(hasher.final(), true); }
+
+std::string ModuleCache::getPath(const std::string &key) const {
+  llvm::SmallString<128> path(directory);
+  llvm::sys::path::append(path, key + ".bc");
+  return path.str().str();
+}
+
+std::unique_ptr<llvm::Module>
+ModuleCache::lookup(const std::string &key, llvm::LLVMContext &ctx) const {
+  std::string path = getPath(key);
+  if (!llvm::sys::fs::exists(path))
+    return nullptr;
+
+  // Entries may be damaged, e.g. by a killed run, which must not be fatal:
+  // drop them and let the caller prepare and store the module again.
+  llvm::SMDiagnostic error;
+  auto module = llvm::parseIRFile(path, error, ctx);
+  if (!module) {
+    klee_warning("Ignoring unreadable module cache entry %s: %s", path.c_str(),
+                 error.getMessage().str().c_str());
+    llvm::sys::fs::remove(path);
+    return nullptr;
+  }
+  return module;
+}
+
+void ModuleCache::store(const std::string &key,
+                        const llvm::Module &module) const {
+  if (auto ec = llvm::sys::fs::create_directories(directory)) {
+    klee_warning("Unable to create module cache directory %s: %s",
+                 directory.c_str(), ec.message().c_str());
+    return;
+  }
+
+  std::string path = getPath(key);
+  std::string tmpPath =
+      path + ".tmp" + std::to_string(llvm::sys::Process::getProcessId());
+  {
+    std::error_code ec;
+    llvm::raw_fd_ostream os(tmpPath, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+      klee_warning("Unable to write module cache entry %s: %s",
+                   tmpPath.c_str(), ec.message().c_str());
+      return;
+    }
+    llvm::WriteBitcodeToFile(module, os);
+  }
+  if (auto ec = llvm::sys::fs::rename(tmpPath, path)) {
+    klee_warning("Unable to write module cache entry %s: %s", path.c_str(),
+                 ec.message().c_str());
+    llvm::sys::fs::remove(tmpPath);
+  }
+}
@@ -0,0 +1,129 @@
+//===-- SourceLocationIndex.cpp -------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Module/SourceLocationIndex.h"
+
+#include "klee/Module/KInstruction.h"
+#include "klee/Module/KModule.h"
+#include "klee/Module/LocationInfo.h"
+
+#include "llvm/IR/IntrinsicInst.h"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace klee;
+
+void SourceLocationIndex::build(
+    const std::vector<std::unique_ptr<KFunction>> &functions) {
+  files.clear();
+  for (const auto &kf : functions) {
+    if (kf->blocks.empty())
+      continue;
+    File &file = files[kf->getSourceFilepath()];
+    for (const auto &kb : kf->blocks) {
+      KBlock *block = kb.get();
+      size_t first = 0, last = 0;
+      for (unsigned i = 0, ie = block->getNumInstructions(); i < ie; ++i) {
+        KInstruction *ki = block->instructions[i];
+        auto info = getLocationInfo(ki->inst());
+        size_t column = info.column.value_or(0);
+        if (i == 0)
+          first = info.line;
+        if (i + 1 == ie)
+          last = info.line;
+        if (!llvm::isa<llvm::DbgInfoIntrinsic>(ki->inst()))
+          file.instructions.push_back({info.line, column, ki});
+      }
+      file.blocks.push_back({first, last, block});
+    }
+  }
+
+  for (auto &[name, file] : files) {
+    std::stable_sort(file.blocks.begin(), file.blocks.end(),
+                     [](const BlockLines &a, const BlockLines &b) {
+                       return a.first < b.first;
+                     });
+    std::stable_sort(
+        file.instructions.begin(), file.instructions.end(),
+        [](const InstructionPosition &a, const InstructionPosition &b) {
+          return std::tie(a.line, a.column) < std::tie(b.line, b.column);
+        });
+    if (!file.blocks.empty()) {
+      file.maxLast.assign(4 * file.blocks.size(), 0);
+      buildMaxLast(file, 1, 0, file.blocks.size());
+    }
+  }
+}
+
+void SourceLocationIndex::buildMaxLast(File &file, size_t node, size_t begin,
+                                       size_t end) {
+  if (end - begin == 1) {
+    file.maxLast[node] = file.blocks[begin].last;
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  buildMaxLast(file, 2 * node, begin, middle);
+  buildMaxLast(file, 2 * node + 1, middle, end);
+  file.maxLast[node] =
+      std::max(file.maxLast[2 * node], file.maxLast[2 * node + 1]);
+}
+
+void SourceLocationIndex::collectBlocks(const File &file, size_t node,
+                                        size_t begin, size_t end, size_t count,
+                                        size_t startLine,
+                                        std::vector<KBlock *> &result) {
+  // Only the first `count` blocks start early enough, and a subtree whose
+  // blocks all end before `startLine` has nothing to report.
+  if (begin >= count || file.maxLast[node] < startLine)
+    return;
+  if (end - begin == 1) {
+    result.push_back(file.blocks[begin].block);
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  collectBlocks(file, 2 * node, begin, middle, count, startLine, result);
+  collectBlocks(file, 2 * node + 1, middle, end, count, startLine, result);
+}
+
+void SourceLocationIndex::findBlocks(const std::string &name, size_t startLine,
+                                     size_t endLine,
+                                     std::vector<KBlock *> &result) const {
+  auto it = files.find(name);
+  if (it == files.end() || it->second.blocks.empty())
+    return;
+  const File &file = it->second;
+  size_t count =
+      std::upper_bound(file.blocks.begin(), file.blocks.end(), endLine,
+                       [](size_t line, const BlockLines &block) {
+                         return line < block.first;
+                       }) -
+      file.blocks.begin();
+  collectBlocks(file, 1, 0, file.blocks.size(), count, startLine, result);
+}
+
+void SourceLocationIndex::findInstructions(
+    const std::string &name, size_t startLine, size_t endLine,
+    size_t startColumn, size_t endColumn,
+    std::vector<InstructionPosition> &result) const {
+  auto it = files.find(name);
+  if (it == files.end())
+    return;
+  const auto &instructions = it->second.instructions;
+  auto position =
+      std::lower_bound(instructions.begin(), instructions.end(), startLine,
+                       [](const InstructionPosition &inst, size_t line) {
+                         return inst.line < line;
+                       });
+  for (; position != instructions.end() && position->line <= endLine;
+       ++position) {
+    if (position->column >= startColumn && position->column <= endColumn)
+      result.push_back(*position);
+  }
+}
@@ -18,14 +18,49 @@
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/ExprHashMap.h"
 #include "klee/Solver/SolverImpl.h"
+#include "klee/Support/OptionCategories.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
 
 using namespace klee;
 using namespace llvm;
 
+namespace {
+cl::opt<unsigned> AlphaEquivalenceCacheSize(
+    "alpha-equivalence-cache-size", cl::init(65536),
+    cl::desc("Maximum number of alpha-renamed constraints memoized across "
+             "queries. 0 disables the memoization (default=65536)"),
+    cl::cat(SolvingCat));
+
+/// Alpha-renamed constraints of earlier queries. Constraints are renamed in
+/// the order of the constraint set, and the alpha version of a constraint
+/// only depends on the arrays met in the constraints before it, so the
+/// renamings are kept in a trie keyed by the constraints of the set.
+struct AlphaNode {
+  /// alpha version of the constraint leading to this node
+  ref<Expr> alpha;
+  /// arrays first met in that constraint, with their alpha versions
+  std::vector<std::pair<const Array *, const Array *>> arrays;
+  /// builder index after renaming the constraint
+  unsigned index = 0;
+  ExprHashMap<std::unique_ptr<AlphaNode>> children;
+};
+} // namespace
+
 class AlphaEquivalenceSolver : public SolverImpl {
 private:
   std::unique_ptr<Solver> solver;
 
+  AlphaNode renamed;
+  size_t renamedCount = 0;
+
+  constraints_ty buildConstraints(const constraints_ty &cs,
+                                  AlphaBuilder &builder);
+
 public:
   AlphaEquivalenceSolver(std::unique_ptr<Solver> solver)
       : solver(std::move(solver)) {}
@@ -128,10 +163,47 @@ AlphaEquivalenceSolver::changeVersion(ref<SolverResponse> res,
   return reverseRes;
 }
 
+constraints_ty
+AlphaEquivalenceSolver::buildConstraints(const constraints_ty &cs,
+                                         AlphaBuilder &builder) {
+  if (!AlphaEquivalenceCacheSize) {
+    return builder.visitConstraints(cs);
+  }
+  if (renamedCount >= AlphaEquivalenceCacheSize) {
+    renamed.children.clear();
+    renamedCount = 0;
+  }
+
+  constraints_ty result;
+  AlphaNode *node = &renamed;
+  for (const auto &constraint : cs) {
+    auto &child = node->children[constraint];
+    if (child) {
+      for (const auto &[array, alpha] : child->arrays) {
+        builder.mapArray(array, alpha, child->index);
+      }
+    } else {
+      child = std::make_unique<AlphaNode>();
+      size_t mapped = builder.getMappedArrays().size();
+      child->alpha = builder.build(constraint);
+      const auto &arrays = builder.getMappedArrays();
+      for (size_t i = mapped; i < arrays.size(); ++i) {
+        child->arrays.emplace_back(arrays[i],
+                                   builder.alphaArrayMap.at(arrays[i]));
+      }
+      child->index = builder.getIndex();
+      ++renamedCount;
+    }
+    result.insert(child->alpha);
+    node = child.get();
+  }
+  return result;
+}
+
 bool AlphaEquivalenceSolver::computeValidity(const Query &query,
                                              PartialValidity &result) {
   AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery = buildConstraints(query.constraints.cs(), builder);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   return solver->impl->computeValidity(
       Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -140,7 +212,7 @@ bool AlphaEquivalenceSolver::computeValidity(const Query &query,
 
 bool AlphaEquivalenceSolver::computeTruth(const Query &query, bool &isValid) {
   AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery = buildConstraints(query.constraints.cs(), builder);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   return solver->impl->computeTruth(
       Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -150,7 +222,7 @@ bool AlphaEquivalenceSolver::computeTruth(const Query &query, bool &isValid) {
 bool AlphaEquivalenceSolver::computeValue(const Query &query,
                                           ref<Expr> &result) {
   AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery = buildConstraints(query.constraints.cs(), builder);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   return solver->impl->computeValue(
       Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -161,7 +233,7 @@ bool AlphaEquivalenceSolver::computeInitialValues(
     const Query &query, const std::vector<const Array *> &objects,
     std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
   AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery = buildConstraints(query.constraints.cs(), builder);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   const std::vector<const Array *> newObjects = changeVersion(objects, builder);
 
@@ -177,7 +249,7 @@ bool AlphaEquivalenceSolver::check(const Query &query,
                                    ref<SolverResponse> &result) {
   AlphaBuilder builder;
 
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery = buildConstraints(query.constraints.cs(), builder);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   if (!solver->impl->check(
           Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -194,7 +266,7 @@ bool AlphaEquivalenceSolver::computeValidityCore(const Query &query,
                                                  bool &isValid) {
   AlphaBuilder builder;
 
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery = buildConstraints(query.constraints.cs(), builder);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   if (!solver->impl->computeValidityCore(
           Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -18,6 +18,7 @@
 #include "klee/Expr/Expr.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Support/ErrorHandling.h"
 
 #include "llvm/ADT/APFloat.h"
@@ -429,21 +430,37 @@ Term BitwuzlaBuilder::getArrayForUpdate(const Array *root,
   return un_expr;
 }
 
+Term BitwuzlaBuilder::construct(ref<Expr> e) {
+  TimerStatIncrementer timer(stats::translationTime);
+  Term res = construct(std::move(e), nullptr);
+  if (autoClearConstructCache)
+    clearConstructCache();
+  return res;
+}
+
 Term BitwuzlaBuilder::construct(ref<Expr> e, int *width_out) {
   if (!BitwuzlaHashConfig::UseConstructHashBitwuzla || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<Term, unsigned>>::iterator it = constructed.find(e);
-    if (it != constructed.end()) {
+    if (ConstructedExpr *entry = constructed.lookup(e)) {
+      ++stats::translationCacheHits;
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = entry->width;
+      sideConstraints.insert(sideConstraints.end(),
+                             entry->sideConstraints.begin(),
+                             entry->sideConstraints.end());
+      return entry->handle;
     } else {
+      ++stats::translationCacheMisses;
       int width;
       if (!width_out)
         width_out = &width;
+      size_t numSideConstraints = sideConstraints.size();
       Term res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      constructed.insert(
+          e, {res, static_cast<unsigned>(*width_out),
+              std::vector<Term>(sideConstraints.begin() + numSideConstraints,
+                                sideConstraints.end())});
       return res;
     }
   }
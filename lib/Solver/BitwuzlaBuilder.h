@@ -10,6 +10,7 @@
 #ifndef BITWUZLABUILDER_H_
 #define BITWUZLABUILDER_H_
 
+#include "TranslationCache.h"
 #include "klee/Expr/ArrayExprHash.h"
 #include "klee/Expr/ExprHashMap.h"
 
@@ -17,6 +18,7 @@
 
 #include <bitwuzla/cpp/bitwuzla.h>
 #include <unordered_map>
+#include <vector>
 
 using namespace bitwuzla;
 
@@ -107,7 +109,15 @@ protected:
   Term getRoundingModeSort(llvm::APFloat::roundingMode rm);
   Term getx87FP80ExplicitSignificandIntegerBit(const Term &e);
 
-  ExprHashMap<std::pair<Term, unsigned>> constructed;
+  struct ConstructedExpr {
+    Term handle;
+    unsigned width;
+    /// Side constraints needed by the expression, which have to be
+    /// asserted again whenever it is reused.
+    std::vector<Term> sideConstraints;
+  };
+
+  TranslationCache<ConstructedExpr> constructed;
   BitwuzlaArrayExprHash _arr_hash;
   bool autoClearConstructCache;
 
@@ -127,13 +137,11 @@ public:
   Term buildFreshBoolConst();
   Term getInitialRead(const Array *os, unsigned index);
 
-  Term construct(ref<Expr> e) {
-    Term res = construct(std::move(e), nullptr);
-    if (autoClearConstructCache)
-      clearConstructCache();
-    return res;
-  }
+  Term construct(ref<Expr> e);
   void clearConstructCache() { constructed.clear(); }
+  /// Called by the solver after each query. Constructed expressions are
+  /// kept for later queries as long as they fit into the cache.
+  void finishQuery() { constructed.finishQuery(); }
   void clearSideConstraints() { sideConstraints.clear(); }
 };
 } // namespace klee
@@ -9,9 +9,11 @@
 
 #include "klee/Solver/Solver.h"
 
+#include "klee/ADT/GenerationalCache.h"
 #include "klee/ADT/MapOfSets.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Solver/SolverImpl.h"
 #include "klee/Solver/SolverStats.h"
@@ -21,7 +23,9 @@
 
 #include "llvm/Support/CommandLine.h"
 
+#include <map>
 #include <memory>
+#include <unordered_set>
 #include <utility>
 
 using namespace klee;
@@ -50,6 +54,12 @@ cl::opt<bool> CexCacheValidityCores(
     "cex-cache-validity-cores", cl::init(false),
     cl::desc("Cache assignment and it's validity cores (default=false)"),
     cl::cat(SolvingCat));
+
+cl::opt<unsigned> CexCacheSize(
+    "cex-cache-size",
+    cl::desc("Maximum number of entries kept in each generation of the "
+             "counterexample cache. 0 means no limit (default=65536)"),
+    cl::init(65536), cl::cat(SolvingCat));
 } // namespace
 
 ///
@@ -63,16 +73,47 @@ struct ResponseComparator {
   }
 };
 
+/// Evaluates cached assignments against one query, remembering those that
+/// do not satisfy it. The same assignment is usually stored under many keys,
+/// so a lookup would otherwise evaluate it over and over again.
+class AssignmentProbe {
+  const KeyType &key;
+  std::unordered_set<const SolverResponse *> rejected;
+
+public:
+  explicit AssignmentProbe(const KeyType &key) : key(key) {}
+
+  bool satisfies(const ref<SolverResponse> &a) {
+    if (!isa<InvalidResponse>(a) || rejected.count(a.get()))
+      return false;
+    ++stats::cexCacheProbes;
+    if (cast<InvalidResponse>(a)->satisfiesOrConstant(key))
+      return true;
+    rejected.insert(a.get());
+    return false;
+  }
+};
+
 class CexCachingSolver : public SolverImpl {
-  typedef std::set<ref<SolverResponse>, ResponseComparator> responseTable_ty;
+  typedef std::map<ref<SolverResponse>, ref<SolverResponse>, ResponseComparator>
+      responseTable_ty;
+  typedef MapOfSets<ref<Expr>, ref<SolverResponse>, util::ExprHash> cache_ty;
 
   std::unique_ptr<Solver> solver;
 
-  MapOfSets<ref<Expr>, ref<SolverResponse>> cache;
-  // memo table
-  responseTable_ty responseTable;
+  /// Responses are kept in two generations of at most --cex-cache-size
+  /// entries. Once the current generation is full, the previous one is
+  /// dropped together with the assignments only it used. Responses found in
+  /// the previous generation are cached again in the current one.
+  GenerationalCache<KeyType, ref<SolverResponse>, cache_ty> cache{
+      CexCacheSize};
+  // memo table, rotated together with the cache
+  GenerationalCache<ref<SolverResponse>, ref<SolverResponse>, responseTable_ty>
+      responseTable;
 
   bool searchForResponse(KeyType &key, ref<SolverResponse> &result);
+  bool searchCache(cache_ty &generation, KeyType &key,
+                   AssignmentProbe &probe, ref<SolverResponse> &result);
 
   bool lookupResponse(const Query &query, KeyType &key,
                       ref<SolverResponse> &result);
@@ -84,6 +125,10 @@ class CexCachingSolver : public SolverImpl {
 
   bool getResponse(const Query &query, ref<SolverResponse> &result);
   void setResponse(const Query &query, ref<SolverResponse> &result);
+  /// Returns the memorized response equal to \p result.
+  ref<SolverResponse> memorize(const ref<SolverResponse> &result);
+  /// Starts a new generation if the current one is full.
+  void evict();
 
 public:
   CexCachingSolver(std::unique_ptr<Solver> solver)
@@ -119,26 +164,26 @@ struct isInvalidResponse {
 };
 
 struct isValidOrSatisfyingResponse {
-  KeyType key;
-  isValidOrSatisfyingResponse(KeyType &_key) : key(_key) {}
+  AssignmentProbe &probe;
+  isValidOrSatisfyingResponse(AssignmentProbe &_probe) : probe(_probe) {}
 
   bool operator()(ref<SolverResponse> a) const {
-    return isa<ValidResponse>(a) ||
-           (isa<InvalidResponse>(a) &&
-            cast<InvalidResponse>(a)->satisfiesOrConstant(key));
+    return isa<ValidResponse>(a) || probe.satisfies(a);
   }
 };
 
-/// searchForResponse - Look for a cached solution for a query.
+/// searchCache - Look for a cached solution for a query in one generation
+/// of the cache.
 ///
+/// \param generation - The generation to search.
 /// \param key - The query to look up.
-/// \param result [out] - The cached result, if the lookup is successful. This
-/// is either a satisfying invalid response (for a satisfiable query), or valid
-/// response (for an unsatisfiable query). \return - True if a cached result was
-/// found.
-bool CexCachingSolver::searchForResponse(KeyType &key,
-                                         ref<SolverResponse> &result) {
-  const ref<SolverResponse> *lookup = cache.lookup(key);
+/// \param probe - Evaluates cached assignments against the query.
+/// \param result [out] - The cached result, if the lookup is successful.
+/// \return - True if a cached result was found.
+bool CexCachingSolver::searchCache(cache_ty &generation, KeyType &key,
+                                   AssignmentProbe &probe,
+                                   ref<SolverResponse> &result) {
+  const ref<SolverResponse> *lookup = generation.lookup(key);
   if (lookup) {
     result = *lookup;
     return true;
@@ -149,30 +194,17 @@ bool CexCachingSolver::searchForResponse(KeyType &key,
     // a response for any subset.
     ref<SolverResponse> *lookup = 0;
     if (CexCacheSuperSet)
-      lookup = cache.findSuperset(key, isInvalidResponse());
+      lookup = generation.findSuperset(key, isInvalidResponse());
 
     // Otherwise, look for a subset which is unsatisfiable, see below.
     if (!lookup)
-      lookup = cache.findSubset(key, isValidResponse());
+      lookup = generation.findSubset(key, isValidResponse());
 
     // If either lookup succeeded, then we have a cached solution.
     if (lookup) {
       result = *lookup;
       return true;
     }
-
-    // Otherwise, iterate through the set of current solver responses to see if
-    // one of them satisfies the query.
-    for (responseTable_ty::iterator it = responseTable.begin(),
-                                    ie = responseTable.end();
-         it != ie; ++it) {
-      ref<SolverResponse> a = *it;
-      if (isa<InvalidResponse>(a) &&
-          cast<InvalidResponse>(a)->satisfiesOrConstant(key)) {
-        result = a;
-        return true;
-      }
-    }
   } else {
     // FIXME: Which order? one is sure to be better.
 
@@ -180,7 +212,7 @@ bool CexCachingSolver::searchForResponse(KeyType &key,
     // a response for any subset.
     ref<SolverResponse> *lookup = 0;
     if (CexCacheSuperSet)
-      lookup = cache.findSuperset(key, isInvalidResponse());
+      lookup = generation.findSuperset(key, isInvalidResponse());
 
     // Otherwise, look for a subset which is unsatisfiable -- if the subset is
     // unsatisfiable then no additional constraints can produce a valid
@@ -188,7 +220,7 @@ bool CexCachingSolver::searchForResponse(KeyType &key,
     // solutions for satisfiable subsets to see if they solve the current query
     // and return them if so. This is cheap and frequently succeeds.
     if (!lookup)
-      lookup = cache.findSubset(key, isValidOrSatisfyingResponse(key));
+      lookup = generation.findSubset(key, isValidOrSatisfyingResponse(probe));
 
     // If either lookup succeeded, then we have a cached solution.
     if (lookup) {
@@ -200,6 +232,46 @@ bool CexCachingSolver::searchForResponse(KeyType &key,
   return false;
 }
 
+/// searchForResponse - Look for a cached solution for a query.
+///
+/// \param key - The query to look up.
+/// \param result [out] - The cached result, if the lookup is successful. This
+/// is either a satisfying invalid response (for a satisfiable query), or valid
+/// response (for an unsatisfiable query). \return - True if a cached result was
+/// found.
+bool CexCachingSolver::searchForResponse(KeyType &key,
+                                         ref<SolverResponse> &result) {
+  TimerStatIncrementer t(stats::cexCacheLookupTime);
+  AssignmentProbe probe(key);
+
+  if (searchCache(cache.getCurrent(), key, probe, result))
+    return true;
+
+  if (searchCache(cache.getPrevious(), key, probe, result)) {
+    evict();
+    if (isa<InvalidResponse>(result))
+      result = memorize(result);
+    cache.getCurrent().insert(key, result);
+    return true;
+  }
+
+  if (CexCacheTryAll) {
+    // Otherwise, iterate through the set of current solver responses to see if
+    // one of them satisfies the query.
+    for (const responseTable_ty *table :
+         {&responseTable.getCurrent(), &responseTable.getPrevious()}) {
+      for (const auto &entry : *table) {
+        if (probe.satisfies(entry.second)) {
+          result = entry.second;
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
 KeyType makeKey(const Query &query) {
   KeyType key =
       KeyType(query.constraints.cs().begin(), query.constraints.cs().end());
@@ -257,13 +329,11 @@ void CexCachingSolver::setResponse(const Query &query,
                                    ref<SolverResponse> &result) {
   KeyType key = makeKey(query);
 
+  evict();
+
   if (isa<InvalidResponse>(result)) {
     // Memorize the result.
-    std::pair<responseTable_ty::iterator, bool> res =
-        responseTable.insert(result);
-    if (!res.second) {
-      result = *res.first;
-    }
+    result = memorize(result);
 
     if (DebugCexCacheCheckBinding) {
       if (!cast<InvalidResponse>(result)->satisfiesOrConstant(key, false)) {
@@ -281,16 +351,35 @@ void CexCachingSolver::setResponse(const Query &query,
                                   resultCore.constraints.end());
     ref<Expr> neg = Expr::createIsZero(resultCore.expr);
     resultCoreConstarints.insert(neg);
-    cache.insert(resultCoreConstarints, result);
+    cache.getCurrent().insert(resultCoreConstarints, result);
   }
   if (isa<ValidResponse>(result) || isa<InvalidResponse>(result)) {
-    cache.insert(key, result);
+    cache.getCurrent().insert(key, result);
+  }
+}
+
+ref<SolverResponse>
+CexCachingSolver::memorize(const ref<SolverResponse> &result) {
+  if (ref<SolverResponse> *memorized = responseTable.lookup(result))
+    return *memorized;
+  responseTable.insert(result, result);
+  return result;
+}
+
+void CexCachingSolver::evict() {
+  std::size_t dropped = cache.getPrevious().size();
+  if (cache.makeRoom()) {
+    stats::cexCacheEvictions += dropped;
+    responseTable.rotate();
   }
 }
 
 ///
 
-CexCachingSolver::~CexCachingSolver() { cache.clear(); }
+CexCachingSolver::~CexCachingSolver() {
+  cache.clear();
+  responseTable.clear();
+}
 
 bool CexCachingSolver::computeValidity(const Query &query,
                                        PartialValidity &result) {
@@ -14,6 +14,7 @@
 #include "klee/Expr/Assignment.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/IndependentConstraintSetUnion.h"
 #include "klee/Expr/IndependentSet.h"
@@ -34,7 +35,7 @@ typedef std::set<ref<Expr>> KeyType;
 class ConcretizingSolver : public SolverImpl {
 private:
   std::unique_ptr<Solver> solver;
-  MapOfSets<ref<Expr>, Assignment> cache;
+  MapOfSets<ref<Expr>, Assignment, util::ExprHash> cache;
 
 public:
   ConcretizingSolver(std::unique_ptr<Solver> _solver)
@@ -26,11 +26,17 @@ namespace klee {
 std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
-    std::string baseSolverQueryKQueryLogPath) {
+    std::string baseSolverQueryKQueryLogPath,
+    const SolverLayerHook &layerHook) {
   Solver *rawCoreSolver = coreSolver.get();
   std::unique_ptr<Solver> solver = std::move(coreSolver);
   const time::Span minQueryTimeToLog(MinQueryTimeToLog);
 
+  auto addLayer = [&](std::unique_ptr<Solver> layer, const char *name) {
+    solver = layerHook ? layerHook(std::move(layer), name) : std::move(layer);
+  };
+  addLayer(std::move(solver), "core");
+
   if (QueryLoggingOptions.isSet(SOLVER_KQUERY)) {
     solver = createKQueryLoggingSolver(std::move(solver),
                                        baseSolverQueryKQueryLogPath,
@@ -48,34 +54,39 @@ std::unique_ptr<Solver> constructSolverChain(
   }
 
   if (UseAssignmentValidatingSolver)
-    solver = createAssignmentValidatingSolver(std::move(solver));
+    addLayer(createAssignmentValidatingSolver(std::move(solver)),
+             "assignment-validating");
 
   if (UseFastCexSolver)
-    solver = createFastCexSolver(std::move(solver));
+    addLayer(createFastCexSolver(std::move(solver)), "fast-cex");
 
   if (UseCexCache)
-    solver = createCexCachingSolver(std::move(solver));
+    addLayer(createCexCachingSolver(std::move(solver)), "cex-cache");
 
   if (UseBranchCache)
-    solver = createCachingSolver(std::move(solver));
+    addLayer(createCachingSolver(std::move(solver)), "branch-cache");
 
   if (UseAlphaEquivalence)
-    solver = createAlphaEquivalenceSolver(std::move(solver));
+    addLayer(createAlphaEquivalenceSolver(std::move(solver)),
+             "alpha-equivalence");
 
   if (UseIndependentSolver)
-    solver = createIndependentSolver(std::move(solver));
+    addLayer(createIndependentSolver(std::move(solver)), "independent");
 
   if (UseConcretizingSolver)
-    solver = createConcretizingSolver(std::move(solver));
+    addLayer(createConcretizingSolver(std::move(solver)), "concretizing");
 
   if (UseCexCache && UseConcretizingSolver)
-    solver = createCexCachingSolver(std::move(solver));
+    addLayer(createCexCachingSolver(std::move(solver)), "outer-cex-cache");
 
   if (UseBranchCache && UseConcretizingSolver)
-    solver = createCachingSolver(std::move(solver));
+    addLayer(createCachingSolver(std::move(solver)), "outer-branch-cache");
 
   if (UseIndependentSolver && UseConcretizingSolver)
-    solver = createIndependentSolver(std::move(solver));
+    addLayer(createIndependentSolver(std::move(solver)), "outer-independent");
+
+  if (UseRangeSolver)
+    addLayer(createRangeSolver(std::move(solver)), "range");
 
   if (DebugValidateSolver)
     solver = createValidatingSolver(std::move(solver), rawCoreSolver, false);
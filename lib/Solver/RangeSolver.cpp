@@ -0,0 +1,68 @@
+//===-- RangeSolver.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver/Solver.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/RangeIndex.h"
+#include "klee/Solver/IncompleteSolver.h"
+
+#include <memory>
+#include <utility>
+
+using namespace klee;
+
+/// Answers queries from the intervals and known bits that the constraints of
+/// the query imply. The constraint set keeps them between queries, so a query
+/// only costs an evaluation of its expression. Like the rest of the solver
+/// chain, it assumes that the constraints are satisfiable.
+class RangeSolver : public IncompleteSolver {
+public:
+  PartialValidity computeValidity(const Query &);
+  PartialValidity computeTruth(const Query &);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool
+  computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                       std::vector<SparseStorageImpl<unsigned char>> &values,
+                       bool &hasSolution);
+};
+
+PartialValidity RangeSolver::computeValidity(const Query &query) {
+  auto value = query.constraints.ranges().evaluate(query.expr);
+  if (!value)
+    return PValidity::None;
+  return *value ? PValidity::MustBeTrue : PValidity::MustBeFalse;
+}
+
+PartialValidity RangeSolver::computeTruth(const Query &query) {
+  auto value = query.constraints.ranges().evaluate(query.expr);
+  if (!value)
+    return PValidity::None;
+  return *value ? PValidity::MustBeTrue : PValidity::MayBeFalse;
+}
+
+bool RangeSolver::computeValue(const Query &query, ref<Expr> &result) {
+  auto range = query.constraints.ranges().getRange(query.expr);
+  if (!range || range->min != range->max)
+    return false;
+  result = ConstantExpr::create(range->min, query.expr->getWidth());
+  return true;
+}
+
+bool RangeSolver::computeInitialValues(
+    const Query &, const std::vector<const Array *> &,
+    std::vector<SparseStorageImpl<unsigned char>> &, bool &) {
+  return false;
+}
+
+std::unique_ptr<Solver> klee::createRangeSolver(std::unique_ptr<Solver> s) {
+  return std::make_unique<Solver>(std::make_unique<StagedSolverImpl>(
+      std::make_unique<RangeSolver>(), std::move(s)));
+}
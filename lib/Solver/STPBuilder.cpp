@@ -14,6 +14,7 @@
 #include "klee/Expr/Expr.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/TimerStatIncrementer.h"
 
 #include "ConstantDivision.h"
 
@@ -496,22 +497,27 @@ ExprHandle STPBuilder::getInitialRead(const Array *root, unsigned index) {
 
 /** if *width_out!=1 then result is a bitvector,
     otherwise it is a bool */
+ExprHandle STPBuilder::construct(ref<Expr> e) {
+  TimerStatIncrementer timer(stats::translationTime);
+  return construct(e, 0);
+}
+
 ExprHandle STPBuilder::construct(ref<Expr> e, int *width_out) {
   if (!UseConstructHash || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<ExprHandle, unsigned>>::iterator it =
-        constructed.find(e);
-    if (it != constructed.end()) {
+    if (auto entry = constructed.lookup(e)) {
+      ++stats::translationCacheHits;
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = entry->second;
+      return entry->first;
     } else {
+      ++stats::translationCacheMisses;
       int width;
       if (!width_out)
         width_out = &width;
       ExprHandle res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      constructed.insert(e, std::make_pair(res, *width_out));
       return res;
     }
   }
@@ -10,6 +10,7 @@
 #ifndef KLEE_STPBUILDER_H
 #define KLEE_STPBUILDER_H
 
+#include "TranslationCache.h"
 #include "klee/Config/config.h"
 #include "klee/Expr/ArrayExprHash.h"
 #include "klee/Expr/ExprHashMap.h"
@@ -69,7 +70,7 @@ public:
 
 class STPBuilder {
   ::VC vc;
-  ExprHashMap<std::pair<ExprHandle, unsigned>> constructed;
+  TranslationCache<std::pair<ExprHandle, unsigned>> constructed;
 
   /// optimizeDivides - Rewrite division and reminders by constants
   /// into multiplies and shifts. STP should probably handle this for
@@ -127,11 +128,10 @@ public:
   ExprHandle getFalse();
   ExprHandle getInitialRead(const Array *os, unsigned index);
 
-  ExprHandle construct(ref<Expr> e) {
-    ExprHandle res = construct(e, 0);
-    constructed.clear();
-    return res;
-  }
+  ExprHandle construct(ref<Expr> e);
+  /// Called by the solver after each query. Constructed expressions are
+  /// kept for later queries as long as they fit into the cache.
+  void finishQuery() { constructed.finishQuery(); }
 };
 
 } // namespace klee
@@ -213,6 +213,7 @@ std::string STPSolverImpl::getConstraintLog(const Query &query) {
   unsigned long length;
   vc_printQueryStateToBuffer(vc, builder->getFalse(), &buffer, &length, false);
   vc_pop(vc);
+  builder->finishQuery();
 
   std::string result(buffer);
   std::free(buffer);
@@ -468,6 +469,7 @@ bool STPSolverImpl::computeInitialValues(
   }
 
   vc_pop(vc);
+  builder->finishQuery();
 
   return success;
 }
@@ -43,6 +43,12 @@ cl::opt<bool> UseFastCexSolver(
     cl::desc("Enable an experimental range-based solver (default=false)"),
     cl::cat(SolvingCat));
 
+cl::opt<bool> UseRangeSolver(
+    "use-range-solver", cl::init(true),
+    cl::desc("Answer queries decided by the intervals and known bits implied "
+             "by the constraints without the other solvers (default=true)"),
+    cl::cat(SolvingCat));
+
 cl::opt<bool>
     UseCexCache("use-cex-cache", cl::init(true),
                 cl::desc("Use the counterexample cache (default=true)"),
@@ -102,6 +108,13 @@ cl::opt<bool> CoreSolverOptimizeDivides(
              "passing them to the core SMT solver (default=false)"),
     cl::init(false), cl::cat(SolvingCat));
 
+cl::opt<unsigned> SolverTranslationCacheSize(
+    "solver-translation-cache-size",
+    cl::desc("Number of expression translations the core SMT solver builder "
+             "keeps across queries, 0 keeps them for a single query only "
+             "(default=65536)"),
+    cl::init(65536), cl::cat(SolvingCat));
+
 cl::bits<QueryLoggingSolverType> QueryLoggingOptions(
     "use-query-log",
     cl::desc("Log queries to a file. Multiple options can be specified "
@@ -12,6 +12,9 @@
 using namespace klee;
 
 Statistic stats::cexCacheTime("CexCacheTime", "CCtime");
+Statistic stats::cexCacheLookupTime("CexCacheLookupTime", "CClookup");
+Statistic stats::cexCacheProbes("CexCacheProbes", "CCprobes");
+Statistic stats::cexCacheEvictions("CexCacheEvictions", "CCevict");
 Statistic stats::solverQueries("SolverQueries", "SQ");
 Statistic stats::queries("Queries", "Q");
 Statistic stats::queriesInvalid("QueriesInvalid", "Qiv");
@@ -26,6 +29,9 @@ Statistic stats::validQueriesSize("ValidQueriesSize", "VQsize");
 Statistic stats::validityCoresSize("ValidityCoresSize", "VCsize");
 Statistic stats::queryValidityCores("QueryValidityCores", "QVcores");
 Statistic stats::queryTime("QueryTime", "Qtime");
+Statistic stats::translationCacheHits("TranslationCacheHits", "TChits");
+Statistic stats::translationCacheMisses("TranslationCacheMisses", "TCmisses");
+Statistic stats::translationTime("TranslationTime", "Ttime");
 
 #ifdef KLEE_ARRAY_DEBUG
 Statistic stats::arrayHashTime("ArrayHashTime", "AHtime");
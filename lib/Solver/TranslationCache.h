@@ -0,0 +1,49 @@
+//===-- TranslationCache.h --------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_TRANSLATIONCACHE_H
+#define KLEE_TRANSLATIONCACHE_H
+
+#include "klee/ADT/GenerationalCache.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/SolverCmdLine.h"
+
+#include <utility>
+
+namespace klee {
+
+/// Cache of solver terms built for expressions by a solver builder. Since
+/// expressions are hash-consed, an entry stays valid across queries. Each
+/// generation holds at most --solver-translation-cache-size entries, and
+/// dropping a generation releases the solver handles only it still refers
+/// to. With a size of 0 the cache only lives for a single query.
+template <typename Entry> class TranslationCache {
+  GenerationalCache<ref<Expr>, Entry, ExprHashMap<Entry>> cache{
+      SolverTranslationCacheSize};
+
+public:
+  /// Return the entry for \p e, or nullptr if there is none.
+  Entry *lookup(const ref<Expr> &e) { return cache.lookup(e); }
+
+  Entry &insert(const ref<Expr> &e, Entry entry) {
+    return cache.insert(e, std::move(entry));
+  }
+
+  /// Mark the end of a query.
+  void finishQuery() {
+    if (!SolverTranslationCacheSize)
+      clear();
+  }
+
+  void clear() { cache.clear(); }
+};
+
+} // namespace klee
+
+#endif /* KLEE_TRANSLATIONCACHE_H */
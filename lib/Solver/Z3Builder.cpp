@@ -16,6 +16,7 @@
 #include "klee/Module/KModule.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Support/ErrorHandling.h"
 
 #include "llvm/ADT/StringExtras.h"
@@ -360,24 +361,40 @@ Z3ASTHandle Z3Builder::getArrayForUpdate(const Array *root,
   return un_expr;
 }
 
+Z3ASTHandle Z3Builder::construct(ref<Expr> e) {
+  TimerStatIncrementer timer(stats::translationTime);
+  Z3ASTHandle res = construct(std::move(e), nullptr);
+  if (autoClearConstructCache)
+    clearConstructCache();
+  return res;
+}
+
 Z3ASTHandle Z3Builder::construct(ref<Expr> e, int *width_out) {
   // TODO: We could potentially use Z3_simplify() here
   // to store simpler expressions.
   if (!Z3HashConfig::UseConstructHashZ3 || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<Z3ASTHandle, unsigned>>::iterator it =
-        constructed.find(e);
-    if (it != constructed.end()) {
+    if (ConstructedExpr *entry = constructed.lookup(e)) {
+      ++stats::translationCacheHits;
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = entry->width;
+      sideConstraints.insert(sideConstraints.end(),
+                             entry->sideConstraints.begin(),
+                             entry->sideConstraints.end());
+      return entry->handle;
     } else {
+      ++stats::translationCacheMisses;
       int width;
       if (!width_out)
         width_out = &width;
+      size_t numSideConstraints = sideConstraints.size();
       Z3ASTHandle res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      constructed.insert(
+          e, {res, static_cast<unsigned>(*width_out),
+              std::vector<Z3ASTHandle>(sideConstraints.begin() +
+                                           numSideConstraints,
+                                       sideConstraints.end())});
       return res;
     }
   }
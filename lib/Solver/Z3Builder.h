@@ -10,12 +10,14 @@
 #ifndef KLEE_Z3BUILDER_H
 #define KLEE_Z3BUILDER_H
 
+#include "TranslationCache.h"
 #include "Z3HashConfig.h"
 #include "klee/Config/config.h"
 #include "klee/Expr/ArrayExprHash.h"
 #include "klee/Expr/ExprHashMap.h"
 
 #include <unordered_map>
+#include <vector>
 #include <z3.h>
 
 namespace klee {
@@ -197,7 +199,15 @@ protected:
   Z3SortHandle getBvSort(unsigned width);
   Z3SortHandle getArraySort(Z3SortHandle domainSort, Z3SortHandle rangeSort);
 
-  ExprHashMap<std::pair<Z3ASTHandle, unsigned>> constructed;
+  struct ConstructedExpr {
+    Z3ASTHandle handle;
+    unsigned width;
+    /// Side constraints needed by the expression, which have to be
+    /// asserted again whenever it is reused.
+    std::vector<Z3ASTHandle> sideConstraints;
+  };
+
+  TranslationCache<ConstructedExpr> constructed;
   Z3ArrayExprHash _arr_hash;
   bool autoClearConstructCache;
   std::string z3LogInteractionFile;
@@ -219,13 +229,11 @@ public:
   Z3ASTHandle buildFreshBoolConst();
   Z3ASTHandle getInitialRead(const Array *os, unsigned index);
 
-  Z3ASTHandle construct(ref<Expr> e) {
-    Z3ASTHandle res = construct(std::move(e), nullptr);
-    if (autoClearConstructCache)
-      clearConstructCache();
-    return res;
-  }
+  Z3ASTHandle construct(ref<Expr> e);
   void clearConstructCache() { constructed.clear(); }
+  /// Called by the solver after each query. Constructed expressions are
+  /// kept for later queries as long as they fit into the cache.
+  void finishQuery() { constructed.finishQuery(); }
   void clearSideConstraints() { sideConstraints.clear(); }
 };
 } // namespace klee
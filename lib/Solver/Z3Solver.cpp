@@ -642,12 +642,11 @@ bool Z3SolverImpl::internalRunSolver(
 
   deinitNativeZ3(theSolver);
 
-  // Clear the builder's cache to prevent memory usage exploding.
-  // By using ``autoClearConstructCache=false`` and clearning now
-  // we allow Z3_ast expressions to be shared from an entire
-  // ``Query`` rather than only sharing within a single call to
-  // ``builder->construct()``.
-  builder->clearConstructCache();
+  // Let the builder trim its cache to prevent memory usage exploding.
+  // By using ``autoClearConstructCache=false`` and finishing the query
+  // only now we allow Z3_ast expressions to be shared across queries
+  // rather than only within a single call to ``builder->construct()``.
+  builder->finishQuery();
   builder->clearSideConstraints();
   if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE ||
       runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
@@ -0,0 +1,251 @@
+//===-- CoverageFile.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Support/CoverageFile.h"
+
+#include "klee/Config/Version.h"
+
+#include "llvm/Support/MathExtras.h"
+
+#include <cstring>
+
+using namespace klee;
+
+constexpr char CoverageFileHeader::Magic[8];
+
+namespace {
+enum Section { Bitmaps, Counts, Functions, Lines, Strings, End };
+
+// Sizes come from untrusted headers: with \p overflowed given, any overflow
+// is reported there instead of wrapping around.
+std::uint64_t sectionSize(const CoverageFileHeader &header, unsigned section,
+                          bool *overflowed = nullptr) {
+  std::uint64_t numWords = (header.numIndices + 63) / 64;
+  switch (section) {
+  case Bitmaps:
+    return llvm::SaturatingMultiply<std::uint64_t>(
+        NumCoverageBitmaps * sizeof(std::uint64_t), numWords, overflowed);
+  case Counts:
+    return llvm::SaturatingMultiply<std::uint64_t>(
+        sizeof(std::uint64_t), header.numIndices, overflowed);
+  case Functions:
+    return std::uint64_t(header.numFunctions) * sizeof(CoverageFunction);
+  case Lines:
+    return llvm::SaturatingMultiply<std::uint64_t>(
+        sizeof(CoverageLine), header.numIndices, overflowed);
+  case Strings:
+    return header.stringTableSize;
+  default:
+    return 0;
+  }
+}
+
+std::uint64_t sectionOffset(const CoverageFileHeader &header, unsigned section,
+                            bool *overflowed = nullptr) {
+  std::uint64_t offset = sizeof(CoverageFileHeader);
+  for (unsigned i = 0; i < section; ++i) {
+    bool sizeOverflowed = false, sumOverflowed = false;
+    offset = llvm::SaturatingAdd(offset, sectionSize(header, i, &sizeOverflowed),
+                                 &sumOverflowed);
+    if (overflowed)
+      *overflowed |= sizeOverflowed || sumOverflowed;
+  }
+  return offset;
+}
+} // namespace
+
+CoverageFileView::CoverageFileView(std::unique_ptr<llvm::MemoryBuffer> _buffer)
+    : buffer(std::move(_buffer)),
+      header(reinterpret_cast<const CoverageFileHeader *>(
+          buffer->getBufferStart())) {}
+
+std::unique_ptr<CoverageFileView>
+CoverageFileView::open(const std::string &path, std::string &error) {
+  // Large files are mapped rather than read, so only the pages touched by a
+  // merge are ever brought in.
+#if LLVM_VERSION_CODE >= LLVM_VERSION(13, 0)
+  auto bufferOrErr = llvm::MemoryBuffer::getFile(
+      path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+#else
+  auto bufferOrErr = llvm::MemoryBuffer::getFile(
+      path, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+#endif
+  if (!bufferOrErr) {
+    error = bufferOrErr.getError().message();
+    return nullptr;
+  }
+
+  auto &buffer = bufferOrErr.get();
+  if (buffer->getBufferSize() < sizeof(CoverageFileHeader)) {
+    error = "file too small";
+    return nullptr;
+  }
+  CoverageFileHeader header;
+  std::memcpy(&header, buffer->getBufferStart(), sizeof(header));
+  if (std::memcmp(header.magic, CoverageFileHeader::Magic,
+                  sizeof(header.magic)) != 0) {
+    error = "not a KLEE coverage file";
+    return nullptr;
+  }
+  if (header.version != CoverageFileHeader::Version) {
+    error = "unsupported coverage file version " +
+            std::to_string(header.version);
+    return nullptr;
+  }
+  bool overflowed = false;
+  std::uint64_t size = sectionOffset(header, End, &overflowed);
+  if (overflowed || buffer->getBufferSize() < size) {
+    error = "truncated coverage file";
+    return nullptr;
+  }
+
+  std::unique_ptr<CoverageFileView> view(
+      new CoverageFileView(std::move(buffer)));
+  if (!view->validate(error))
+    return nullptr;
+  return view;
+}
+
+bool CoverageFileView::validate(std::string &error) const {
+  // Consumers index the line table and string table with the values checked
+  // here, so every reference has to stay within the file.
+  const std::uint64_t stringTableSize = header->stringTableSize;
+  if (stringTableSize == 0 ||
+      sectionStart(Strings)[stringTableSize - 1] != '\0') {
+    error = "string table is not 0-terminated";
+    return false;
+  }
+
+  const CoverageFunction *fns = getFunctions();
+  for (std::uint32_t i = 0; i < getNumFunctions(); ++i) {
+    if (fns[i].name >= stringTableSize || fns[i].file >= stringTableSize) {
+      error = "invalid string offset in function " + std::to_string(i);
+      return false;
+    }
+    if (std::uint64_t(fns[i].firstIndex) + fns[i].numIndices >
+        getNumIndices()) {
+      error = "invalid index range in function " + std::to_string(i);
+      return false;
+    }
+  }
+
+  const CoverageLine *lines = getLines();
+  for (std::uint64_t i = 0; i < getNumIndices(); ++i) {
+    if (lines[i].file >= stringTableSize) {
+      error = "invalid string offset in line " + std::to_string(i);
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *CoverageFileView::sectionStart(unsigned section) const {
+  return buffer->getBufferStart() + sectionOffset(*header, section);
+}
+
+const std::uint64_t *CoverageFileView::getBitmap(CoverageBitmap kind) const {
+  return reinterpret_cast<const std::uint64_t *>(sectionStart(Bitmaps)) +
+         static_cast<unsigned>(kind) * getNumWords();
+}
+
+const std::uint64_t *CoverageFileView::getCounts() const {
+  return reinterpret_cast<const std::uint64_t *>(sectionStart(Counts));
+}
+
+const CoverageFunction *CoverageFileView::getFunctions() const {
+  return reinterpret_cast<const CoverageFunction *>(sectionStart(Functions));
+}
+
+const CoverageLine *CoverageFileView::getLines() const {
+  return reinterpret_cast<const CoverageLine *>(sectionStart(Lines));
+}
+
+const char *CoverageFileView::getString(std::uint32_t offset) const {
+  return sectionStart(Strings) + offset;
+}
+
+///
+
+CoverageData::CoverageData(std::uint64_t _moduleHash, std::uint64_t _numIndices)
+    : moduleHash(_moduleHash), numIndices(_numIndices),
+      counts(_numIndices, 0), lines(_numIndices, CoverageLine{0, 0}) {
+  for (auto &bitmap : bitmaps)
+    bitmap.assign(getNumWords(), 0);
+  // offset 0 is the empty string
+  addString("");
+}
+
+CoverageData::CoverageData(const CoverageFileView &view)
+    : CoverageData(view.getModuleHash(), view.getNumIndices()) {
+  const CoverageFunction *fns = view.getFunctions();
+  for (std::uint32_t i = 0; i < view.getNumFunctions(); ++i)
+    functions.push_back({addString(view.getString(fns[i].name)),
+                         addString(view.getString(fns[i].file)),
+                         fns[i].firstIndex, fns[i].numIndices});
+  const CoverageLine *viewLines = view.getLines();
+  for (std::uint64_t i = 0; i < numIndices; ++i)
+    lines[i] = {addString(view.getString(viewLines[i].file)),
+                viewLines[i].line};
+}
+
+std::uint32_t CoverageData::addString(const std::string &s) {
+  auto it = stringOffsets.find(s);
+  if (it != stringOffsets.end())
+    return it->second;
+  std::uint32_t offset = strings.size();
+  strings.insert(strings.end(), s.begin(), s.end());
+  strings.push_back('\0');
+  stringOffsets.emplace(s, offset);
+  return offset;
+}
+
+bool CoverageData::merge(const CoverageFileView &view) {
+  if (view.getModuleHash() != moduleHash || view.getNumIndices() != numIndices)
+    return false;
+
+  // Plain word loops over restrict-qualified pointers, which the compiler
+  // turns into vector code.
+  const std::uint64_t numWords = getNumWords();
+  for (unsigned kind = 0; kind < NumCoverageBitmaps; ++kind) {
+    std::uint64_t *__restrict dst = bitmaps[kind].data();
+    const std::uint64_t *__restrict src =
+        view.getBitmap(static_cast<CoverageBitmap>(kind));
+    for (std::uint64_t i = 0; i < numWords; ++i)
+      dst[i] |= src[i];
+  }
+
+  std::uint64_t *__restrict dst = counts.data();
+  const std::uint64_t *__restrict src = view.getCounts();
+  for (std::uint64_t i = 0; i < numIndices; ++i)
+    dst[i] += src[i];
+
+  return true;
+}
+
+void CoverageData::write(llvm::raw_ostream &os) const {
+  CoverageFileHeader header;
+  std::memcpy(header.magic, CoverageFileHeader::Magic, sizeof(header.magic));
+  header.version = CoverageFileHeader::Version;
+  header.numFunctions = functions.size();
+  header.moduleHash = moduleHash;
+  header.numIndices = numIndices;
+  header.stringTableSize = strings.size();
+
+  os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (auto &bitmap : bitmaps)
+    os.write(reinterpret_cast<const char *>(bitmap.data()),
+             bitmap.size() * sizeof(std::uint64_t));
+  os.write(reinterpret_cast<const char *>(counts.data()),
+           counts.size() * sizeof(std::uint64_t));
+  os.write(reinterpret_cast<const char *>(functions.data()),
+           functions.size() * sizeof(CoverageFunction));
+  os.write(reinterpret_cast<const char *>(lines.data()),
+           lines.size() * sizeof(CoverageLine));
+  os.write(strings.data(), strings.size());
+}
@@ -10,6 +10,7 @@
 #define DEBUG_TYPE "TreeStreamWriter"
 #include "klee/ADT/TreeStream.h"
 
+#include "klee/Config/config.h"
 #include "klee/Support/Debug.h"
 #ifdef ENABLE_KLEE_DEBUG
 #include "llvm/Support/raw_ostream.h"
@@ -21,14 +22,51 @@
 
 #include <cstring>
 
+#ifdef HAVE_ZLIB_H
+#include "zlib.h"
+#endif
+
 using namespace klee;
 
+namespace {
+enum RecordKind : unsigned {
+  RawRecord = 0,
+  BranchRecord = 1, // '0'/'1' characters, packed into bits
+  ForkRecord = 2,   // the size field holds the id of the new stream
+};
+
+void appendVarint(std::vector<unsigned char> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(value);
+}
+
+uint64_t readVarint(const unsigned char *&pos) {
+  uint64_t value = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    unsigned char byte = *pos++;
+    value |= uint64_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+}
+
+bool isBranches(const std::vector<char> &data) {
+  for (char c : data)
+    if (c != '0' && c != '1')
+      return false;
+  return true;
+}
+} // namespace
+
 ///
 
 TreeStreamWriter::TreeStreamWriter(const std::string &_path)
-    : lastID(0), bufferCount(0), path(_path),
+    : lastID(0), blockLastID(0), path(_path),
       output(new std::ofstream(path.c_str(), std::ios::out | std::ios::binary)),
-      ids(1) {
+      ids(1), parents(1, 0) {
   if (!output->good()) {
     delete output;
     output = 0;
@@ -36,7 +74,8 @@ TreeStreamWriter::TreeStreamWriter(const std::string &_path)
 }
 
 TreeStreamWriter::~TreeStreamWriter() {
-  flush();
+  if (output)
+    flush();
   delete output;
 }
 
@@ -46,42 +85,79 @@ TreeOStream TreeStreamWriter::open() { return open(TreeOStream(*this, 0)); }
 
 TreeOStream TreeStreamWriter::open(const TreeOStream &os) {
   assert(output && os.writer == this);
-  flushBuffer();
+  encodePending();
   unsigned id = ids++;
-  output->write(reinterpret_cast<const char *>(&os.id), 4);
-  unsigned tag = id | (1 << 31);
-  output->write(reinterpret_cast<const char *>(&tag), 4);
+  parents.push_back(os.id);
+  encodeRecord(os.id, (uint64_t(id) << 2) | ForkRecord);
   return TreeOStream(*this, id);
 }
 
 void TreeStreamWriter::write(TreeOStream &os, const char *s, unsigned size) {
-  if (bufferCount && (os.id != lastID || size + bufferCount > bufferSize))
-    flushBuffer();
-  if (bufferCount) { // (os.id==lastID && size+bufferCount<=bufferSize)
-    memcpy(&buffer[bufferCount], s, size);
-    bufferCount += size;
-  } else if (size < bufferSize) {
-    lastID = os.id;
-    memcpy(buffer, s, size);
-    bufferCount = size;
+  if (os.id != lastID)
+    encodePending();
+  lastID = os.id;
+  pending.insert(pending.end(), s, s + size);
+  if (pending.size() >= blockSize)
+    encodePending();
+}
+
+void TreeStreamWriter::encodePending() {
+  if (pending.empty())
+    return;
+
+  if (isBranches(pending)) {
+    encodeRecord(lastID, (uint64_t(pending.size()) << 2) | BranchRecord);
+    size_t start = block.size();
+    block.resize(start + (pending.size() + 7) / 8, 0);
+    for (size_t i = 0; i < pending.size(); ++i)
+      if (pending[i] == '1')
+        block[start + i / 8] |= 1 << (i % 8);
   } else {
-    output->write(reinterpret_cast<const char *>(&os.id), 4);
-    output->write(reinterpret_cast<const char *>(&size), 4);
-    output->write(s, size);
+    encodeRecord(lastID, (uint64_t(pending.size()) << 2) | RawRecord);
+    block.insert(block.end(), pending.begin(), pending.end());
   }
+  pending.clear();
+
+  if (block.size() >= blockSize)
+    flushBlock();
+}
+
+void TreeStreamWriter::encodeRecord(TreeStreamID id, uint64_t header) {
+  // zigzag encoded, consecutive records mostly belong to nearby streams
+  int64_t delta = int64_t(id) - int64_t(blockLastID);
+  appendVarint(block, (uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+  appendVarint(block, header);
+  blockLastID = id;
 }
 
-void TreeStreamWriter::flushBuffer() {
-  if (bufferCount) {
-    output->write(reinterpret_cast<const char *>(&lastID), 4);
-    output->write(reinterpret_cast<const char *>(&bufferCount), 4);
-    output->write(buffer, bufferCount);
-    bufferCount = 0;
+void TreeStreamWriter::flushBlock() {
+  if (block.empty())
+    return;
+
+  uint32_t size = block.size();
+  const unsigned char *data = block.data();
+  uint32_t storedSize = size;
+#ifdef HAVE_ZLIB_H
+  std::vector<unsigned char> compressed(compressBound(size));
+  uLongf compressedSize = compressed.size();
+  if (compress2(compressed.data(), &compressedSize, data, size,
+                Z_BEST_SPEED) == Z_OK &&
+      compressedSize < size) {
+    data = compressed.data();
+    storedSize = compressedSize;
   }
+#endif
+  output->write(reinterpret_cast<const char *>(&size), 4);
+  output->write(reinterpret_cast<const char *>(&storedSize), 4);
+  output->write(reinterpret_cast<const char *>(data), storedSize);
+
+  block.clear();
+  blockLastID = 0;
 }
 
 void TreeStreamWriter::flush() {
-  flushBuffer();
+  encodePending();
+  flushBlock();
   output->flush();
 }
 
@@ -94,35 +170,9 @@ void TreeStreamWriter::readStream(TreeStreamID streamID,
   assert(is.good());
   KLEE_DEBUG(llvm::errs() << "finding chain for: " << streamID << "\n");
 
-  std::map<unsigned, unsigned> parents;
   std::vector<unsigned> roots;
-  for (;;) {
-    assert(is.good());
-    unsigned id;
-    unsigned tag;
-    is.read(reinterpret_cast<char *>(&id), 4);
-    is.read(reinterpret_cast<char *>(&tag), 4);
-    if (tag & (1 << 31)) { // fork
-      unsigned child = tag ^ (1 << 31);
-
-      if (child == streamID) {
-        roots.push_back(child);
-        while (id) {
-          roots.push_back(id);
-          std::map<unsigned, unsigned>::iterator it = parents.find(id);
-          assert(it != parents.end());
-          id = it->second;
-        }
-        break;
-      } else {
-        parents.insert(std::make_pair(child, id));
-      }
-    } else {
-      unsigned size = tag;
-      while (size--)
-        is.get();
-    }
-  }
+  for (unsigned id = streamID; id; id = parents[id])
+    roots.push_back(id);
   KLEE_DEBUG({
     llvm::errs() << "roots: ";
     for (size_t i = 0, e = roots.size(); i < e; ++i) {
@@ -130,27 +180,54 @@ void TreeStreamWriter::readStream(TreeStreamID streamID,
     }
     llvm::errs() << "\n";
   });
-  is.seekg(0, std::ios::beg);
+
+  std::vector<unsigned char> stored, data;
   for (;;) {
-    unsigned id;
-    unsigned tag;
-    is.read(reinterpret_cast<char *>(&id), 4);
-    is.read(reinterpret_cast<char *>(&tag), 4);
+    uint32_t size, storedSize;
+    is.read(reinterpret_cast<char *>(&size), 4);
+    is.read(reinterpret_cast<char *>(&storedSize), 4);
     if (!is.good())
       break;
-    if (tag & (1 << 31)) { // fork
-      unsigned child = tag ^ (1 << 31);
-      if (id == roots.back() && roots.size() > 1 &&
-          child == roots[roots.size() - 2])
-        roots.pop_back();
+    stored.resize(storedSize);
+    is.read(reinterpret_cast<char *>(stored.data()), storedSize);
+    if (storedSize == size) {
+      data.swap(stored);
     } else {
-      unsigned size = tag;
-      if (id == roots.back()) {
-        while (size--)
-          out.push_back(is.get());
-      } else {
-        while (size--)
-          is.get();
+#ifdef HAVE_ZLIB_H
+      data.resize(size);
+      uLongf dataSize = size;
+      int res = uncompress(data.data(), &dataSize, stored.data(), storedSize);
+      assert(res == Z_OK && dataSize == size && "corrupt tree stream block");
+      (void)res;
+#else
+      assert(0 && "compressed tree stream block without zlib");
+#endif
+    }
+
+    unsigned id = 0;
+    for (const unsigned char *pos = data.data(), *end = pos + size;
+         pos != end;) {
+      uint64_t delta = readVarint(pos);
+      id += unsigned((delta >> 1) ^ -(delta & 1));
+      uint64_t header = readVarint(pos);
+      uint64_t length = header >> 2;
+      switch (header & 3) {
+      case ForkRecord:
+        if (id == roots.back() && roots.size() > 1 &&
+            length == roots[roots.size() - 2])
+          roots.pop_back();
+        break;
+      case BranchRecord:
+        if (id == roots.back())
+          for (uint64_t i = 0; i < length; ++i)
+            out.push_back(pos[i / 8] & (1 << (i % 8)) ? '1' : '0');
+        pos += (length + 7) / 8;
+        break;
+      default:
+        if (id == roots.back())
+          out.insert(out.end(), pos, pos + length);
+        pos += length;
+        break;
       }
     }
   }
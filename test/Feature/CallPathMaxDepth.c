@@ -0,0 +1,29 @@
+// Check that calls below the call path depth limit are still reported.
+//
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --call-path-max-depth=2 --exit-on-error %t1.bc
+// RUN: FileCheck < %t.klee-out/run.istats %s
+
+int f3(int a) { return a + 3; }
+
+int f2(int a) {
+  // CHECK: fn=f2
+  // CHECK: cfn=f3
+  // CHECK-NEXT: calls=1 {{[1-9][0-9]*}}
+  return f3(a) + 2;
+}
+
+int f1(int a) {
+  // CHECK: fn=f1
+  // CHECK: cfn=f2
+  // CHECK-NEXT: calls=1 {{[1-9][0-9]*}}
+  return f2(a) + 1;
+}
+
+int main() {
+  // CHECK: fn=main
+  // CHECK: cfn=f1
+  // CHECK-NEXT: calls=1 {{[1-9][0-9]*}}
+  return f1(0) != 6;
+}
@@ -0,0 +1,34 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out-1 %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-1 --output-coverage-bitmap --search=dfs --max-tests=1 %t.bc
+// RUN: %klee --output-dir=%t.klee-out-2 --output-coverage-bitmap %t.bc
+// RUN: test -f %t.klee-out-1/run.cov
+// RUN: %klee-cov-merge %t.klee-out-1 %t.klee-out-2/run.cov -o %t.merged.cov --istats %t.istats --sarif %t.sarif
+// RUN: FileCheck -check-prefix=CHECK-ISTATS -input-file=%t.istats %s
+// RUN: FileCheck -check-prefix=CHECK-SARIF -input-file=%t.sarif %s
+// RUN: %klee-cov-merge %t.merged.cov %t.klee-out-1
+// RUN: head -c 100 %t.merged.cov > %t.truncated.cov
+// RUN: not %klee-cov-merge %t.truncated.cov 2>&1 | FileCheck -check-prefix=CHECK-TRUNCATED %s
+// RUN: cp %t.merged.cov %t.unterminated.cov
+// RUN: printf x | dd of=%t.unterminated.cov bs=1 seek=$(( $(wc -c < %t.merged.cov) - 1 )) conv=notrunc
+// RUN: not %klee-cov-merge %t.unterminated.cov 2>&1 | FileCheck -check-prefix=CHECK-UNTERMINATED %s
+
+// CHECK-ISTATS: events: Icov Iuncov I
+// CHECK-ISTATS: fn=main
+
+// CHECK-SARIF: "coverableInstructions":
+// CHECK-SARIF: "inputs": 2
+// CHECK-SARIF: "name": "klee-cov-merge"
+
+// CHECK-TRUNCATED: error: {{.*}}truncated.cov: truncated coverage file
+// CHECK-UNTERMINATED: error: {{.*}}unterminated.cov: string table is not 0-terminated
+
+#include "klee/klee.h"
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (x > 10)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,29 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.cache %t.klee-out-1 %t.klee-out-2 %t.klee-out-3 %t.klee-out-4 %t.klee-out-5
+// RUN: %klee --module-cache-dir=%t.cache --output-dir=%t.klee-out-1 %t.bc 2>&1 | FileCheck -check-prefix=CHECK-MISS %s
+// RUN: %klee --module-cache-dir=%t.cache --output-dir=%t.klee-out-2 --search=dfs %t.bc 2>&1 | FileCheck -check-prefix=CHECK-HIT %s
+// RUN: diff %t.klee-out-1/assembly.ll %t.klee-out-2/assembly.ll
+// RUN: %klee --module-cache-dir=%t.cache --output-dir=%t.klee-out-3 --check-div-zero=false %t.bc 2>&1 | FileCheck -check-prefix=CHECK-MISS %s
+// RUN: for f in %t.cache/*.bc; do head -c 64 $f > $f.tmp && mv $f.tmp $f; done
+// RUN: %klee --module-cache-dir=%t.cache --output-dir=%t.klee-out-4 %t.bc 2>&1 | FileCheck -check-prefix=CHECK-CORRUPT %s
+// RUN: %klee --module-cache-dir=%t.cache --output-dir=%t.klee-out-5 %t.bc 2>&1 | FileCheck -check-prefix=CHECK-HIT %s
+
+// CHECK-MISS-NOT: from the module cache
+// CHECK-MISS: KLEE: done: generated tests = 2
+
+// CHECK-HIT: Using prepared module {{[0-9a-f]+}} from the module cache
+// CHECK-HIT: KLEE: done: generated tests = 2
+
+// CHECK-CORRUPT: Ignoring unreadable module cache entry
+// CHECK-CORRUPT-NOT: from the module cache
+// CHECK-CORRUPT: KLEE: done: generated tests = 2
+
+#include "klee/klee.h"
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (x > 10)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,21 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t1.klee-out %t2.klee-out
+// RUN: %klee --output-dir=%t1.klee-out --range-bounds-checks=false %t.bc
+// RUN: %klee --output-dir=%t2.klee-out %t.bc
+// RUN: %klee-stats --print-columns 'RangeBoundsChecks' --table-format=csv %t1.klee-out | FileCheck -check-prefix=CHECK-OFF %s
+// RUN: %klee-stats --print-columns 'RangeBoundsChecks' --table-format=csv %t2.klee-out | FileCheck -check-prefix=CHECK-ON %s
+#include "klee/klee.h"
+
+int main() {
+  char buf[16] = {0};
+  unsigned i;
+  klee_make_symbolic(&i, sizeof(i), "i");
+  klee_assume(i < 10);
+
+  buf[i] = 1;
+  return buf[i + 4];
+}
+// CHECK-OFF: RangeBoundsChecks
+// CHECK-OFF-NEXT: 0
+// CHECK-ON: RangeBoundsChecks
+// CHECK-ON-NEXT: {{[1-9][0-9]*}}
@@ -1,11 +1,25 @@
 // RUN: %clang %s -emit-llvm %O0opt -DCOND_EXIT -c -o %t1.bc
 // RUN: rm -rf %t.klee-out
-// RUN: %klee --output-dir=%t.klee-out --write-paths %t1.bc > %t3.good
+// RUN: %klee --output-dir=%t.klee-out --write-paths --write-binary-paths %t1.bc > %t3.good
 
 // RUN: %clang %s -emit-llvm %O0opt -c -o %t2.bc
 // RUN: rm -rf %t.klee-out-2
 // RUN: %klee --output-dir=%t.klee-out-2 --replay-path %t.klee-out/test000001.path %t2.bc > %t3.log
 // RUN: diff %t3.log %t3.good
+
+// RUN: rm -rf %t.klee-out-3
+// RUN: %klee --output-dir=%t.klee-out-3 --replay-path %t.klee-out/test000001.path.bin --replay-path-verify-interval=0 %t2.bc > %t4.log
+// RUN: diff %t4.log %t3.good
+
+// Branch 4 (the first "x & 2" check after the cond_exit ones) is recorded as
+// false although x & 2 must hold there: verified branches reject it
+// RUN: printf 'KLEEPATH\005\000\000\000\000\000\000\000\007' > %t.tampered.path.bin
+// RUN: rm -rf %t.klee-out-4
+// RUN: %klee --output-dir=%t.klee-out-4 --replay-path %t.tampered.path.bin --replay-path-verify-interval=3 %t2.bc 2>&1 | FileCheck -check-prefix=CHECK-TAMPERED %s
+// RUN: ls %t.klee-out-4 | FileCheck -check-prefix=CHECK-USER-ERR %s
+// CHECK-TAMPERED: hit invalid branch in replay path mode
+// CHECK-TAMPERED-NOT: res:
+// CHECK-USER-ERR: .user.err
 #include "klee/klee.h"
 #include <stdio.h>
 #include <unistd.h>
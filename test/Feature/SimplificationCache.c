@@ -0,0 +1,25 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t1.klee-out %t2.klee-out
+// RUN: %klee --output-dir=%t1.klee-out --simplification-cache-size=0 %t.bc
+// RUN: %klee --output-dir=%t2.klee-out %t.bc
+// RUN: %klee-stats --print-columns 'SCacheHits' --table-format=csv %t1.klee-out | FileCheck -check-prefix=CHECK-OFF %s
+// RUN: %klee-stats --print-columns 'SCacheHits' --table-format=csv %t2.klee-out | FileCheck -check-prefix=CHECK-ON %s
+#include "klee/klee.h"
+
+int main() {
+  char buf[4];
+  int count = 0;
+  klee_make_symbolic(buf, sizeof(buf), "buf");
+
+  for (int i = 0; i < 4; i++) {
+    if (buf[i] == buf[(i + 1) % 4] + 3)
+      count++;
+    else if (buf[i] > 100)
+      count += 2;
+  }
+  return count > 4;
+}
+// CHECK-OFF: SCacheHits
+// CHECK-OFF-NEXT: 0
+// CHECK-ON: SCacheHits
+// CHECK-ON-NEXT: {{[1-9][0-9]*}}
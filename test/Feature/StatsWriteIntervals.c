@@ -0,0 +1,44 @@
+// Check that statistics written in the background at short intervals end up
+// complete in run.istats and run.stats once KLEE exits.
+//
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --istats-write-interval=1ms --stats-write-interval=1ms %t.bc 2> %t.log
+// RUN: FileCheck -check-prefix=CHECK-LOG -input-file=%t.log %s
+// RUN: FileCheck -check-prefix=CHECK-ISTATS -input-file=%t.klee-out/run.istats %s
+// RUN: not test -e %t.klee-out/run.istats.tmp
+// RUN: %klee-stats --print-columns 'Path,Instrs,ICov(%)' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=CHECK-STATS -input-file=%t.stats %s
+
+#include "klee/klee.h"
+
+int count(unsigned char *buf, int n) {
+  int ones = 0;
+  for (int i = 0; i < n; ++i)
+    if (buf[i] == 1)
+      ++ones;
+  return ones;
+}
+
+int main() {
+  unsigned char buf[8];
+  klee_make_symbolic(buf, sizeof(buf), "buf");
+  return count(buf, sizeof(buf)) == 3;
+}
+
+// CHECK-LOG-NOT: Unable to write instruction level stats file
+// CHECK-LOG-NOT: Unable to replace run.istats
+// CHECK-LOG-NOT: Error writing stats data
+// CHECK-LOG: KLEE: done: completed paths = {{[1-9][0-9]*}}
+
+// CHECK-ISTATS: version: 1
+// CHECK-ISTATS: positions: instr line
+// CHECK-ISTATS: event: I : Instructions
+// CHECK-ISTATS: events:
+// CHECK-ISTATS: fn=count
+// CHECK-ISTATS: fn=main
+// CHECK-ISTATS: cfn=count
+// CHECK-ISTATS-NEXT: calls={{[1-9][0-9]*}} {{[0-9]+}} {{[0-9]+}}
+
+// CHECK-STATS: Path,Instrs,ICov(%)
+// CHECK-STATS: {{.*\.klee-out,[1-9][0-9]+,100\.00}}
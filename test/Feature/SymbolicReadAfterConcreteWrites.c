@@ -0,0 +1,45 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-guided-search=none --exit-on-error %t.bc 2>&1 | FileCheck %s
+
+/* Checks that concrete writes interleaved with symbolic reads and writes of
+   a large buffer are all visible to the symbolic reads. */
+#include "klee/klee.h"
+
+#include <assert.h>
+
+#define N 65536
+
+int main() {
+  static unsigned char a[N];
+  unsigned i, k;
+
+  for (i = 0; i < N; i += 2)
+    a[i] = 1;
+
+  klee_make_symbolic(&k, sizeof(k), "k");
+  klee_assume(k < N);
+
+  // Reads the concrete contents of the buffer
+  if (a[k] == 1)
+    assert(k % 2 == 0);
+  else
+    assert(k % 2 == 1);
+
+  // A few concrete writes on top of the flushed contents
+  a[1] = 7;
+  a[N - 1] = 7;
+  if (a[k] == 7)
+    assert(k == 1 || k == N - 1);
+
+  // A symbolic write drops the known concrete bytes
+  a[k] = 9;
+  a[0] = 5;
+  if (a[k] == 9)
+    assert(k != 0);
+  else
+    assert(k == 0);
+
+  // CHECK: KLEE: done: completed paths = 4
+  return 0;
+}
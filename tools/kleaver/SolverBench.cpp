@@ -0,0 +1,546 @@
+//===-- SolverBench.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverBench.h"
+
+#include "klee/ADT/SparseStorage.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Parser/Parser.h"
+#include "klee/Solver/Common.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/OptionCategories.h"
+#include "klee/Support/Timer.h"
+#include "klee/System/Time.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace klee;
+using namespace klee::expr;
+using json = nlohmann::json;
+
+namespace {
+llvm::cl::opt<unsigned> BenchJobs(
+    "bench-jobs",
+    llvm::cl::desc("Number of worker processes used by --bench, each with "
+                   "its own solver chain (default=1)"),
+    llvm::cl::init(1), llvm::cl::cat(klee::SolvingCat));
+
+llvm::cl::opt<std::string>
+    BenchOutput("bench-output",
+                llvm::cl::desc("Write the --bench report as JSON to <file>"),
+                llvm::cl::value_desc("file"), llvm::cl::cat(klee::SolvingCat));
+
+llvm::cl::opt<std::string> BenchBaseline(
+    "bench-baseline",
+    llvm::cl::desc("Compare the --bench results against a report written "
+                   "with --bench-output and fail on mismatches"),
+    llvm::cl::value_desc("file"), llvm::cl::cat(klee::SolvingCat));
+
+llvm::cl::opt<unsigned> BenchMaxSlowdown(
+    "bench-max-slowdown",
+    llvm::cl::desc("Also fail if the p95 latency of a query kind exceeds "
+                   "the baseline by more than this many percent "
+                   "(default=0 (off))"),
+    llvm::cl::init(0), llvm::cl::cat(klee::SolvingCat));
+
+enum class QueryKind { Truth, Value, InitialValues };
+constexpr unsigned NumQueryKinds = 3;
+
+const char *getQueryKindName(QueryKind kind) {
+  switch (kind) {
+  case QueryKind::Truth:
+    return "truth";
+  case QueryKind::Value:
+    return "value";
+  case QueryKind::InitialValues:
+    return "initial-values";
+  }
+  return "unknown";
+}
+
+QueryKind getQueryKind(const QueryCommand *QC) {
+  if (QC->Values.empty() && QC->Objects.empty())
+    return QueryKind::Truth;
+  if (!QC->Values.empty())
+    return QueryKind::Value;
+  return QueryKind::InitialValues;
+}
+
+struct LayerProfile {
+  std::string name;
+  std::uint64_t calls = 0;
+  time::Span time = {};
+};
+
+/// ProfilingSolver - Forwards every request to the underlying solver and
+/// accumulates the number of calls and the time spent below this point of
+/// the chain.
+class ProfilingSolver : public SolverImpl {
+  std::unique_ptr<Solver> solver;
+  LayerProfile &profile;
+
+  template <typename F> bool measure(F &&f) {
+    WallTimer timer;
+    bool success = f();
+    ++profile.calls;
+    profile.time += timer.delta();
+    return success;
+  }
+
+public:
+  ProfilingSolver(std::unique_ptr<Solver> solver, LayerProfile &profile)
+      : solver(std::move(solver)), profile(profile) {}
+
+  bool computeValidity(const Query &query, PartialValidity &result) override {
+    return measure(
+        [&] { return solver->impl->computeValidity(query, result); });
+  }
+  bool computeValidity(const Query &query, ref<SolverResponse> &queryResult,
+                       ref<SolverResponse> &negatedQueryResult) override {
+    return measure([&] {
+      return solver->impl->computeValidity(query, queryResult,
+                                           negatedQueryResult);
+    });
+  }
+  bool computeTruth(const Query &query, bool &isValid) override {
+    return measure([&] { return solver->impl->computeTruth(query, isValid); });
+  }
+  bool computeValue(const Query &query, ref<Expr> &result) override {
+    return measure([&] { return solver->impl->computeValue(query, result); });
+  }
+  bool
+  computeInitialValues(const Query &query,
+                       const std::vector<const Array *> &objects,
+                       std::vector<SparseStorageImpl<unsigned char>> &values,
+                       bool &hasSolution) override {
+    return measure([&] {
+      return solver->impl->computeInitialValues(query, objects, values,
+                                                hasSolution);
+    });
+  }
+  bool check(const Query &query, ref<SolverResponse> &result) override {
+    return measure([&] { return solver->impl->check(query, result); });
+  }
+  bool computeValidityCore(const Query &query, ValidityCore &validityCore,
+                           bool &isValid) override {
+    return measure([&] {
+      return solver->impl->computeValidityCore(query, validityCore, isValid);
+    });
+  }
+  bool computeMinimalUnsignedValue(const Query &query,
+                                   ref<ConstantExpr> &result) override {
+    return measure([&] {
+      return solver->impl->computeMinimalUnsignedValue(query, result);
+    });
+  }
+  SolverRunStatus getOperationStatusCode() override {
+    return solver->impl->getOperationStatusCode();
+  }
+  std::string getConstraintLog(const Query &query) override {
+    return solver->impl->getConstraintLog(query);
+  }
+  void setCoreSolverTimeout(time::Span timeout) override {
+    solver->impl->setCoreSolverTimeout(timeout);
+  }
+  void notifyStateTermination(std::uint32_t id) override {
+    solver->impl->notifyStateTermination(id);
+  }
+};
+
+/// Run a single query and return its outcome in the vocabulary of
+/// `kleaver -evaluate`. Only the satisfiability verdict is recorded, since
+/// models legitimately differ between solver configurations.
+std::string runQuery(Solver &S, const QueryCommand *QC, QueryKind kind) {
+  constraints_ty constraints(QC->Constraints.begin(), QC->Constraints.end());
+  switch (kind) {
+  case QueryKind::Truth: {
+    bool result;
+    if (!S.mustBeTrue(Query(constraints, QC->Query), result))
+      return "FAIL";
+    return result ? "VALID" : "INVALID";
+  }
+  case QueryKind::Value: {
+    for (const auto &value : QC->Values) {
+      ref<ConstantExpr> result;
+      if (!S.getValue(Query(constraints, value), result))
+        return "FAIL";
+    }
+    return "INVALID";
+  }
+  case QueryKind::InitialValues: {
+    std::vector<SparseStorageImpl<unsigned char>> result;
+    if (S.getInitialValues(Query(constraints, QC->Query), QC->Objects, result))
+      return "INVALID";
+    if (S.impl->getOperationStatusCode() ==
+        SolverImpl::SOLVER_RUN_STATUS_TIMEOUT)
+      return "FAIL";
+    return "VALID";
+  }
+  }
+  return "FAIL";
+}
+
+const Statistic *const benchStatistics[] = {
+    &stats::queries,              &stats::solverQueries,
+    &stats::queryCacheHits,       &stats::queryCacheMisses,
+    &stats::queryCexCacheHits,    &stats::queryCexCacheMisses,
+    &stats::translationCacheHits, &stats::translationCacheMisses,
+    &stats::queryTime,            &stats::translationTime,
+    &stats::cexCacheTime,         &stats::cexCacheLookupTime,
+    &stats::cexCacheProbes,       &stats::cexCacheEvictions};
+
+/// Replay every \p jobs-th query starting at \p worker through a fresh
+/// solver chain and return the raw measurements.
+json runWorker(const std::vector<QueryCommand *> &queries, unsigned worker,
+               unsigned jobs, const std::string &queryLogDir) {
+  std::unique_ptr<Solver> coreSolver = createCoreSolver(CoreSolverToUse);
+  if (CoreSolverToUse != DUMMY_SOLVER) {
+    const time::Span maxCoreSolverTime(MaxCoreSolverTime);
+    if (maxCoreSolverTime)
+      coreSolver->setCoreSolverTimeout(maxCoreSolverTime);
+  }
+
+  auto getLogPath = [&](const char *filename) {
+    std::string path = queryLogDir + "/";
+    if (jobs > 1)
+      path += "worker" + std::to_string(worker) + "-";
+    return path + filename;
+  };
+
+  // deque, since the profiling layers keep references to their entries
+  std::deque<LayerProfile> layers;
+  std::unique_ptr<Solver> S = constructSolverChain(
+      std::move(coreSolver), getLogPath(ALL_QUERIES_SMT2_FILE_NAME),
+      getLogPath(SOLVER_QUERIES_SMT2_FILE_NAME),
+      getLogPath(ALL_QUERIES_KQUERY_FILE_NAME),
+      getLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME),
+      [&layers](std::unique_ptr<Solver> layer, const char *name) {
+        layers.push_back({name});
+        return std::make_unique<Solver>(
+            std::make_unique<ProfilingSolver>(std::move(layer), layers.back()));
+      });
+
+  json indices = json::array(), results = json::array(),
+       latencies = json::array();
+  for (unsigned i = worker; i < queries.size(); i += jobs) {
+    const QueryCommand *QC = queries[i];
+    WallTimer timer;
+    std::string result = runQuery(*S, QC, getQueryKind(QC));
+    latencies.push_back(timer.delta().toMicroseconds());
+    indices.push_back(i);
+    results.push_back(result);
+  }
+
+  json layersJson = json::array();
+  for (auto &layer : layers)
+    layersJson.push_back({{"name", layer.name},
+                          {"calls", layer.calls},
+                          {"time_us", layer.time.toMicroseconds()}});
+
+  json statsJson = json::object();
+  for (auto *stat : benchStatistics)
+    statsJson[stat->getName()] = stat->getValue();
+
+  return {{"indices", indices},
+          {"results", results},
+          {"latencies_us", latencies},
+          {"layers", layersJson},
+          {"statistics", statsJson}};
+}
+
+/// Fork one process per worker and collect their measurements through
+/// pipes. Expressions are hash-consed in process-global tables, so the
+/// workers cannot share an address space.
+bool runWorkers(const std::vector<QueryCommand *> &queries, unsigned jobs,
+                const std::string &queryLogDir, std::vector<json> &reports) {
+  if (jobs == 1) {
+    reports.push_back(runWorker(queries, 0, 1, queryLogDir));
+    return true;
+  }
+
+  std::vector<std::pair<pid_t, int>> children;
+  for (unsigned worker = 0; worker < jobs; ++worker) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+      llvm::errs() << "kleaver: error: pipe failed\n";
+      return false;
+    }
+    llvm::outs().flush();
+    pid_t pid = fork();
+    if (pid == -1) {
+      llvm::errs() << "kleaver: error: fork failed\n";
+      return false;
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      std::string report = runWorker(queries, worker, jobs, queryLogDir).dump();
+      const char *data = report.data();
+      size_t remaining = report.size();
+      while (remaining) {
+        ssize_t written = write(fds[1], data, remaining);
+        if (written <= 0)
+          _exit(1);
+        data += written;
+        remaining -= written;
+      }
+      close(fds[1]);
+      _exit(0);
+    }
+    close(fds[1]);
+    children.emplace_back(pid, fds[0]);
+  }
+
+  bool success = true;
+  for (auto &child : children) {
+    std::string report;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(child.second, buffer, sizeof(buffer))) > 0)
+      report.append(buffer, n);
+    close(child.second);
+
+    int status;
+    if (waitpid(child.first, &status, 0) == -1 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      llvm::errs() << "kleaver: error: bench worker " << child.first
+                   << " failed\n";
+      success = false;
+      continue;
+    }
+    json parsed = json::parse(report, nullptr, false);
+    if (parsed.is_discarded()) {
+      llvm::errs() << "kleaver: error: malformed report from bench worker "
+                   << child.first << "\n";
+      success = false;
+      continue;
+    }
+    reports.push_back(std::move(parsed));
+  }
+  return success;
+}
+
+/// Nearest-rank percentile of the sorted \p values.
+std::uint64_t percentile(const std::vector<std::uint64_t> &values,
+                         unsigned p) {
+  if (values.empty())
+    return 0;
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+  return values[rank ? rank - 1 : 0];
+}
+
+double ratio(std::uint64_t hits, std::uint64_t misses) {
+  return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+}
+
+bool compareWithBaseline(const json &report, const json &baseline) {
+  bool success = true;
+
+  const json &results = report["results"];
+  if (!baseline.contains("results") || !baseline["results"].is_array() ||
+      baseline["results"].size() != results.size()) {
+    llvm::errs() << "kleaver: error: baseline " << BenchBaseline
+                 << " was recorded for a different query log\n";
+    return false;
+  }
+
+  unsigned mismatches = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (baseline["results"][i] == results[i])
+      continue;
+    if (++mismatches <= 10)
+      llvm::outs() << "Query " << i << ": "
+                   << baseline["results"][i].get<std::string>()
+                   << " in baseline, now " << results[i].get<std::string>()
+                   << "\n";
+  }
+  if (mismatches) {
+    llvm::outs() << "result mismatches = " << mismatches << "\n";
+    success = false;
+  }
+
+  if (BenchMaxSlowdown && baseline.contains("latency_us")) {
+    for (auto &entry : report["latency_us"].items()) {
+      if (!baseline["latency_us"].contains(entry.key()))
+        continue;
+      std::uint64_t before =
+          baseline["latency_us"][entry.key()].value("p95", std::uint64_t(0));
+      std::uint64_t now = entry.value()["p95"].get<std::uint64_t>();
+      if (before && now * 100 > before * (100 + BenchMaxSlowdown)) {
+        llvm::outs() << "p95 latency of " << entry.key() << " queries "
+                     << "regressed from " << before << "us to " << now
+                     << "us\n";
+        success = false;
+      }
+    }
+  }
+
+  if (success)
+    llvm::outs() << "no regressions against " << BenchBaseline << "\n";
+  return success;
+}
+} // namespace
+
+bool klee::runSolverBench(const std::vector<QueryCommand *> &queries,
+                          const std::string &queryLogDir) {
+  unsigned jobs = std::max(1u, std::min<unsigned>(BenchJobs, queries.size()));
+
+  json baseline;
+  if (!BenchBaseline.empty()) {
+    auto MB = llvm::MemoryBuffer::getFile(BenchBaseline);
+    if (!MB) {
+      llvm::errs() << "kleaver: error: " << BenchBaseline << ": "
+                   << MB.getError().message() << "\n";
+      return false;
+    }
+    baseline = json::parse(MB.get()->getBuffer().str(), nullptr, false);
+    if (baseline.is_discarded()) {
+      llvm::errs() << "kleaver: error: " << BenchBaseline
+                   << ": malformed JSON\n";
+      return false;
+    }
+  }
+
+  WallTimer timer;
+  std::vector<json> reports;
+  if (!runWorkers(queries, jobs, queryLogDir, reports))
+    return false;
+  time::Span wallTime = timer.delta();
+
+  // merge the worker reports
+  std::vector<std::string> results(queries.size());
+  std::vector<std::uint64_t> latencies[NumQueryKinds + 1];
+  std::vector<LayerProfile> layers;
+  std::map<std::string, std::uint64_t> statistics;
+  for (auto &report : reports) {
+    const json &indices = report["indices"];
+    for (size_t i = 0; i < indices.size(); ++i) {
+      unsigned index = indices[i].get<unsigned>();
+      std::uint64_t latency = report["latencies_us"][i].get<std::uint64_t>();
+      results[index] = report["results"][i].get<std::string>();
+      latencies[static_cast<unsigned>(getQueryKind(queries[index]))].push_back(
+          latency);
+      latencies[NumQueryKinds].push_back(latency);
+    }
+    const json &reportLayers = report["layers"];
+    layers.resize(reportLayers.size());
+    for (size_t i = 0; i < reportLayers.size(); ++i) {
+      layers[i].name = reportLayers[i]["name"].get<std::string>();
+      layers[i].calls += reportLayers[i]["calls"].get<std::uint64_t>();
+      layers[i].time +=
+          time::microseconds(reportLayers[i]["time_us"].get<std::uint64_t>());
+    }
+    for (auto &stat : report["statistics"].items())
+      statistics[stat.key()] += stat.value().get<std::uint64_t>();
+  }
+
+  json latencyJson = json::object();
+  for (unsigned kind = 0; kind <= NumQueryKinds; ++kind) {
+    auto &values = latencies[kind];
+    if (values.empty())
+      continue;
+    std::sort(values.begin(), values.end());
+    const char *name = kind == NumQueryKinds
+                           ? "all"
+                           : getQueryKindName(static_cast<QueryKind>(kind));
+    latencyJson[name] = {{"count", values.size()},
+                         {"p50", percentile(values, 50)},
+                         {"p95", percentile(values, 95)},
+                         {"p99", percentile(values, 99)}};
+  }
+
+  // layers are listed bottom-up, each one measuring everything below it
+  json layersJson = json::array();
+  for (size_t i = 0; i < layers.size(); ++i) {
+    time::Span self = layers[i].time;
+    if (i > 0)
+      self -= std::min(self, layers[i - 1].time);
+    layersJson.push_back({{"name", layers[i].name},
+                          {"calls", layers[i].calls},
+                          {"time_us", layers[i].time.toMicroseconds()},
+                          {"self_us", self.toMicroseconds()}});
+  }
+
+  double throughput =
+      wallTime ? queries.size() / wallTime.toSeconds() : 0.0;
+  json report = {
+      {"queries", queries.size()},
+      {"jobs", jobs},
+      {"wall_time_us", wallTime.toMicroseconds()},
+      {"throughput", throughput},
+      {"latency_us", latencyJson},
+      {"cache_hit_ratio",
+       {{"branch-cache", ratio(statistics["QueryCacheHits"],
+                               statistics["QueryCacheMisses"])},
+        {"cex-cache", ratio(statistics["QueryCexCacheHits"],
+                            statistics["QueryCexCacheMisses"])},
+        {"translation-cache", ratio(statistics["TranslationCacheHits"],
+                                    statistics["TranslationCacheMisses"])}}},
+      {"layers", layersJson},
+      {"statistics", statistics},
+      {"results", results}};
+
+  llvm::outs() << "queries = " << queries.size() << " (jobs = " << jobs
+               << ")\n"
+               << "wall time = " << wallTime << "\n"
+               << "throughput = " << llvm::format("%.2f", throughput)
+               << " queries/s\n";
+  llvm::outs() << "latency (us):\n";
+  for (auto &entry : latencyJson.items())
+    llvm::outs() << "  " << entry.key()
+                 << ": count = " << entry.value()["count"].get<std::uint64_t>()
+                 << ", p50 = " << entry.value()["p50"].get<std::uint64_t>()
+                 << ", p95 = " << entry.value()["p95"].get<std::uint64_t>()
+                 << ", p99 = " << entry.value()["p99"].get<std::uint64_t>()
+                 << "\n";
+  llvm::outs() << "cache hit ratio:\n";
+  for (auto &entry : report["cache_hit_ratio"].items())
+    llvm::outs() << "  " << entry.key() << ": "
+                 << llvm::format("%.3f", entry.value().get<double>()) << "\n";
+  llvm::outs() << "layer time (us, inclusive / self):\n";
+  for (auto it = layersJson.rbegin(), ie = layersJson.rend(); it != ie; ++it)
+    llvm::outs() << "  " << (*it)["name"].get<std::string>()
+                 << ": calls = " << (*it)["calls"].get<std::uint64_t>()
+                 << ", time = " << (*it)["time_us"].get<std::uint64_t>()
+                 << " / " << (*it)["self_us"].get<std::uint64_t>() << "\n";
+
+  if (!BenchOutput.empty()) {
+    std::error_code ec;
+    llvm::raw_fd_ostream os(BenchOutput, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+      llvm::errs() << "kleaver: error: " << BenchOutput << ": "
+                   << ec.message() << "\n";
+      return false;
+    }
+    os << report.dump(2) << "\n";
+  }
+
+  if (!BenchBaseline.empty())
+    return compareWithBaseline(report, baseline);
+  return true;
+}
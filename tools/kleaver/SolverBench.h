@@ -0,0 +1,32 @@
+//===-- SolverBench.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERBENCH_H
+#define KLEE_SOLVERBENCH_H
+
+#include <string>
+#include <vector>
+
+namespace klee {
+namespace expr {
+class QueryCommand;
+}
+
+/// Replay \p queries through the solver chain configured on the command
+/// line and report throughput, latency percentiles per query kind, cache
+/// hit ratios and the time spent in each layer of the chain. Query logs
+/// of the workers are written to \p queryLogDir.
+///
+/// \return false if the run failed or regressed against the baseline given
+/// with --bench-baseline.
+bool runSolverBench(const std::vector<expr::QueryCommand *> &queries,
+                    const std::string &queryLogDir);
+} // namespace klee
+
+#endif /* KLEE_SOLVERBENCH_H */
@@ -7,6 +7,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "SolverBench.h"
+
 #include "klee/ADT/SparseStorage.h"
 #include "klee/Config/Version.h"
 #include "klee/Expr/ArrayCache.h"
@@ -44,7 +46,7 @@ llvm::cl::opt<std::string> InputFile(llvm::cl::desc("<input query log>"),
                                      llvm::cl::Positional, llvm::cl::init("-"),
                                      llvm::cl::cat(klee::ExprCat));
 
-enum ToolActions { PrintTokens, PrintAST, PrintSMTLIBv2, Evaluate };
+enum ToolActions { PrintTokens, PrintAST, PrintSMTLIBv2, Evaluate, Bench };
 
 static llvm::cl::opt<ToolActions> ToolAction(
     llvm::cl::desc("Tool actions:"), llvm::cl::init(Evaluate),
@@ -56,7 +58,10 @@ static llvm::cl::opt<ToolActions> ToolAction(
         clEnumValN(PrintAST, "print-ast",
                    "Print parsed AST nodes from the input file."),
         clEnumValN(Evaluate, "evaluate",
-                   "Evaluate parsed AST nodes from the input file.")),
+                   "Evaluate parsed AST nodes from the input file."),
+        clEnumValN(Bench, "bench",
+                   "Replay the queries of the input file through the solver "
+                   "chain and report solver performance.")),
     llvm::cl::cat(klee::SolvingCat));
 
 enum BuilderKinds {
@@ -318,6 +323,39 @@ static bool EvaluateInputAST(const char *Filename, const llvm::MemoryBuffer *MB,
   return success;
 }
 
+static bool BenchInputAST(const char *Filename, const llvm::MemoryBuffer *MB,
+                          ExprBuilder *Builder) {
+  std::vector<Decl *> Decls;
+  Parser *P = Parser::Create(Filename, MB, Builder, ClearArrayAfterQuery);
+  P->SetMaxErrors(20);
+  while (Decl *D = P->ParseTopLevelDecl()) {
+    Decls.push_back(D);
+  }
+
+  bool success = true;
+  if (unsigned N = P->GetNumErrors()) {
+    llvm::errs() << Filename << ": parse failure: " << N << " errors.\n";
+    success = false;
+  }
+
+  if (success) {
+    std::vector<QueryCommand *> Queries;
+    for (Decl *D : Decls)
+      if (QueryCommand *QC = dyn_cast<QueryCommand>(D))
+        Queries.push_back(QC);
+    // exits if the query log directory is not usable
+    getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME);
+    success = runSolverBench(Queries, DirectoryToWriteQueryLogs);
+  }
+
+  for (std::vector<Decl *>::iterator it = Decls.begin(), ie = Decls.end();
+       it != ie; ++it)
+    delete *it;
+  delete P;
+
+  return success;
+}
+
 static bool printInputAsSMTLIBv2(const char *Filename,
                                  const llvm::MemoryBuffer *MB,
                                  ExprBuilder *Builder) {
@@ -432,6 +470,10 @@ int main(int argc, char **argv) {
     success = EvaluateInputAST(InputFile == "-" ? "<stdin>" : InputFile.c_str(),
                                MB.get(), Builder);
     break;
+  case Bench:
+    success = BenchInputAST(InputFile == "-" ? "<stdin>" : InputFile.c_str(),
+                            MB.get(), Builder);
+    break;
   case PrintSMTLIBv2:
     success = printInputAsSMTLIBv2(
         InputFile == "-" ? "<stdin>" : InputFile.c_str(), MB.get(), Builder);
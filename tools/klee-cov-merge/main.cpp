@@ -0,0 +1,258 @@
+//===-- main.cpp ------------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// klee-cov-merge merges the binary coverage files (run.cov) written by
+// `klee --output-coverage-bitmap` into a single coverage file, a
+// callgrind-style istats file and/or a SARIF summary.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Support/CoverageFile.h"
+#include "klee/Support/PrintVersion.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "nlohmann/json.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace klee;
+using json = nlohmann::json;
+
+namespace {
+llvm::cl::OptionCategory MergeCat("Merge options",
+                                  "These options control klee-cov-merge.");
+
+llvm::cl::list<std::string>
+    InputFiles(llvm::cl::desc("<run.cov files or klee output directories>"),
+               llvm::cl::Positional, llvm::cl::OneOrMore,
+               llvm::cl::cat(MergeCat));
+
+llvm::cl::opt<std::string>
+    OutputFile("o", llvm::cl::desc("Write the merged coverage file"),
+               llvm::cl::value_desc("file"), llvm::cl::cat(MergeCat));
+
+llvm::cl::opt<std::string> OutputIStats(
+    "istats",
+    llvm::cl::desc("Write merged instruction level statistics in callgrind "
+                   "format"),
+    llvm::cl::value_desc("file"), llvm::cl::cat(MergeCat));
+
+llvm::cl::opt<std::string>
+    OutputSarif("sarif",
+                llvm::cl::desc("Write a SARIF summary of uncovered code"),
+                llvm::cl::value_desc("file"), llvm::cl::cat(MergeCat));
+
+llvm::cl::opt<bool>
+    IgnoreMismatch("ignore-mismatch",
+                   llvm::cl::desc("Skip inputs produced from a different "
+                                  "module instead of failing (default=false)"),
+                   llvm::cl::init(false), llvm::cl::cat(MergeCat));
+
+std::string resolveInput(const std::string &path) {
+  if (llvm::sys::fs::is_directory(path)) {
+    llvm::SmallString<128> file(path);
+    llvm::sys::path::append(file, "run.cov");
+    return file.str().str();
+  }
+  return path;
+}
+
+std::unique_ptr<llvm::raw_fd_ostream> openOutput(const std::string &path) {
+  std::error_code ec;
+  auto os = std::make_unique<llvm::raw_fd_ostream>(path, ec,
+                                                   llvm::sys::fs::OF_None);
+  if (ec) {
+    llvm::errs() << "klee-cov-merge: error: cannot open " << path << ": "
+                 << ec.message() << "\n";
+    return nullptr;
+  }
+  return os;
+}
+
+void writeIStats(const CoverageData &coverage, llvm::raw_ostream &os) {
+  os << "version: 1\n";
+  os << "creator: klee-cov-merge\n";
+  os << "positions: line\n";
+  os << "event: Icov : CoveredInstructions\n";
+  os << "event: Iuncov : UncoveredInstructions\n";
+  os << "event: I : Instructions\n";
+  os << "events: Icov Iuncov I\n";
+
+  std::string sourceFile;
+  for (auto &fn : coverage.functions) {
+    std::string fnFile = coverage.getString(fn.file);
+    if (fnFile != sourceFile) {
+      os << "fl=" << fnFile << "\n";
+      sourceFile = fnFile;
+    }
+    os << "fn=" << coverage.getString(fn.name) << "\n";
+
+    for (uint64_t id = fn.firstIndex,
+                  end = uint64_t(fn.firstIndex) + fn.numIndices;
+         id < end; ++id) {
+      if (!coverage.test(CoverageBitmap::Coverable, id) &&
+          !coverage.counts[id])
+        continue;
+      std::string file = coverage.getString(coverage.lines[id].file);
+      if (file != sourceFile) {
+        os << "fl=" << file << "\n";
+        sourceFile = file;
+      }
+      bool covered = coverage.test(CoverageBitmap::Covered, id);
+      bool coverable = coverage.test(CoverageBitmap::Coverable, id);
+      os << coverage.lines[id].line << " " << covered << " "
+         << (coverable && !covered) << " " << coverage.counts[id] << "\n";
+    }
+  }
+}
+
+json makeSarif(const CoverageData &coverage, unsigned numInputs) {
+  uint64_t coverable = 0, covered = 0, branchOutcomes = 0;
+  for (uint64_t w = 0; w < coverage.getNumWords(); ++w) {
+    uint64_t coverableWord =
+        coverage.bitmaps[static_cast<unsigned>(CoverageBitmap::Coverable)][w];
+    coverable += llvm::countPopulation(coverableWord);
+    covered += llvm::countPopulation(
+        coverage.bitmaps[static_cast<unsigned>(CoverageBitmap::Covered)][w] &
+        coverableWord);
+    branchOutcomes += llvm::countPopulation(
+        coverage.bitmaps[static_cast<unsigned>(CoverageBitmap::BranchTrue)][w]);
+    branchOutcomes += llvm::countPopulation(
+        coverage
+            .bitmaps[static_cast<unsigned>(CoverageBitmap::BranchFalse)][w]);
+  }
+
+  // One note per function containing uncovered code, located at the first
+  // uncovered line.
+  json results = json::array();
+  for (auto &fn : coverage.functions) {
+    unsigned fnCoverable = 0, fnUncovered = 0;
+    const CoverageLine *firstUncovered = nullptr;
+    for (uint64_t id = fn.firstIndex,
+                  end = uint64_t(fn.firstIndex) + fn.numIndices;
+         id < end; ++id) {
+      if (!coverage.test(CoverageBitmap::Coverable, id))
+        continue;
+      ++fnCoverable;
+      if (coverage.test(CoverageBitmap::Covered, id))
+        continue;
+      ++fnUncovered;
+      if (!firstUncovered || (coverage.lines[id].line &&
+                              (!firstUncovered->line ||
+                               coverage.lines[id].line < firstUncovered->line)))
+        firstUncovered = &coverage.lines[id];
+    }
+    if (!fnUncovered)
+      continue;
+
+    json region = json::object();
+    if (firstUncovered->line)
+      region["startLine"] = firstUncovered->line;
+    results.push_back(
+        {{"ruleId", "UncoveredCode"},
+         {"level", "note"},
+         {"message",
+          {{"text", std::to_string(fnUncovered) + " of " +
+                        std::to_string(fnCoverable) +
+                        " instructions not covered in " +
+                        coverage.getString(fn.name)}}},
+         {"locations",
+          json::array(
+              {{{"physicalLocation",
+                 {{"artifactLocation",
+                   {{"uri", coverage.getString(firstUncovered->file)}}},
+                  {"region", region}}}}})}});
+  }
+
+  json run = {
+      {"tool",
+       {{"driver",
+         {{"name", "klee-cov-merge"},
+          {"rules",
+           json::array({{{"id", "UncoveredCode"},
+                         {"shortDescription",
+                          {{"text", "Code not covered by any input"}}}}})}}}}},
+      {"results", results},
+      {"properties",
+       {{"inputs", numInputs},
+        {"coverableInstructions", coverable},
+        {"coveredInstructions", covered},
+        {"coveredBranchOutcomes", branchOutcomes}}}};
+
+  return {{"$schema", "https://json.schemastore.org/sarif-2.1.0.json"},
+          {"version", "2.1.0"},
+          {"runs", json::array({run})}};
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::cl::SetVersionPrinter(klee::printVersion);
+  llvm::cl::HideUnrelatedOptions(MergeCat);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "Merge KLEE binary coverage files\n");
+
+  std::unique_ptr<CoverageData> merged;
+  unsigned numMerged = 0;
+
+  for (auto &input : InputFiles) {
+    std::string path = resolveInput(input);
+    std::string error;
+    auto view = CoverageFileView::open(path, error);
+    if (!view) {
+      llvm::errs() << "klee-cov-merge: error: " << path << ": " << error
+                   << "\n";
+      return 1;
+    }
+
+    if (!merged)
+      merged = std::make_unique<CoverageData>(*view);
+
+    if (!merged->merge(*view)) {
+      llvm::errs() << "klee-cov-merge: " << (IgnoreMismatch ? "warning" : "error")
+                   << ": " << path
+                   << ": coverage was recorded for a different module\n";
+      if (!IgnoreMismatch)
+        return 1;
+      continue;
+    }
+    ++numMerged;
+  }
+
+  if (!OutputFile.empty()) {
+    auto os = openOutput(OutputFile);
+    if (!os)
+      return 1;
+    merged->write(*os);
+  }
+
+  if (!OutputIStats.empty()) {
+    auto os = openOutput(OutputIStats);
+    if (!os)
+      return 1;
+    writeIStats(*merged, *os);
+  }
+
+  if (!OutputSarif.empty()) {
+    auto os = openOutput(OutputSarif);
+    if (!os)
+      return 1;
+    *os << makeSarif(*merged, numMerged).dump(2) << "\n";
+  }
+
+  return 0;
+}
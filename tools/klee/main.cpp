@@ -43,6 +43,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -57,6 +58,7 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
@@ -126,6 +128,13 @@ cl::opt<bool>
                cl::desc("Write .path files for each test case (default=false)"),
                cl::cat(TestCaseCat));
 
+cl::opt<bool> WriteBinaryPaths(
+    "write-binary-paths",
+    cl::desc("Write .path.bin files with the branches of each test case "
+             "packed into bits, which --replay-path loads faster "
+             "(default=false)"),
+    cl::cat(TestCaseCat));
+
 cl::opt<bool> WriteSymPaths(
     "write-sym-paths",
     cl::desc("Write .sym.path files for each test case (default=false)"),
@@ -185,6 +194,13 @@ cl::opt<bool> SimplifyModule(
     "simplify", cl::desc("Simplify the code before execution (default=true)."),
     cl::init(true), cl::cat(StartCat));
 
+cl::opt<std::string> ModuleCacheDir(
+    "module-cache-dir",
+    cl::desc("Store the linked and prepared module in this directory and "
+             "reuse it in later runs on the same input with the same runtime "
+             "and options (default=off)"),
+    cl::cat(StartCat));
+
 cl::opt<bool> WarnAllExternals(
     "warn-all-external-symbols",
     cl::desc(
@@ -479,6 +495,8 @@ public:
 
   // load a .path file
   static void loadPathFile(std::string name, std::vector<bool> &buffer);
+  static void writeBinaryPath(llvm::raw_ostream &os,
+                              const std::vector<unsigned char> &branches);
 
   static void getKTestFilesInDir(std::string directoryPath,
                                  std::vector<std::string> &results);
@@ -584,7 +602,7 @@ KleeHandler::~KleeHandler() {
 void KleeHandler::setInterpreter(Interpreter *i) {
   m_interpreter = i;
 
-  if (WritePaths) {
+  if (WritePaths || WriteBinaryPaths) {
     m_pathWriter = new TreeStreamWriter(getOutputFilename("paths.ts"));
     assert(m_pathWriter->good());
     m_interpreter->setPathWriter(m_pathWriter);
@@ -677,7 +695,7 @@ void KleeHandler::processTestCase(const ExecutionState &state,
   if (!WriteNone &&
       (FunctionCallReproduce == "" || strcmp(suffix, "assert.err") == 0 ||
        strcmp(suffix, "reachable.err") == 0)) {
-    KTest ktest;
+    KTest ktest = {};
     ktest.numArgs = m_argc;
     ktest.args = m_argv;
     ktest.symArgvs = 0;
@@ -733,12 +751,19 @@ void KleeHandler::processTestCase(const ExecutionState &state,
       std::vector<unsigned char> concreteBranches;
       m_pathWriter->readStream(m_interpreter->getPathStreamID(state),
                                concreteBranches);
-      auto f = openTestFile("path", id);
-      if (f) {
-        for (const auto &branch : concreteBranches) {
-          *f << branch << '\n';
+      if (WritePaths) {
+        auto f = openTestFile("path", id);
+        if (f) {
+          for (const auto &branch : concreteBranches) {
+            *f << branch << '\n';
+          }
         }
       }
+      if (WriteBinaryPaths) {
+        auto f = openTestFile("path.bin", id);
+        if (f)
+          writeBinaryPath(*f, concreteBranches);
+      }
     }
 
     if (m_symPathWriter) {
@@ -892,13 +917,50 @@ void KleeHandler::writeTestCaseXML(bool isError, const KTest &assignments,
   *file << "</testcase>\n";
 }
 
-// load a .path file
+// .path.bin files start with this magic, followed by the number of branches
+// as 64-bit little endian and the branches packed into bits
+static const char BinaryPathMagic[] = {'K', 'L', 'E', 'E', 'P', 'A', 'T', 'H'};
+
+void KleeHandler::writeBinaryPath(llvm::raw_ostream &os,
+                                  const std::vector<unsigned char> &branches) {
+  os.write(BinaryPathMagic, sizeof(BinaryPathMagic));
+  uint64_t count = branches.size();
+  for (unsigned i = 0; i < 8; ++i)
+    os << (char)(count >> (8 * i));
+  std::vector<char> bits((count + 7) / 8, 0);
+  for (uint64_t i = 0; i < count; ++i)
+    if (branches[i] == '1')
+      bits[i / 8] |= 1 << (i % 8);
+  os.write(bits.data(), bits.size());
+}
+
+// load a .path or .path.bin file
 void KleeHandler::loadPathFile(std::string name, std::vector<bool> &buffer) {
   std::ifstream f(name.c_str(), std::ios::in | std::ios::binary);
 
   if (!f.good())
     assert(0 && "unable to open path file");
 
+  char magic[sizeof(BinaryPathMagic)];
+  if (f.read(magic, sizeof(magic)) &&
+      !memcmp(magic, BinaryPathMagic, sizeof(magic))) {
+    unsigned char data[8];
+    if (!f.read(reinterpret_cast<char *>(data), sizeof(data)))
+      klee_error("truncated path file: %s", name.c_str());
+    uint64_t count = 0;
+    for (unsigned i = 0; i < 8; ++i)
+      count |= uint64_t(data[i]) << (8 * i);
+    std::vector<char> bits((count + 7) / 8);
+    if (!f.read(bits.data(), bits.size()))
+      klee_error("truncated path file: %s", name.c_str());
+    buffer.reserve(buffer.size() + count);
+    for (uint64_t i = 0; i < count; ++i)
+      buffer.push_back((bits[i / 8] >> (i % 8)) & 1);
+    return;
+  }
+  f.clear();
+  f.seekg(0, std::ios::beg);
+
   while (f.good()) {
     unsigned value;
     f >> value;
@@ -1024,6 +1086,53 @@ static void parseArguments(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv, " klee\n");
 }
 
+/// Collect the options given on the command line which may influence the
+/// prepared module, as part of the module cache key. Options which only
+/// affect execution are left out; all others are kept, so that an unknown
+/// option can at worst cause a cache miss.
+static std::string getModuleCacheOptions(int argc, char **argv) {
+  const std::set<cl::OptionCategory *> executionOnly = {
+      &ReplayCat, &SearchCat,      &SeedingCat,  &SolvingCat,
+      &StatsCat,  &TerminationCat, &TestCaseCat, &TestGenCat};
+  StringMap<cl::Option *> &options = cl::getRegisteredOptions();
+
+  std::string result;
+  for (int i = 1; i < argc; ++i) {
+    StringRef arg(argv[i]);
+    if (arg.startswith("@")) {
+      // response file
+      if (auto buffer = MemoryBuffer::getFile(arg.drop_front()))
+        result += buffer.get()->getBuffer().str();
+      result += "\n";
+      continue;
+    }
+    if (!arg.startswith("-"))
+      break; // the input file, followed by the program arguments
+
+    StringRef name = arg.ltrim('-').split('=').first;
+    auto it = options.find(name);
+    bool skip = name == "output-dir" || name == ModuleCacheDir.ArgStr;
+    bool separateValue = false;
+    if (it != options.end()) {
+      skip |= llvm::all_of(it->second->Categories, [&](cl::OptionCategory *c) {
+        return executionOnly.count(c);
+      });
+      separateValue =
+          !arg.contains('=') &&
+          it->second->getValueExpectedFlag() == cl::ValueRequired;
+    }
+
+    if (!skip)
+      result += arg.str() + "\n";
+    if (separateValue && i + 1 < argc) {
+      ++i;
+      if (!skip)
+        result += std::string(argv[i]) + "\n";
+    }
+  }
+  return result;
+}
+
 static void
 preparePOSIX(std::vector<std::unique_ptr<llvm::Module>> &loadedModules,
              const std::string &EntryPoint) {
@@ -1531,16 +1640,12 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
                                             ie = ReplayKTestDir.end();
          it != ie; ++it)
       KleeHandler::getKTestFilesInDir(*it, kTestFiles);
-    std::vector<KTest *> kTests;
-    for (std::vector<std::string>::iterator it = kTestFiles.begin(),
-                                            ie = kTestFiles.end();
-         it != ie; ++it) {
-      KTest *out = kTest_fromFile(it->c_str());
-      if (out) {
-        kTests.push_back(out);
-      } else {
-        klee_warning("unable to open: %s\n", (*it).c_str());
-      }
+    // Tests are loaded one at a time when they are replayed, so their paths
+    // must survive the change of directory
+    for (auto &kTestFile : kTestFiles) {
+      SmallString<128> path(kTestFile);
+      if (!sys::fs::make_absolute(path))
+        kTestFile = path.str().str();
     }
 
     if (RunInDir != "") {
@@ -1552,52 +1657,51 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
     }
 
     unsigned i = 0;
-    for (std::vector<KTest *>::iterator it = kTests.begin(), ie = kTests.end();
-         it != ie; ++it) {
-      KTest *out = *it;
+    for (const auto &kTestFile : kTestFiles) {
+      KTest *out = kTest_fromFileMapped(kTestFile.c_str());
+      ++i;
+      if (!out) {
+        klee_warning("unable to open: %s\n", kTestFile.c_str());
+        continue;
+      }
       interpreter->setReplayKTest(out);
-      llvm::errs() << "KLEE: replaying: " << *it << " (" << kTest_numBytes(out)
-                   << " bytes)"
-                   << " (" << ++i << "/" << kTestFiles.size() << ")\n";
+      llvm::errs() << "KLEE: replaying: " << kTestFile << " ("
+                   << kTest_numBytes(out) << " bytes)"
+                   << " (" << i << "/" << kTestFiles.size() << ")\n";
       // XXX should put envp in .ktest ?
       interpreter->runFunctionAsMain(mainFn, out->numArgs, out->args, pEnvp);
+      interpreter->setReplayKTest(0);
+      kTest_free(out);
       if (interrupted)
         break;
     }
-    interpreter->setReplayKTest(0);
-    while (!kTests.empty()) {
-      kTest_free(kTests.back());
-      kTests.pop_back();
-    }
   } else {
-    std::vector<KTest *> seeds;
+    // Seeds are only read when they are first used, so just collect their
+    // paths, which must survive the change of directory
+    std::vector<std::string> seeds;
     for (std::vector<std::string>::iterator it = SeedOutFile.begin(),
                                             ie = SeedOutFile.end();
          it != ie; ++it) {
-      KTest *out = kTest_fromFile(it->c_str());
-      if (!out) {
+      if (!sys::fs::exists(*it)) {
         klee_error("unable to open: %s\n", (*it).c_str());
       }
-      seeds.push_back(out);
+      seeds.push_back(*it);
     }
     for (std::vector<std::string>::iterator it = SeedOutDir.begin(),
                                             ie = SeedOutDir.end();
          it != ie; ++it) {
       std::vector<std::string> kTestFiles;
       KleeHandler::getKTestFilesInDir(*it, kTestFiles);
-      for (std::vector<std::string>::iterator it2 = kTestFiles.begin(),
-                                              ie = kTestFiles.end();
-           it2 != ie; ++it2) {
-        KTest *out = kTest_fromFile(it2->c_str());
-        if (!out) {
-          klee_error("unable to open: %s\n", (*it2).c_str());
-        }
-        seeds.push_back(out);
-      }
+      seeds.insert(seeds.end(), kTestFiles.begin(), kTestFiles.end());
       if (kTestFiles.empty()) {
         klee_error("seeds directory is empty: %s\n", (*it).c_str());
       }
     }
+    for (auto &seed : seeds) {
+      SmallString<128> path(seed);
+      if (!sys::fs::make_absolute(path))
+        seed = path.str().str();
+    }
 
     if (!seeds.empty()) {
       klee_message("KLEE: using %lu seeds\n", seeds.size());
@@ -1612,11 +1716,6 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
     }
 
     interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
-
-    while (!seeds.empty()) {
-      kTest_free(seeds.back());
-      seeds.pop_back();
-    }
   }
 
   auto endTime = std::time(nullptr);
@@ -2167,6 +2266,9 @@ int main(int argc, char **argv, char **envp) {
       /*AnnotateOnlyExternal=*/AnnotateOnlyExternal,
       /*WithFPRuntime=*/WithFPRuntime,
       /*WithPOSIXRuntime=*/WithPOSIXRuntime);
+  Opts.ModuleCacheDir = ModuleCacheDir;
+  if (!ModuleCacheDir.empty())
+    Opts.ModuleCacheOptions = getModuleCacheOptions(argc, argv);
 
   // Get the main function
   for (auto &module : loadedUserModules) {
@@ -72,7 +72,7 @@ int main(int argc, char *argv[]) {
   if (argc < 2)
     print_usage_and_exit(argv[0]);
 
-  KTest b;
+  KTest b = {};
   b.symArgvs = 0;
   b.symArgvLen = 0;
 
@@ -175,7 +175,7 @@ int main(int argc, char *argv[]) {
     argv_copy[i - 1] = argv[i];
   }
 
-  KTest b;
+  KTest b = {};
   b.numArgs = argc - 1;
   b.args = argv_copy;
   b.symArgvs = 0;
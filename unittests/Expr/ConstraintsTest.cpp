@@ -0,0 +1,70 @@
+//===-- ConstraintsTest.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/SourceBuilder.h"
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> makeRead(const std::string &name, unsigned id) {
+  const Array *array =
+      Array::create(ConstantExpr::create(4, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic(name, id));
+  return Expr::createTempRead(array, 32);
+}
+
+TEST(RewriteIndexTest, RemoveRestoresNextOwner) {
+  // x is taller than y, so B rewrites x to y
+  ref<Expr> x = AddExpr::create(makeRead("x", 0), makeRead("z", 0));
+  ref<Expr> y = makeRead("y", 0);
+  ref<Expr> one = ConstantExpr::create(1, Expr::Int32);
+  ref<Expr> a = EqExpr::create(one, x);
+  ref<Expr> b = EqExpr::create(x, y);
+
+  RewriteIndex index;
+  index.add(a);
+  index.add(b);
+  ASSERT_TRUE(index.equalities().lookup(x));
+  EXPECT_EQ(*index.equalities().lookup(x), one);
+  EXPECT_EQ(*index.parents().lookup(x), a);
+
+  index.remove(a);
+  ASSERT_TRUE(index.equalities().lookup(x));
+  EXPECT_EQ(*index.equalities().lookup(x), y);
+  EXPECT_EQ(*index.parents().lookup(x), b);
+  EXPECT_TRUE(index.equalities().lookup(b));
+
+  index.remove(b);
+  EXPECT_FALSE(index.equalities().lookup(x));
+  EXPECT_FALSE(index.equalities().lookup(b));
+}
+
+TEST(RewriteIndexTest, RemoveKeepsRewriteInEffect) {
+  ref<Expr> x = AddExpr::create(makeRead("x", 0), makeRead("z", 0));
+  ref<Expr> y = makeRead("y", 0);
+  ref<Expr> one = ConstantExpr::create(1, Expr::Int32);
+  ref<Expr> a = EqExpr::create(one, x);
+  ref<Expr> b = EqExpr::create(x, y);
+
+  RewriteIndex index;
+  index.add(a);
+  index.add(b);
+  index.remove(b);
+  ASSERT_TRUE(index.equalities().lookup(x));
+  EXPECT_EQ(*index.equalities().lookup(x), one);
+  EXPECT_EQ(*index.parents().lookup(x), a);
+  EXPECT_FALSE(index.equalities().lookup(b));
+}
+
+} // namespace
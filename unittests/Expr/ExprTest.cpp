@@ -287,4 +287,50 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+
+TEST(ExprTest, ReadExprFoldingLongConcreteUpdateChain) {
+  unsigned size = 128;
+
+  // Constant array
+  SparseStorageImpl<ref<ConstantExpr>> Contents(
+      ConstantExpr::create(0, Expr::Int8));
+  for (unsigned i = 0; i < size; ++i)
+    Contents.store(i, ConstantExpr::create(i + 1, Expr::Int8));
+
+  const Array *array =
+      Array::create(ConstantExpr::create(size, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::constant(Contents.clone()));
+  const Array *array2 =
+      Array::create(ConstantExpr::create(256, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("arr", 3));
+
+  // Long runs of constant-index updates on both sides of a symbolic-index
+  // update, enough to span several indexed snapshots
+  UpdateList ul(array, 0);
+  for (unsigned i = 0; i < 100; ++i)
+    ul.extend(ConstantExpr::create(i % 50, Expr::Int32),
+              ConstantExpr::create(i, Expr::Int8));
+  ul.extend(ReadExpr::createTempRead(array2, Expr::Int32),
+            ConstantExpr::create(200, Expr::Int8));
+  for (unsigned i = 0; i < 100; ++i)
+    ul.extend(ConstantExpr::create(i % 40, Expr::Int32),
+              ConstantExpr::create(i + 100, Expr::Int8));
+
+  // Indices written after the symbolic update fold to the latest value
+  for (unsigned i = 0; i < 40; ++i) {
+    ref<Expr> read = ReadExpr::create(ul, ConstantExpr::create(i, Expr::Int32));
+    ASSERT_EQ(Expr::Constant, read->getKind());
+    unsigned expected = i < 20 ? i + 180 : i + 140;
+    EXPECT_EQ(expected, cast<ConstantExpr>(read)->getZExtValue());
+  }
+
+  // Other indices stop at the symbolic update and keep it as the head
+  for (unsigned i = 40; i < 60; ++i) {
+    ref<Expr> read = ReadExpr::create(ul, ConstantExpr::create(i, Expr::Int32));
+    ASSERT_EQ(Expr::Read, read->getKind());
+    const UpdateNode *head = cast<ReadExpr>(read)->updates.head.get();
+    ASSERT_TRUE(head);
+    EXPECT_FALSE(isa<ConstantExpr>(head->index));
+  }
+}
 } // namespace
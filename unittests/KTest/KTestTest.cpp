@@ -0,0 +1,112 @@
+#include "klee/ADT/KTest.h"
+#include "gtest/gtest.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+/// Temporary .ktest file with one object of the given size and a pointer
+/// record, removed again on destruction.
+class TestFile {
+  llvm::SmallString<128> path;
+
+public:
+  std::vector<unsigned char> bytes;
+
+  explicit TestFile(unsigned size) : bytes(size) {
+    for (unsigned i = 0; i < size; ++i)
+      bytes[i] = i * 7;
+
+    char arg0[] = "prog", arg1[] = "--flag";
+    char *args[] = {arg0, arg1};
+    char name[] = "obj";
+    Pointer pointer = {8, 1, 4};
+    KTestObject object = {};
+    object.name = name;
+    object.numBytes = size;
+    object.bytes = bytes.data();
+    object.numPointers = 1;
+    object.pointers = &pointer;
+    KTest test = {};
+    test.numArgs = 2;
+    test.args = args;
+    test.symArgvs = 1;
+    test.symArgvLen = 3;
+    test.numObjects = 1;
+    test.objects = &object;
+
+    int fd;
+    EXPECT_FALSE(
+        llvm::sys::fs::createTemporaryFile("ktest", "ktest", fd, path));
+    ::close(fd);
+    EXPECT_TRUE(kTest_toFile(&test, path.c_str()));
+  }
+  ~TestFile() { llvm::sys::fs::remove(path); }
+
+  const char *getPath() { return path.c_str(); }
+};
+
+void expectEqual(const KTest *a, const KTest *b) {
+  ASSERT_EQ(a->version, b->version);
+  ASSERT_EQ(a->numArgs, b->numArgs);
+  for (unsigned i = 0; i < a->numArgs; ++i)
+    EXPECT_STREQ(a->args[i], b->args[i]);
+  EXPECT_EQ(a->symArgvs, b->symArgvs);
+  EXPECT_EQ(a->symArgvLen, b->symArgvLen);
+  ASSERT_EQ(a->numObjects, b->numObjects);
+  for (unsigned i = 0; i < a->numObjects; ++i) {
+    const KTestObject &x = a->objects[i], &y = b->objects[i];
+    EXPECT_STREQ(x.name, y.name);
+    ASSERT_EQ(x.numBytes, y.numBytes);
+    EXPECT_EQ(0, memcmp(x.bytes, y.bytes, x.numBytes));
+    ASSERT_EQ(x.numPointers, y.numPointers);
+    for (unsigned j = 0; j < x.numPointers; ++j) {
+      EXPECT_EQ(x.pointers[j].offset, y.pointers[j].offset);
+      EXPECT_EQ(x.pointers[j].index, y.pointers[j].index);
+      EXPECT_EQ(x.pointers[j].indexOffset, y.pointers[j].indexOffset);
+    }
+  }
+}
+
+void checkRoundTrip(unsigned size, bool expectMapped) {
+  TestFile file(size);
+  KTest *copied = kTest_fromFile(file.getPath());
+  KTest *mapped = kTest_fromFileMapped(file.getPath());
+  ASSERT_TRUE(copied);
+  ASSERT_TRUE(mapped);
+  EXPECT_EQ(mapped->bufferIsMapped, expectMapped);
+  expectEqual(copied, mapped);
+  ASSERT_EQ(mapped->objects[0].numBytes, size);
+  EXPECT_EQ(0, memcmp(mapped->objects[0].bytes, file.bytes.data(), size));
+  kTest_free(copied);
+  kTest_free(mapped);
+}
+} // namespace
+
+TEST(KTestTest, RoundTripSmall) { checkRoundTrip(16, false); }
+
+TEST(KTestTest, RoundTripLarge) { checkRoundTrip(1 << 20, true); }
+
+TEST(KTestTest, Truncated) {
+  TestFile file(1000);
+  uint64_t size;
+  ASSERT_FALSE(llvm::sys::fs::file_size(file.getPath(), size));
+  // every proper prefix of the file is rejected by both loaders
+  for (uint64_t length : {size - 1, size / 2, uint64_t(12), uint64_t(3),
+                          uint64_t(0)}) {
+    ASSERT_EQ(0, ::truncate(file.getPath(), length));
+    EXPECT_FALSE(kTest_fromFile(file.getPath()));
+    EXPECT_FALSE(kTest_fromFileMapped(file.getPath()));
+  }
+}
+
+TEST(KTestTest, Missing) {
+  EXPECT_FALSE(kTest_fromFileMapped("/nonexistent/test000001.ktest"));
+}
@@ -28,9 +28,8 @@ TEST(SearcherTest, RandomPath) {
   ExecutionState es;
   PForest processForest = PForest();
   processForest.addRoot(&es);
-  es.ptreeNode = processForest.getPTrees()
-                     .at(es.ptreeNode->getTreeID())
-                     ->root.getPointer();
+  es.ptreeNode =
+      processForest.getPTrees().at(es.ptreeNode->getTreeID())->root;
 
   RNG rng;
   RandomPathSearcher rp(processForest, rng);
@@ -71,9 +70,8 @@ TEST(SearcherTest, TwoRandomPath) {
   ExecutionState root;
   PForest processForest = PForest();
   processForest.addRoot(&root);
-  root.ptreeNode = processForest.getPTrees()
-                       .at(root.ptreeNode->getTreeID())
-                       ->root.getPointer();
+  root.ptreeNode =
+      processForest.getPTrees().at(root.ptreeNode->getTreeID())->root;
 
   ExecutionState es(root);
   processForest.attach(root.ptreeNode, &es, &root);
@@ -132,9 +130,8 @@ TEST(SearcherTest, TwoRandomPathDot) {
   ExecutionState root;
   PForest processForest = PForest();
   processForest.addRoot(&root);
-  root.ptreeNode = processForest.getPTrees()
-                       .at(root.ptreeNode->getTreeID())
-                       ->root.getPointer();
+  root.ptreeNode =
+      processForest.getPTrees().at(root.ptreeNode->getTreeID())->root;
   rootPNode = root.ptreeNode;
 
   ExecutionState es(root);
@@ -166,13 +163,12 @@ TEST(SearcherTest, TwoRandomPathDot) {
       << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
       << "\tedge [arrowsize=.3]\n"
       << "\tn" << rootPNode << " [shape=diamond];\n"
-      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b011];\n"
-      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b000];\n"
+      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b11];\n"
+      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b00];\n"
       << "\tn" << rightLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << esParentPNode << " [shape=diamond];\n"
-      << "\tn" << esParentPNode << " -> n" << es1LeafPNode
-      << " [label=0b010];\n"
-      << "\tn" << esParentPNode << " -> n" << esLeafPNode << " [label=0b001];\n"
+      << "\tn" << esParentPNode << " -> n" << es1LeafPNode << " [label=0b10];\n"
+      << "\tn" << esParentPNode << " -> n" << esLeafPNode << " [label=0b01];\n"
       << "\tn" << esLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << es1LeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "}\n";
@@ -197,12 +193,9 @@ TEST(SearcherTest, TwoRandomPathDot) {
       << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
       << "\tedge [arrowsize=.3]\n"
       << "\tn" << rootPNode << " [shape=diamond];\n"
-      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b001];\n"
-      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b000];\n"
+      << "\tn" << rootPNode << " -> n" << es1LeafPNode << " [label=0b01];\n"
+      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b00];\n"
       << "\tn" << rightLeafPNode << " [shape=diamond,fillcolor=green];\n"
-      << "\tn" << esParentPNode << " [shape=diamond];\n"
-      << "\tn" << esParentPNode << " -> n" << es1LeafPNode
-      << " [label=0b001];\n"
       << "\tn" << es1LeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "}\n";
 
@@ -212,20 +205,92 @@ TEST(SearcherTest, TwoRandomPathDot) {
   processForest.remove(es1.ptreeNode);
   processForest.remove(root.ptreeNode);
 }
-TEST(SearcherDeathTest, TooManyRandomPaths) {
-  // First state
+TEST(SearcherTest, WeightedRandomPath) {
+  // Root state
   ExecutionState es;
   PForest processForest = PForest();
   processForest.addRoot(&es);
-  es.ptreeNode = processForest.getPTrees()
-                     .at(es.ptreeNode->getTreeID())
-                     ->root.getPointer();
-  processForest.remove(es.ptreeNode); // Need to remove to avoid leaks
+  es.ptreeNode =
+      processForest.getPTrees().at(es.ptreeNode->getTreeID())->root;
 
   RNG rng;
-  RandomPathSearcher rp(processForest, rng);
+  WeightedRandomPathSearcher rp(processForest, WeightedRandomSearcher::Depth,
+                                rng);
   RandomPathSearcher rp1(processForest, rng);
-  RandomPathSearcher rp2(processForest, rng);
-  ASSERT_DEATH({ RandomPathSearcher rp3(processForest, rng); }, "");
+  EXPECT_TRUE(rp.empty());
+
+  rp.update(nullptr, {&es}, {});
+  rp1.update(nullptr, {&es}, {});
+  EXPECT_FALSE(rp.empty());
+  EXPECT_EQ(&rp.selectState(), &es);
+
+  // States of depth zero are never selected next to deeper ones
+  ExecutionState es1(es);
+  es1.depth = 3;
+  processForest.attach(es.ptreeNode, &es1, &es);
+  rp.update(&es, {&es1}, {});
+  rp1.update(&es, {&es1}, {});
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(&rp.selectState(), &es1);
+  }
+
+  ExecutionState es2(es);
+  es2.depth = 1;
+  processForest.attach(es.ptreeNode, &es2, &es);
+  rp.update(&es, {&es2}, {});
+  int selected = 0;
+  for (int i = 0; i < 1000; i++) {
+    ExecutionState &state = rp.selectState();
+    EXPECT_NE(&state, &es);
+    selected += &state == &es1;
+  }
+  // es1 weighs three times as much as es2
+  EXPECT_GT(selected, 650);
+  EXPECT_LT(selected, 850);
+
+  rp.update(nullptr, {}, {&es1, &es2});
+  EXPECT_EQ(&rp.selectState(), &es);
+  rp.update(nullptr, {}, {&es});
+  EXPECT_TRUE(rp.empty());
+  EXPECT_FALSE(rp1.empty());
+
+  rp1.update(nullptr, {}, {&es, &es1});
+  processForest.remove(es2.ptreeNode);
+  processForest.remove(es1.ptreeNode);
+  processForest.remove(es.ptreeNode);
+  EXPECT_TRUE(rp1.empty());
+}
+
+TEST(SearcherTest, ManyRandomPaths) {
+  // Root state
+  ExecutionState es;
+  PForest processForest = PForest();
+  processForest.addRoot(&es);
+  es.ptreeNode =
+      processForest.getPTrees().at(es.ptreeNode->getTreeID())->root;
+
+  ExecutionState es1(es);
+  processForest.attach(es.ptreeNode, &es1, &es);
+
+  RNG rng;
+  std::vector<std::unique_ptr<RandomPathSearcher>> searchers;
+  for (int i = 0; i < 100; i++) {
+    searchers.emplace_back(new RandomPathSearcher(processForest, rng));
+    if (i % 2)
+      searchers.back()->update(nullptr, {&es1}, {});
+    else
+      searchers.back()->update(nullptr, {&es}, {});
+  }
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(&searchers[i]->selectState(), i % 2 ? &es1 : &es);
+  }
+
+  for (int i = 0; i < 100; i++) {
+    searchers[i]->update(nullptr, {}, {i % 2 ? &es1 : &es});
+    EXPECT_TRUE(searchers[i]->empty());
+  }
+  processForest.remove(es1.ptreeNode);
+  processForest.remove(es.ptreeNode);
 }
 } // namespace
@@ -0,0 +1,118 @@
+#include "klee/Statistics/Statistic.h"
+#include "klee/Statistics/Statistics.h"
+#include "gtest/gtest-death-test.h"
+#include "gtest/gtest.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+Statistic counter("TestCounter", "TCnt");
+
+/// Blocks threads until all of them have arrived, so that they hold their
+/// shards at the same time.
+class Barrier {
+  std::mutex mutex;
+  std::condition_variable arrived;
+  unsigned waiting;
+
+public:
+  explicit Barrier(unsigned count) : waiting(count) {}
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (--waiting == 0)
+      arrived.notify_all();
+    else
+      arrived.wait(lock, [this] { return waiting == 0; });
+  }
+};
+} // namespace
+
+TEST(StatisticsTest, SumsShards) {
+  const unsigned numThreads = 8;
+  const std::uint64_t increments = 10000;
+  std::uint64_t before = counter.getValue();
+
+  Barrier barrier(numThreads);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; ++t)
+    threads.emplace_back([&barrier, t, increments] {
+      barrier.wait();
+      for (std::uint64_t i = 0; i < increments; ++i)
+        counter += t + 1;
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  // values of exited threads remain in their shards
+  std::uint64_t expected = increments * numThreads * (numThreads + 1) / 2;
+  ASSERT_EQ(counter.getValue() - before, expected);
+}
+
+TEST(StatisticsTest, ReusesShardsOfExitedThreads) {
+  std::thread([] { counter += 1; }).join();
+  unsigned numShards = theStatisticManager->getNumShards();
+  std::uint64_t before = counter.getValue();
+
+  for (unsigned i = 0; i < 4 * StatisticManager::MaxShards; ++i)
+    std::thread([] { counter += 1; }).join();
+
+  ASSERT_EQ(theStatisticManager->getNumShards(), numShards);
+  ASSERT_EQ(counter.getValue() - before, 4 * StatisticManager::MaxShards);
+}
+
+TEST(StatisticsTest, ReleasesShardsOfOtherManagers) {
+  StatisticManager first, second;
+  std::thread([&] {
+    first.getIndex();
+    second.getIndex();
+    first.getIndex();
+  }).join();
+
+  // switching managers returned the shard of the first one
+  ASSERT_EQ(first.getNumShards(), 1u);
+  ASSERT_EQ(second.getNumShards(), 1u);
+}
+
+TEST(StatisticsTest, SharesLastShardBeyondMaxShards) {
+  const unsigned numThreads = StatisticManager::MaxShards + 16;
+  const std::uint64_t increments = 1000;
+  std::uint64_t before = counter.getValue();
+
+  Barrier started(numThreads), counted(numThreads);
+  std::mutex mutex;
+  unsigned numShared = 0;
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; ++t)
+    threads.emplace_back([&, increments] {
+      started.wait();
+      // threads on the shared shard cannot attribute values to an index
+      theStatisticManager->setIndex(1);
+      bool shared = theStatisticManager->getIndex() != 1;
+      for (std::uint64_t i = 0; i < increments; ++i)
+        counter += 1;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        numShared += shared;
+      }
+      counted.wait();
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  ASSERT_EQ(theStatisticManager->getNumShards(), StatisticManager::MaxShards);
+  ASSERT_GE(numShared, numThreads - (StatisticManager::MaxShards - 1));
+  ASSERT_EQ(counter.getValue() - before, increments * numThreads);
+}
+
+TEST(StatisticsTest, RegisterAfterUse) {
+  counter += 1;
+  ASSERT_DEATH({ Statistic late("TestLate", "TLate"); },
+               "registered after statistics were used");
+}
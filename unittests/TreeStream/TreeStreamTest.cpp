@@ -45,3 +45,42 @@ TEST(TreeStreamTest, WriteLargerThanBufferSize) {
   for (unsigned i = 0; i < out.size(); i++)
     ASSERT_EQ('A', out[i]);
 }
+
+/* Streams opened from another stream start with the data their parent had
+   at that point, also when writes of different streams interleave and span
+   several blocks. */
+TEST(TreeStreamTest, Forks) {
+  TreeStreamWriter tsw("tsw3.out");
+  ASSERT_TRUE(tsw.good());
+
+  TreeOStream root = tsw.open();
+  root << "1"
+       << "0";
+  TreeOStream child = tsw.open(root);
+  root << "abc";
+  child << "1";
+  std::string expectedRoot = "10abc", expectedChild = "101";
+  for (unsigned i = 0; i < 10000; ++i) {
+    std::string bit = i % 3 ? "1" : "0";
+    root << bit;
+    child << bit << bit;
+    expectedRoot += bit;
+    expectedChild += bit + bit;
+  }
+  TreeOStream grandchild = tsw.open(child);
+  child << "x";
+  grandchild << "0";
+  expectedChild += "x";
+  std::string expectedGrandchild =
+      expectedChild.substr(0, expectedChild.size() - 1) + "0";
+
+  std::vector<unsigned char> out;
+  tsw.readStream(root.getID(), out);
+  ASSERT_EQ(expectedRoot, std::string(out.begin(), out.end()));
+  out.clear();
+  tsw.readStream(child.getID(), out);
+  ASSERT_EQ(expectedChild, std::string(out.begin(), out.end()));
+  out.clear();
+  tsw.readStream(grandchild.getID(), out);
+  ASSERT_EQ(expectedGrandchild, std::string(out.begin(), out.end()));
+}